@@ -12,7 +12,7 @@ namespace vuk {
 
 	/// @brief Base class for high level execution
 	struct Executor {
-		enum class Type { eVulkanDeviceQueue, eThisThread } type;
+		enum class Type { eVulkanDeviceQueue, eThisThread, eThreadPool } type;
 		ExecutorTag tag;
 
 		Executor(Type type, DomainFlagBits domain, size_t executor_id) : type(type), tag{ domain, executor_id } {}
@@ -13,6 +13,8 @@
 #include <atomic>
 #include <deque>
 #include <function2/function2.hpp>
+#include <memory_resource>
+#include <mutex>
 #include <optional>
 #include <plf_colony.h>
 #include <shared_mutex>
@@ -267,7 +269,12 @@ namespace vuk {
 		SchedulingInfo(DomainFlags required_domains) : required_domains(required_domains) {}
 		SchedulingInfo(DomainFlagBits required_domain) : required_domains(required_domain) {}
 
+		// passes scheduled on the host are deferred: they run when the host work is submitted - before device work that depends on them is submitted, or at the end of the execution
 		DomainFlags required_domains;
+		// record the pass once and replay its command buffer while the callback, the bound resources (including image views) and the named pipelines stay the same
+		// the callback must record the same commands whenever it is called with the same arguments
+		// commands are cached per pass - a static subgraph is cached by marking each of its passes, the barriers between them are recorded every time
+		bool reuse_commands = false;
 	};
 
 	struct NodeDebugInfo {
@@ -286,6 +293,8 @@ namespace vuk {
 		RelSpan<ChainLink*> child_chains;
 		std::optional<ResourceUse> read_sync;  // optional, half sync to put resource into read
 		std::optional<ResourceUse> undef_sync; // optional, half sync to put resource into write
+		std::optional<ResourceUse> late_read_sync; // optional, if the reads were split: half sync for the reads from read_split onwards
+		uint32_t read_split = 0;                   // if the reads were split, reads before this index run first
 	};
 
 	struct ExecutionInfo;
@@ -493,7 +502,6 @@ namespace vuk {
 		Ref ref;
 		void* value;
 		bool is_ref;
-		bool owned = false;
 
 		static RefOrValue from_ref(Ref r) {
 			return { r, nullptr, true };
@@ -501,9 +509,6 @@ namespace vuk {
 		static RefOrValue from_value(void* v) {
 			return { {}, v, false };
 		}
-		static RefOrValue adopt_value(void* v) {
-			return { {}, v, false, true };
-		}
 	};
 
 	inline Result<RefOrValue, CannotBeConstantEvaluated> get_def(Ref ref) {
@@ -557,8 +562,8 @@ namespace vuk {
 		}
 	}
 
-	inline void* eval_binop(Node::BinOp op, const std::shared_ptr<Type>& t, void* a, void* b) {
-		auto result = (void*)new char[t->size];
+	// evaluates a binary op into caller-provided storage of t->size bytes
+	inline void eval_binop(Node::BinOp op, const std::shared_ptr<Type>& t, void* a, void* b, void* result) {
 		switch (op) {
 		case Node::BinOp::ADD: {
 			eval_with_type(
@@ -611,247 +616,240 @@ namespace vuk {
 			    b);
 		} break;
 		}
-		return result;
 	}
 
-	inline Result<RefOrValue, CannotBeConstantEvaluated> eval2(Ref ref) {
-		switch (ref.node->kind) {
-		case Node::CONSTANT: {
-			return { expected_value, RefOrValue::from_value(ref.node->constant.value) };
-		}
-		case Node::CONSTRUCT:
-		case Node::ACQUIRE_NEXT_IMAGE:
-		case Node::SLICE:
-			return { expected_value, RefOrValue::from_ref(ref) };
-		case Node::SPLICE:
-			if (!ref.node->splice.rel_acq || ref.node->splice.rel_acq->status == Signal::Status::eDisarmed) {
-				return eval2(ref.node->splice.src[ref.index]);
-			} else {
-				return { expected_value, RefOrValue::from_value(ref.node->splice.values[ref.index]) };
-			}
-		case Node::CALL: {
-			auto t = ref.type();
-			if (t->kind != Type::ALIASED_TY) {
-				return { expected_error, CannotBeConstantEvaluated{ ref } };
-			}
-			return eval2(ref.node->call.args[t->aliased.ref_idx]);
-		}
-		case Node::MATH_BINARY: {
-			auto& math_binary = ref.node->math_binary;
+	// memoizing constant evaluator
+	// subexpressions are evaluated once on an explicit stack, results of computations are allocated from the given allocator
+	// evaluated values are snapshots - an evaluator must not outlive changes to the values it read
+	struct ConstantEvaluator {
+		struct Entry {
+			RefOrValue result;
+			Ref failed; // if set, the evaluation failed on this ref
+			uint32_t epoch;
+			bool owned; // the value only depends on constants owned by the IR, and can't change until execution
+		};
 
-			auto a_ = eval2(math_binary.a);
-			if (!a_) {
-				return a_;
-			}
-			auto a_rov = *a_;
-			if (a_rov.is_ref) {
-				return { expected_error, CannotBeConstantEvaluated{ ref } };
-			}
-			auto a = a_rov.value;
+		ConstantEvaluator(std::pmr::polymorphic_allocator<std::byte> allocator) : allocator(allocator), memo(allocator), stack(allocator) {}
 
-			auto b_ = eval2(math_binary.b);
-			if (!b_) {
-				return b_;
-			}
-			auto b_rov = *b_;
-			if (b_rov.is_ref) {
-				return { expected_error, CannotBeConstantEvaluated{ ref } };
-			}
-			auto b = b_rov.value;
-			return { expected_value, RefOrValue::adopt_value(eval_binop(math_binary.op, ref.type(), a, b)) };
+		std::pmr::polymorphic_allocator<std::byte> allocator;
+		std::pmr::unordered_map<Ref, Entry> memo;
+		std::pmr::vector<Ref> stack;
+		uint32_t epoch = 0;
 
-		} break;
-		case Node::EXTRACT: {
-			auto composite_ = eval2(ref.node->extract.composite);
-			if (!composite_) {
-				return composite_;
-			}
-			auto composite = *composite_;
-			auto index_ = eval2(ref.node->extract.index);
-			if (!index_) {
-				return index_;
-			}
-			auto rov_index = *index_;
-			if (rov_index.is_ref) {
-				return { expected_error, CannotBeConstantEvaluated{ ref } };
-			}
-			auto index = *(uint64_t*)rov_index.value;
-			auto type = ref.node->extract.composite.type();
+		// placeholders were resolved - failed evaluations must be retried
+		void invalidate_failures() {
+			epoch++;
+		}
 
-			if (composite.is_ref) {
-				if (composite.ref.node->kind == Node::CONSTRUCT) {
-					return eval2(composite.ref.node->construct.args[index + 1]);
-				} else if (composite.ref.node->kind == Node::ACQUIRE_NEXT_IMAGE) {
-					auto swp_ = get_def(composite.ref.node->acquire_next_image.swapchain);
-					if (!swp_) {
-						return swp_;
-					}
-					auto swp = *swp_;
-					if (swp.is_ref && swp.ref.node->kind == Node::CONSTRUCT) {
-						auto arr = swp.ref.node->construct.args[1]; // array of images
-						if (arr.node->kind == Node::CONSTRUCT) {
-							auto elem = arr.node->construct.args[1]; // first image
-							if (elem.node->kind == Node::CONSTRUCT) {
-								return eval2(elem.node->construct.args[index + 1]);
-							}
-						}
-					} else {
-						return { expected_error, CannotBeConstantEvaluated{ ref } };
-					}
-				} else if (composite.ref.node->kind == Node::SLICE) {
-					auto slice_def_ = get_def(composite.ref.node->slice.image);
-					if (!slice_def_) {
-						return slice_def_;
-					}
-					auto slice_def = *slice_def_;
-					if (!slice_def.is_ref || slice_def.ref.node->kind != Node::CONSTRUCT) {
-						return { expected_error, CannotBeConstantEvaluated{ ref } }; // TODO: this too limited
-					}
-					if (index < 6) {
-						return eval2(slice_def.ref.node->construct.args[index + 1]);
-					} else {
-						assert(false && "NYI");
-					}
-				} else {
-					return { expected_error, CannotBeConstantEvaluated{ ref } };
+		Result<RefOrValue, CannotBeConstantEvaluated> evaluate(Ref ref) {
+			stack.push_back(ref);
+			while (!stack.empty()) {
+				auto top = stack.back();
+				if (lookup(top)) {
+					stack.pop_back();
+					continue;
 				}
-			} else {
-				if (type->kind == Type::COMPOSITE_TY) {
-					auto offset = type->offsets[index];
-					return { expected_value, RefOrValue::from_value((reinterpret_cast<void*>(static_cast<unsigned char*>(composite.value) + offset))) };
-				} else if (type->kind == Type::ARRAY_TY) {
-					auto offset = type->array.stride * index;
-					return { expected_value, RefOrValue::from_value((reinterpret_cast<void*>(static_cast<unsigned char*>(composite.value) + offset))) };
+				auto operand = step(top);
+				if (operand) {
+					stack.push_back(operand);
 				} else {
-					return { expected_error, CannotBeConstantEvaluated{ ref } };
+					stack.pop_back();
 				}
 			}
 
-			return { expected_error, CannotBeConstantEvaluated{ ref } };
+			auto& entry = *lookup(ref);
+			if (entry.failed) {
+				return { expected_error, CannotBeConstantEvaluated{ entry.failed } };
+			}
+			return { expected_value, entry.result };
 		}
-		default:
-			return { expected_error, CannotBeConstantEvaluated{ ref } };
+
+		template<class T>
+		Result<T, CannotBeConstantEvaluated> eval(Ref ref) {
+			auto rov_ = evaluate(ref);
+			if (!rov_) {
+				return rov_;
+			}
+			if (rov_->is_ref) {
+				return { expected_error, CannotBeConstantEvaluated{ ref } };
+			}
+			return { expected_value, *reinterpret_cast<T*>(rov_->value) };
 		}
-		assert(0);
-	}
 
-	template<class T>
-	  requires(!std::is_pointer_v<T>)
-	Result<T, CannotBeConstantEvaluated> eval(Ref ref) {
-		switch (ref.node->kind) {
-		case Node::CONSTANT: {
-			return { expected_value, constant<T>(ref) };
+		// must be called after a successful evaluate(ref)
+		bool is_owned(Ref ref) {
+			return lookup(ref)->owned;
 		}
-		case Node::MATH_BINARY: {
-			if constexpr (std::is_arithmetic_v<T>) {
+
+	private:
+		const Entry* lookup(Ref ref) {
+			auto it = memo.find(ref);
+			if (it == memo.end() || (it->second.failed && it->second.epoch != epoch)) {
+				return nullptr;
+			}
+			return &it->second;
+		}
+
+		// evaluate a single node if all of its operands are known
+		// otherwise return the operand that needs to be evaluated first
+		Ref step(Ref ref) {
+			auto done = [&](RefOrValue rov, bool owned) {
+				memo[ref] = Entry{ rov, {}, epoch, owned };
+				return Ref{};
+			};
+			auto fail = [&](Ref failed) {
+				memo[ref] = Entry{ {}, failed, epoch, false };
+				return Ref{};
+			};
+			// the value of ref is the value of operand - which is only fixed if the path to it (owned) is fixed too
+			auto forward = [&](Ref operand, bool owned = true) {
+				auto entry = lookup(operand);
+				if (!entry) {
+					return operand;
+				}
+				Entry forwarded = *entry;
+				forwarded.owned = forwarded.owned && owned;
+				memo[ref] = forwarded;
+				return Ref{};
+			};
+
+			switch (ref.node->kind) {
+			case Node::CONSTANT:
+				return done(RefOrValue::from_value(ref.node->constant.value), ref.node->constant.owned);
+			case Node::CONSTRUCT:
+			case Node::ACQUIRE_NEXT_IMAGE:
+			case Node::SLICE:
+				return done(RefOrValue::from_ref(ref), false);
+			case Node::SPLICE:
+				if (!ref.node->splice.rel_acq || ref.node->splice.rel_acq->status == Signal::Status::eDisarmed) {
+					return forward(ref.node->splice.src[ref.index]);
+				}
+				return done(RefOrValue::from_value(ref.node->splice.values[ref.index]), false);
+			case Node::CALL: {
+				auto t = ref.type();
+				if (t->kind != Type::ALIASED_TY) {
+					return fail(ref);
+				}
+				return forward(ref.node->call.args[t->aliased.ref_idx]);
+			}
+			case Node::CAST: // reinterpretation, the value is unchanged
+				return forward(ref.node->cast.src);
+			case Node::MATH_BINARY: {
 				auto& math_binary = ref.node->math_binary;
-				switch (math_binary.op) {
-#define UNWRAP_A(val)                                                                                                                                          \
-	auto a_ = eval<T>(val);                                                                                                                                      \
-	if (!a_) {                                                                                                                                                   \
-		return a_;                                                                                                                                                 \
-	}                                                                                                                                                            \
-	auto a = *a_;
-#define UNWRAP_B(val)                                                                                                                                          \
-	auto b_ = eval<T>(val);                                                                                                                                      \
-	if (!b_) {                                                                                                                                                   \
-		return b_;                                                                                                                                                 \
-	}                                                                                                                                                            \
-	auto b = *b_;
-				case Node::BinOp::ADD: {
-					UNWRAP_A(math_binary.a)
-					UNWRAP_B(math_binary.b)
-					return { expected_value, a + b };
+				auto a = lookup(math_binary.a);
+				if (!a) {
+					return math_binary.a;
 				}
-				case Node::BinOp::SUB: {
-					UNWRAP_A(math_binary.a)
-					UNWRAP_B(math_binary.b)
-					return { expected_value, a - b };
+				if (a->failed) {
+					return fail(a->failed);
 				}
-				case Node::BinOp::MUL: {
-					UNWRAP_A(math_binary.a)
-					UNWRAP_B(math_binary.b)
-					return { expected_value, a * b };
+				if (a->result.is_ref) {
+					return fail(ref);
 				}
-				case Node::BinOp::DIV: {
-					UNWRAP_A(math_binary.a)
-					UNWRAP_B(math_binary.b)
-					return { expected_value, a / b };
+				auto b = lookup(math_binary.b);
+				if (!b) {
+					return math_binary.b;
 				}
-				case Node::BinOp::MOD: {
-					UNWRAP_A(math_binary.a)
-					UNWRAP_B(math_binary.b)
-					return { expected_value, a % b };
+				if (b->failed) {
+					return fail(b->failed);
 				}
+				if (b->result.is_ref) {
+					return fail(ref);
 				}
-			}
-			assert(0);
-		}
-
-		case Node::EXTRACT: {
-			auto composite_ = get_def(ref);
-			if (!composite_) {
-				return composite_;
-			}
-			auto composite = *composite_;
-			auto index_ = eval<uint64_t>(ref.node->extract.index);
-			if (!index_) {
-				return index_;
-			}
-			auto index = *index_;
-			auto type = ref.node->extract.composite.type();
-			if (composite.is_ref) {
-				if (composite.ref.node->kind == Node::CONSTRUCT) {
-					return eval<T>(composite.ref.node->construct.args[index + 1]);
-				} else if (composite.ref.node->kind == Node::ACQUIRE_NEXT_IMAGE) {
-					auto swp_ = get_def(composite.ref.node->acquire_next_image.swapchain);
-					if (!swp_) {
-						return swp_;
-					}
-					auto swp = *swp_;
-					if (swp.is_ref && swp.ref.node->kind == Node::CONSTRUCT) {
-						auto arr = swp.ref.node->construct.args[1]; // array of images
-						if (arr.node->kind == Node::CONSTRUCT) {
-							auto elem = arr.node->construct.args[1]; // first image
-							if (elem.node->kind == Node::CONSTRUCT) {
-								return eval<T>(elem.node->construct.args[index + 1]);
+				auto result = allocator.allocate_bytes(ref.type()->size, alignof(std::max_align_t));
+				eval_binop(math_binary.op, ref.type(), a->result.value, b->result.value, result);
+				return done(RefOrValue::from_value(result), a->owned && b->owned);
+			}
+			case Node::EXTRACT: {
+				auto& extract = ref.node->extract;
+				auto composite_ = lookup(extract.composite);
+				if (!composite_) {
+					return extract.composite;
+				}
+				if (composite_->failed) {
+					return fail(composite_->failed);
+				}
+				auto index_ = lookup(extract.index);
+				if (!index_) {
+					return extract.index;
+				}
+				if (index_->failed) {
+					return fail(index_->failed);
+				}
+				if (index_->result.is_ref) {
+					return fail(ref);
+				}
+				auto& composite = composite_->result;
+				auto index = *(uint64_t*)index_->result.value;
+				auto type = extract.composite.type();
+
+				if (composite.is_ref) {
+					if (composite.ref.node->kind == Node::CONSTRUCT) {
+						return forward(composite.ref.node->construct.args[index + 1], index_->owned);
+					} else if (composite.ref.node->kind == Node::ACQUIRE_NEXT_IMAGE) {
+						auto swp_ = get_def(composite.ref.node->acquire_next_image.swapchain);
+						if (!swp_) {
+							return fail(swp_.error().ref);
+						}
+						auto swp = *swp_;
+						if (swp.is_ref && swp.ref.node->kind == Node::CONSTRUCT) {
+							auto arr = swp.ref.node->construct.args[1]; // array of images
+							if (arr.node->kind == Node::CONSTRUCT) {
+								auto elem = arr.node->construct.args[1]; // first image
+								if (elem.node->kind == Node::CONSTRUCT) {
+									return forward(elem.node->construct.args[index + 1], index_->owned);
+								}
 							}
 						}
-					} else {
-						return { expected_error, CannotBeConstantEvaluated{ ref } };
-					}
-				} else if (composite.ref.node->kind == Node::SLICE) {
-					auto slice_def_ = get_def(composite.ref.node->slice.image);
-					if (!slice_def_) {
-						return slice_def_;
-					}
-					auto slice_def = *slice_def_;
-					if (!slice_def.is_ref || slice_def.ref.node->kind != Node::CONSTRUCT) {
-						return { expected_error, CannotBeConstantEvaluated{ ref } }; // TODO: this too limited
-					}
-					if (index < 6) {
-						return eval<T>(slice_def.ref.node->construct.args[index + 1]);
-					} else {
-						assert(false && "NYI");
+						return fail(ref);
+					} else if (composite.ref.node->kind == Node::SLICE) {
+						auto& slice = composite.ref.node->slice;
+						// base_layer, layer_count, base_level and level_count of the sliced range are the arguments of the slice
+						// the remainder of a slice is not a single range
+						if (index >= 5) {
+							if (composite.ref.index != 0) {
+								return fail(ref);
+							}
+							Ref range[] = { slice.base_layer, slice.layer_count, slice.base_level, slice.level_count };
+							return forward(range[index - 5], index_->owned);
+						}
+						// the rest is shared with the sliced image
+						auto slice_def_ = get_def(slice.image);
+						if (!slice_def_) {
+							return fail(slice_def_.error().ref);
+						}
+						auto slice_def = *slice_def_;
+						if (!slice_def.is_ref || slice_def.ref.node->kind != Node::CONSTRUCT) {
+							return fail(ref); // TODO: this too limited
+						}
+						return forward(slice_def.ref.node->construct.args[index + 1], index_->owned);
 					}
+					return fail(ref);
 				} else {
-					return { expected_error, CannotBeConstantEvaluated{ ref } };
-				}
-			} else {
-				if (type->kind == Type::COMPOSITE_TY) {
-					auto offset = type->offsets[index];
-					return { expected_value, *static_cast<T*>(reinterpret_cast<void*>(static_cast<unsigned char*>(composite.value) + offset)) };
-				} else if (type->kind == Type::ARRAY_TY) {
-					auto offset = type->array.stride * index;
-					return { expected_value, *static_cast<T*>(reinterpret_cast<void*>(static_cast<unsigned char*>(composite.value) + offset)) };
-				} else {
-					return { expected_error, CannotBeConstantEvaluated{ ref } };
+					if (type->kind == Type::COMPOSITE_TY) {
+						auto offset = type->offsets[index];
+						return done(RefOrValue::from_value(static_cast<unsigned char*>(composite.value) + offset), composite_->owned && index_->owned);
+					} else if (type->kind == Type::ARRAY_TY) {
+						auto offset = type->array.stride * index;
+						return done(RefOrValue::from_value(static_cast<unsigned char*>(composite.value) + offset), composite_->owned && index_->owned);
+					}
+					return fail(ref);
 				}
 			}
+			default:
+				return fail(ref);
+			}
 		}
-		default:
-			return { expected_error, CannotBeConstantEvaluated{ ref } };
-		}
+	};
+
+	// one-shot evaluation of a single value, intermediate results live on the stack unless the expression is large
+	template<class T>
+	  requires(!std::is_pointer_v<T>)
+	Result<T, CannotBeConstantEvaluated> eval(Ref ref) {
+		std::byte buffer[1024];
+		std::pmr::monotonic_buffer_resource resource(buffer, sizeof(buffer));
+		ConstantEvaluator evaluator(&resource);
+		return evaluator.eval<T>(ref);
 	}
 
 	template<class T>
@@ -1083,7 +1081,15 @@ namespace vuk {
 	}
 
 	struct IRModule {
-		IRModule() : op_arena(/**/), module_id(module_id_counter++) {}
+		IRModule() : op_arena(/**/), module_id(module_id_counter++) {
+			std::scoped_lock _(registry_lock);
+			registry.emplace(module_id, this);
+		}
+
+		~IRModule() {
+			std::scoped_lock _(registry_lock);
+			registry.erase(module_id);
+		}
 
 		plf::colony<Node /*, inline_alloc<Node, 4 * 1024>*/> op_arena;
 		std::vector<Node*> garbage;
@@ -1092,6 +1098,59 @@ namespace vuk {
 		size_t module_id = 0;
 		inline static std::atomic<size_t> module_id_counter;
 
+		// live modules by id, to find the module owning a node
+		inline static std::mutex registry_lock;
+		inline static std::unordered_map<size_t, IRModule*> registry;
+
+		// generation of the module contents, bumped on every mutation of its nodes
+		// GC and implicit linking are skipped for modules that have not changed since they last ran
+		std::atomic<size_t> generation = 0;
+		size_t linked_generation = ~0ULL;
+		// a module is collected and linked at least once every max_cached_compiles compiles it takes part in
+		static constexpr size_t max_cached_compiles = 64;
+		size_t cached_compiles = 0;
+
+		// storage for the values of owned constants, shared by all modules
+		// the pool keeps the storage of destroyed constants for the next ones, so folding does not go to the heap every compile
+		inline static std::pmr::synchronized_pool_resource constant_storage;
+
+		static void* allocate_constant(size_t size) {
+			return constant_storage.allocate(size, alignof(std::max_align_t));
+		}
+
+		static void deallocate_constant(void* value, size_t size) {
+			constant_storage.deallocate(value, size, alignof(std::max_align_t));
+		}
+
+		void touch() {
+			generation++;
+		}
+
+		// record a mutation of node in the module owning it
+		void touch(Node* node) {
+			if ((node->index >> 32) == module_id) {
+				generation++;
+			} else {
+				touch_owner(node);
+			}
+		}
+
+		static void touch_owner(Node* node) {
+			std::scoped_lock _(registry_lock);
+			if (auto it = registry.find(node->index >> 32); it != registry.end()) {
+				it->second->generation++;
+			}
+		}
+
+		bool is_linked() const {
+			return generation == linked_generation;
+		}
+
+		void mark_linked() {
+			linked_generation = generation;
+			cached_compiles = 0;
+		}
+
 		struct Types {
 			std::unordered_map<Type::Hash, std::weak_ptr<Type>> type_map;
 			plf::colony<UserCallbackType> ucbs;
@@ -1380,6 +1439,7 @@ namespace vuk {
 		} types;
 
 		Node* emplace_op(Node v) {
+			generation++;
 			v.index = module_id << 32 | node_counter++;
 			return &*op_arena.emplace(std::move(v));
 		}
@@ -1420,7 +1480,7 @@ namespace vuk {
 			switch (node->kind) {
 			case Node::CONSTANT: {
 				if (node->constant.owned) {
-					delete[] (char*)node->constant.value;
+					deallocate_constant(node->constant.value, node->type[0]->size);
 				}
 				break;
 			}
@@ -1454,8 +1514,10 @@ namespace vuk {
 				delete node->debug_info;
 			}
 
+			// nodes of other modules are only marked, their module collects them
 			auto it = op_arena.get_iterator(node);
 			if (it != op_arena.end()) {
+				generation++;
 #ifdef VUK_GARBAGE_SAN
 				node->kind = Node::GARBAGE;
 				node->generic_node.arg_count = 0;
@@ -1467,6 +1529,7 @@ namespace vuk {
 				node->kind = Node::GARBAGE;
 				node->generic_node.arg_count = 0;
 				node->type = {};
+				touch_owner(node);
 			}
 			return {};
 		}
@@ -1483,8 +1546,9 @@ namespace vuk {
 			} else {
 				ty = new std::shared_ptr<Type>[1]{ types.memory(sizeof(T)) };
 			}
-			return first(
-			    emplace_op(Node{ .kind = Node::CONSTANT, .type = std::span{ ty, 1 }, .constant = { .value = new (new char[sizeof(T)]) T(value), .owned = true } }));
+			assert((*ty)->size == sizeof(T));
+			return first(emplace_op(
+			    Node{ .kind = Node::CONSTANT, .type = std::span{ ty, 1 }, .constant = { .value = new (allocate_constant(sizeof(T))) T(value), .owned = true } }));
 		}
 
 		template<class T>
@@ -1500,8 +1564,16 @@ namespace vuk {
 			return first(emplace_op(Node{ .kind = Node::CONSTANT, .type = std::span{ ty, 1 }, .constant = { .value = value, .owned = false } }));
 		}
 
+		// makes an owned copy of value, which must be type->size bytes
+		Ref make_constant(std::shared_ptr<Type> type, const void* value) {
+			auto storage = allocate_constant(type->size);
+			memcpy(storage, value, type->size);
+			auto ty = new std::shared_ptr<Type>[1]{ type };
+			return first(emplace_op(Node{ .kind = Node::CONSTANT, .type = std::span{ ty, 1 }, .constant = { .value = storage, .owned = true } }));
+		}
+
 		Ref make_declare_image(ImageAttachment value) {
-			auto ptr = new (new char[sizeof(ImageAttachment)])
+			auto ptr = new (allocate_constant(sizeof(ImageAttachment)))
 			    ImageAttachment(value); /* rest extent_x extent_y extent_z format samples base_layer layer_count base_level level_count */
 			auto args_ptr = new Ref[10];
 			auto mem_ty = new std::shared_ptr<Type>[1]{ types.memory(sizeof(ImageAttachment)) };
@@ -1560,7 +1632,7 @@ namespace vuk {
 		}
 
 		Ref make_declare_buffer(Buffer value) {
-			auto buf_ptr = new (new char[sizeof(Buffer)]) Buffer(value); /* rest size */
+			auto buf_ptr = new (allocate_constant(sizeof(Buffer))) Buffer(value); /* rest size */
 			auto args_ptr = new Ref[2];
 			auto mem_ty = new std::shared_ptr<Type>[1]{ types.memory(sizeof(Buffer)) };
 			args_ptr[0] = first(emplace_op(Node{ .kind = Node::CONSTANT, .type = std::span{ mem_ty, 1 }, .constant = { .value = buf_ptr, .owned = true } }));
@@ -1585,7 +1657,7 @@ namespace vuk {
 		}
 
 		Ref make_declare_swapchain(Swapchain& bundle) {
-			auto swpptr = new void*(&bundle);
+			auto swpptr = new (allocate_constant(sizeof(Swapchain*))) void*(&bundle);
 			auto args_ptr = new Ref[2];
 			auto mem_ty = new std::shared_ptr<Type>[1]{ types.memory(sizeof(Swapchain*)) };
 			args_ptr[0] = first(emplace_op(Node{ .kind = Node::CONSTANT, .type = std::span{ mem_ty, 1 }, .constant = { .value = swpptr, .owned = true } }));
@@ -1809,6 +1881,7 @@ namespace vuk {
 				assert(node->kind == Node::SPLICE);
 
 				node->splice.held = false;
+				source_module->touch(node);
 			}
 		}
 
@@ -1822,6 +1895,7 @@ namespace vuk {
 
 		void mutate(Node* new_node) {
 			current_module->garbage.push_back(node);
+			current_module->touch(node);
 			assert(node->kind == Node::SPLICE);
 			node->splice.rel_acq = nullptr;
 			node = current_module->make_splice(new_node, acqrel);
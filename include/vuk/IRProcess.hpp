@@ -2,11 +2,16 @@
 
 #include "vuk/IR.hpp"
 #include "vuk/RelSpan.hpp"
+#include "vuk/RenderGraph.hpp"
 #include "vuk/ShortAlloc.hpp"
 #include "vuk/SourceLocation.hpp"
+#include "vuk/Trace.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <deque>
 #include <memory_resource>
+#include <optional>
 #include <robin_hood.h>
 #include <gch/small_vector.hpp>
 
@@ -19,7 +24,7 @@ namespace vuk {
 		DomainFlagBits scheduled_domain;
 		Stream* scheduled_stream;
 
-		bool ready = false; // for DYNAMO
+		bool ready = false; // all dependencies have run
 	};
 
 	struct ExecutionInfo {
@@ -28,34 +33,123 @@ namespace vuk {
 		std::span<void*> values;
 	};
 
+	// forwards to upstream, counting the allocations that reach it
+	struct CountingResource : std::pmr::memory_resource {
+		CountingResource(std::pmr::memory_resource* upstream) : upstream(upstream) {}
+
+		std::pmr::memory_resource* upstream;
+		size_t allocations = 0;
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override {
+			allocations++;
+			return upstream->allocate(bytes, alignment);
+		}
+		void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+			upstream->deallocate(p, bytes, alignment);
+		}
+		bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override {
+			return this == &o;
+		}
+	};
+
+	// monotonic allocation from storage that is retained across compiles
+	// the storage grows to fit the peak usage, and is trimmed after trim_after compiles using less than a quarter of it
+	struct RetainedMonotonicResource : std::pmr::memory_resource {
+		static constexpr size_t min_size = 64 * 1024;
+		static constexpr size_t trim_after = 64;
+
+		RetainedMonotonicResource(std::pmr::memory_resource* upstream) : upstream(upstream) {
+			recycle();
+		}
+
+		// sizes the storage for the next compile from the usage since the last recycle
+		// new storage is allocated here, so that the next compile starts without going to the heap
+		void prepare();
+		// invalidates every allocation made since the last recycle
+		void recycle();
+
+		std::pmr::memory_resource* upstream;
+		std::unique_ptr<std::byte[]> storage;
+		size_t storage_size = 0;
+		std::unique_ptr<std::byte[]> next_storage; // storage for the next compile, if it changes size
+		size_t next_storage_size = 0;
+		bool prepared = false;
+		size_t used = 0;               // bytes requested since the last recycle
+		size_t low_usage_compiles = 0; // consecutive recycles that used less than a quarter of the storage
+		size_t storage_allocations = 0; // times the storage was (re)allocated
+		std::optional<std::pmr::monotonic_buffer_resource> mbr;
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override {
+			used += bytes + alignment - 1;
+			return mbr->allocate(bytes, alignment);
+		}
+		void do_deallocate(void* p, size_t bytes, size_t alignment) override {}
+		bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override {
+			return this == &o;
+		}
+	};
+
 #define INIT(x) x(decltype(x)::allocator_type(*arena_))
 
 	struct RGCImpl {
 		RGCImpl() :
 		    arena_(new arena(4 * 1024 * 1024)),
-		    pool(std::make_unique<std::pmr::unsynchronized_pool_resource>()),
-		    mbr(pool.get()) {}
-		RGCImpl(arena* a, std::unique_ptr<std::pmr::unsynchronized_pool_resource> pool) : arena_(a), pool(std::move(pool)), mbr(this->pool.get()) {}
+		    heap(std::pmr::new_delete_resource()),
+		    pool(std::make_unique<std::pmr::unsynchronized_pool_resource>(&heap)),
+		    mbr(pool.get()),
+		    partitioned_execables(pool.get()),
+		    pass_reads(pool.get()),
+		    pass_nops(pool.get()),
+		    refs(pool.get()),
+		    ref_nodes(pool.get()),
+		    depnodes(pool.get()),
+		    nodes(pool.get()),
+		    garbage_nodes(pool.get()),
+		    chains(pool.get()),
+		    modules(pool.get()),
+		    child_chains(pool.get()),
+		    deferred_splices(&mbr),
+		    pending_splice_sigs(&mbr) {}
 		std::unique_ptr<arena> arena_;
+		CountingResource heap; // upstream of the pmr storage, see CompileStats::heap_allocations
 		std::unique_ptr<std::pmr::unsynchronized_pool_resource> pool;
-		std::pmr::monotonic_buffer_resource mbr;
+		RetainedMonotonicResource mbr;
+
+		// drop the state of the previous compile, keeping the capacity of the containers
+		void reset();
 
-		plf::colony<ScheduledItem> scheduled_execables;
-		std::vector<ScheduledItem*> partitioned_execables;
+		// the containers live in the pool, which keeps the storage they let go of for the next compile
+		plf::colony<ScheduledItem> scheduled_execables; // clearing keeps the memory blocks
+		std::pmr::vector<ScheduledItem*> partitioned_execables;
 
 		std::pmr::vector<Ref> pass_reads;
 		std::pmr::vector<Ref> pass_nops;
 
-		std::vector<std::shared_ptr<ExtNode>> refs;
-		std::vector<Node*> ref_nodes;
-		std::vector<std::shared_ptr<ExtNode>> depnodes;
-		std::vector<Node*> nodes;
-		std::vector<Node*> garbage_nodes;
-		std::vector<ChainLink*> chains;
+		std::pmr::vector<std::shared_ptr<ExtNode>> refs;
+		std::pmr::vector<Node*> ref_nodes;
+		std::pmr::vector<std::shared_ptr<ExtNode>> depnodes;
+		std::pmr::vector<Node*> nodes;
+		std::pmr::vector<Node*> garbage_nodes;
+		std::pmr::vector<ChainLink*> chains;
+		std::pmr::vector<IRModule*> modules; // modules taking part in the compilation, sorted by id
 		std::pmr::vector<ChainLink*> child_chains;
 
-		std::unordered_map<Node*, std::vector<Ref>> deferred_splices; // Node: the node that needs to signal the splice, Ref: ref to a splice result
-		std::unordered_map<Node*, size_t> pending_splice_sigs;        // Node: splice node, size_t: number of splice srcs that have been processed
+		struct DeferredSplice {
+			Node* signaller; // the node that needs to signal the splice
+			Ref splice;      // ref to a splice result, cleared once signalled
+			uint32_t slot;   // dense index of the splice node into pending_splice_sigs
+		};
+		std::pmr::vector<DeferredSplice> deferred_splices; // sorted by signaller after compilation
+		std::pmr::vector<uint32_t> pending_splice_sigs;    // number of splice srcs that have been processed, by splice slot
+
+		std::span<DeferredSplice> get_deferred_splices(Node* signaller) {
+			auto [first, last] = std::equal_range(deferred_splices.begin(), deferred_splices.end(), DeferredSplice{ signaller }, [](auto& a, auto& b) {
+				return a.signaller < b.signaller;
+			});
+			return { first, last };
+		}
 
 		std::span<ScheduledItem*> transfer_passes, compute_passes, graphics_passes;
 
@@ -92,6 +186,17 @@ namespace vuk {
 			return nullptr;
 		}
 
+		// record a mutation of node in the module owning it
+		void touch(Node* node) {
+			auto module_id = node->index >> 32;
+			auto it = std::lower_bound(modules.begin(), modules.end(), module_id, [](IRModule* m, size_t id) { return m->module_id < id; });
+			if (it != modules.end() && (*it)->module_id == module_id) {
+				(*it)->touch();
+			} else {
+				IRModule::touch_owner(node);
+			}
+		}
+
 		std::span<void*> get_values(Node* node) {
 			assert(node->execution_info);
 			return node->execution_info->values;
@@ -107,7 +212,7 @@ namespace vuk {
 		                        bool do_ssa);
 
 		Result<void> build_nodes();
-		Result<void> build_links(std::vector<Node*>& working_set, std::pmr::polymorphic_allocator<std::byte> allocator);
+		Result<void> build_links(std::pmr::vector<Node*>& working_set, std::pmr::polymorphic_allocator<std::byte> allocator);
 		template<class It>
 		Result<void> build_links(IRModule* module,
 		                         It start,
@@ -118,15 +223,37 @@ namespace vuk {
 		                         std::pmr::polymorphic_allocator<std::byte> allocator);
 		Result<void> implicit_linking(IRModule* module, std::pmr::polymorphic_allocator<std::byte> allocator);
 		Result<void> build_sync();
+		bool split_reads(ChainLink& link);
 		Result<void> reify_inference();
 		Result<void> collect_chains();
 
 		ImageUsageFlags compute_usage(const ChainLink* head);
 
 		ProfilingCallbacks callbacks;
+		ReadLayoutPolicy read_layout_policy = ReadLayoutPolicy::eMerge;
+		RecordingTaskRunner* recording_task_runner = nullptr;
+		CompileStats stats;
+		ExecuteStats execute_stats;
+		// kept across compiles, the commands of reusable passes replay from it
+		std::shared_ptr<struct CommandBufferCache> command_buffer_cache;
 	};
 #undef INIT
 
+	// accumulates the time spent in scope into a compile phase
+	struct PhaseTimer {
+		PhaseTimer(CompileStats::Phase& phase, const char* name) : phase(phase), start(std::chrono::steady_clock::now()), scope(TraceCategory::eCompile, name) {}
+		~PhaseTimer() {
+			phase.duration += std::chrono::steady_clock::now() - start;
+		}
+
+		PhaseTimer(const PhaseTimer&) = delete;
+		PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+		CompileStats::Phase& phase;
+		std::chrono::steady_clock::time_point start;
+		TraceScope scope;
+	};
+
 	template<class T, class A, class F>
 	T* contains_if(std::vector<T, A>& v, F&& f) {
 		auto it = std::find_if(v.begin(), v.end(), f);
@@ -236,6 +363,72 @@ namespace vuk {
 		}
 	};
 
+	// byte ranges: VK_WHOLE_SIZE (or an overflowing size) extends to the end of the allocation
+	inline uint64_t range_end(Subrange::Buffer a) {
+		return (a.size == VK_WHOLE_SIZE || a.offset + a.size < a.offset) ? VK_WHOLE_SIZE : a.offset + a.size;
+	}
+
+	inline Subrange::Buffer make_byte_range(uint64_t begin, uint64_t end) {
+		return { .offset = begin, .size = end == VK_WHOLE_SIZE ? VK_WHOLE_SIZE : end - begin };
+	}
+
+	inline std::optional<Subrange::Buffer> intersect_one(Subrange::Buffer a, Subrange::Buffer b) {
+		uint64_t begin = std::max(a.offset, b.offset);
+		uint64_t end = std::min(range_end(a), range_end(b));
+		if (end <= begin) {
+			return {};
+		}
+		return make_byte_range(begin, end);
+	}
+
+	template<class F>
+	void difference_one(Subrange::Buffer a, Subrange::Buffer isection, F&& func) {
+		if (!intersect_one(a, isection)) {
+			func(a);
+			return;
+		}
+		// before
+		if (isection.offset > a.offset) {
+			func(make_byte_range(a.offset, isection.offset));
+		}
+		// after
+		if (range_end(a) > range_end(isection)) {
+			func(make_byte_range(range_end(isection), range_end(a)));
+		}
+	}
+
+	// the union of two disjoint ranges, if it is a single range
+	inline std::optional<Subrange::Image> merge_one(Subrange::Image a, Subrange::Image b) {
+		if (a.base_layer == b.base_layer && a.layer_count == b.layer_count) {
+			if (b.base_level < a.base_level) {
+				std::swap(a, b);
+			}
+			if (a.level_count != VK_REMAINING_MIP_LEVELS && a.base_level + (int64_t)a.level_count == b.base_level) {
+				a.level_count = b.level_count == VK_REMAINING_MIP_LEVELS ? VK_REMAINING_MIP_LEVELS : a.level_count + b.level_count;
+				return a;
+			}
+		} else if (a.base_level == b.base_level && a.level_count == b.level_count) {
+			if (b.base_layer < a.base_layer) {
+				std::swap(a, b);
+			}
+			if (a.layer_count != VK_REMAINING_ARRAY_LAYERS && a.base_layer + (int64_t)a.layer_count == b.base_layer) {
+				a.layer_count = b.layer_count == VK_REMAINING_ARRAY_LAYERS ? VK_REMAINING_ARRAY_LAYERS : a.layer_count + b.layer_count;
+				return a;
+			}
+		}
+		return {};
+	}
+
+	inline std::optional<Subrange::Buffer> merge_one(Subrange::Buffer a, Subrange::Buffer b) {
+		if (b.offset < a.offset) {
+			std::swap(a, b);
+		}
+		if (range_end(a) == VK_WHOLE_SIZE || range_end(a) != b.offset) {
+			return {};
+		}
+		return make_byte_range(a.offset, range_end(b));
+	}
+
 	struct MultiSubrange {
 		static MultiSubrange all() {
 			MultiSubrange msr;
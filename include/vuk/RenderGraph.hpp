@@ -629,6 +629,46 @@ public:
 		return std::move(in).as_released<void>(Access::ePresent, DomainFlagBits::ePE);
 	}
 
+	/// @brief Synchronization generated by the last execution
+	struct ExecuteStats {
+		struct LayoutTransition {
+			ImageLayout old_layout;
+			ImageLayout new_layout;
+			size_t count = 0;
+		};
+
+		struct Queue {
+			DomainFlagBits domain;
+			size_t submits = 0;            // queue submissions
+			size_t submit_infos = 0;       // entries of the submitted batches
+			size_t command_buffers = 0;    // command buffers in the submitted batches
+			size_t semaphore_waits = 0;    // timeline semaphore waits
+			size_t semaphore_signals = 0;  // timeline semaphore signals
+			size_t presentation_waits = 0; // binary semaphore waits on acquired swapchain images
+		};
+
+		size_t barrier_flushes = 0;  // pipeline barrier commands recorded
+		size_t image_barriers = 0;
+		size_t buffer_barriers = 0;
+		size_t memory_barriers = 0;
+		size_t queue_ownership_transfers = 0; // image barriers between queue families, the release and the acquire each count
+		size_t synchronized_ranges = 0;       // resource subranges synchronized against their previous use
+		size_t stream_dependencies = 0;       // dependencies added between streams
+		size_t replayed_command_buffers = 0;  // passes marked to reuse commands that replayed a cached command buffer
+		size_t recorded_command_buffers = 0;  // passes marked to reuse commands that had to be recorded
+		size_t render_pass_cache_hits = 0;    // render passes whose render pass and framebuffer were found in the runtime cache
+		size_t render_pass_cache_misses = 0;  // render passes whose render pass and framebuffer were created
+		size_t avoided_loads = 0;             // attachments with undefined contents using LOAD_OP_DONT_CARE
+		size_t avoided_stores = 0;            // attachments without later uses using STORE_OP_DONT_CARE
+		size_t merged_barriers = 0;           // barriers merged into another barrier of their batch, over the same or an adjacent range
+		size_t redundant_barriers = 0;        // barriers dropped as another barrier of their batch implies them
+		size_t batched_allocations = 0;       // constructed images and buffers allocated up front, in one call per allocator and resource kind
+		size_t deferred_allocations = 0;      // constructed images and buffers allocated when reached, as their arguments were only known then
+
+		std::vector<LayoutTransition> layout_transitions; // image barriers that change the layout, by old and new layout
+		std::vector<Queue> queues;                        // queues submitted to, in order of first submission
+	};
+
 	struct Compiler {
 		Compiler();
 		~Compiler();
@@ -652,6 +692,12 @@ public:
 		/// @brief compute ImageUsageFlags for given use chain
 		ImageUsageFlags compute_usage(const struct ChainLink* chain);
 
+		/// @brief retrieve timings and counters of the last compilation
+		const CompileStats& get_compile_stats() const;
+
+		/// @brief retrieve the synchronization counters of the last execution
+		const ExecuteStats& get_execute_stats() const;
+
 		/// @brief Dump the pass dependency graph in graphviz format
 		std::string dump_graph();
 
@@ -672,9 +718,11 @@ public:
 		void render_pass_assignment();
 		Result<void> validate_read_undefined();
 		Result<void> validate_duplicated_resource_ref();
+		Result<void> constant_folding();
+		Result<void> value_numbering();
 
 		template<class Pred>
-		Result<void> rewrite(Pred pred);
+		size_t rewrite(Pred pred);
 
 		friend struct ExecutableRenderGraph;
 	};
@@ -691,10 +739,13 @@ public:
 
 		Result<void> execute(Allocator& allocator);
 
+		/// @brief retrieve the synchronization counters of the last execution
+		const ExecuteStats& get_execute_stats() const;
+
 	private:
 		struct RGCImpl* impl;
 
-		void fill_render_pass_info(struct RenderPassInfo& rpass, const size_t& i, class CommandBuffer& cobuf);
+		static void fill_render_pass_info(struct RenderPassInfo& rpass, const size_t& i, class CommandBuffer& cobuf);
 
 		friend struct InferenceContext;
 	};
@@ -710,13 +761,4 @@ namespace std {
 			return h;
 		}
 	};
-
-	template<>
-	struct hash<vuk::Ref> {
-		size_t operator()(vuk::Ref const& x) const noexcept {
-			size_t h = 0;
-			hash_combine(h, x.node, x.index);
-			return h;
-		}
-	};
 }; // namespace std
@@ -4,6 +4,7 @@
 #include "vuk/RenderGraph.hpp"
 #include "vuk/ShortAlloc.hpp"
 #include <optional>
+#include <vector>
 
 namespace vuk {
 	inline bool is_write_access(Access ia) {
@@ -245,4 +246,16 @@ namespace vuk {
 	inline bool is_readonly_access(Access a) {
 		return !(a & (eTransferWrite | eComputeWrite | eFragmentWrite | eRayTracingWrite | eHostWrite | eMemoryWrite));
 	}
+
+	// barriers of a batch that were folded into others before recording
+	struct CoalescedBarriers {
+		size_t merged = 0;  // merged with a barrier over the same or an adjacent range
+		size_t dropped = 0; // implied by another barrier of the batch
+	};
+
+	// merges barriers over the same or adjacent ranges of a resource and drops barriers implied by others in the batch
+	void coalesce_barriers(std::vector<VkMemoryBarrier2KHR>& mem_bars,
+	                       std::vector<VkBufferMemoryBarrier2KHR>& buf_bars,
+	                       std::vector<VkImageMemoryBarrier2KHR>& im_bars,
+	                       CoalescedBarriers& result);
 } // namespace vuk
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vuk {
+	enum class TraceCategory : uint8_t {
+		eCompile,       // compilation phases
+		eSchedule,      // execution of a scheduled node
+		eAllocation,    // resource allocation during execution
+		eBarrier,       // barrier flushes
+		eCommandBuffer, // command buffer begin and end
+		eSubmit,        // queue submission
+		eWait           // host waits
+	};
+
+	enum class TracePhase : uint8_t { eBegin, eEnd, eInstant };
+
+	/// @brief A single trace event, as stored in the ring buffer
+	struct TraceEvent {
+		uint64_t timestamp; // nanoseconds on the steady clock
+		const char* name;   // must have static or interned (vuk::Name) lifetime
+		uint64_t arg;       // event specific payload, exported as args.value
+		uint32_t thread_id; // small sequential id of the recording thread
+		TraceCategory category;
+		TracePhase phase;
+	};
+
+	namespace trace {
+		namespace detail {
+			extern std::atomic<bool> enabled;
+		}
+
+		/// @brief Start recording events into a ring buffer of `capacity` events - once full, the oldest events are overwritten
+		/// Must not be called while other threads are recording
+		void enable(size_t capacity = 1 << 16);
+		/// @brief Stop recording, the recorded events are kept until the next call to enable()
+		void disable();
+
+		inline bool is_enabled() noexcept {
+			return detail::enabled.load(std::memory_order_relaxed);
+		}
+
+		/// @brief Record an event if tracing is enabled
+		void record(TracePhase phase, TraceCategory category, const char* name, uint64_t arg = 0) noexcept;
+
+		/// @brief Copy out the recorded events, oldest first
+		/// Must not be called while other threads are recording
+		std::vector<TraceEvent> snapshot();
+
+		/// @brief Export the recorded events in the Chrome trace event JSON format (chrome://tracing, Perfetto)
+		/// End events that lost their begin event to the ring buffer wrapping are dropped, and scopes still open are closed at the last event of their thread
+		std::string export_chrome_json();
+	} // namespace trace
+
+	/// @brief Records a begin event on construction and the matching end event on destruction
+	struct TraceScope {
+		TraceScope(TraceCategory category, const char* name, uint64_t arg = 0, bool condition = true) noexcept :
+		    category(category),
+		    name(name),
+		    active(condition && trace::is_enabled()) {
+			if (active) {
+				trace::record(TracePhase::eBegin, category, name, arg);
+			}
+		}
+
+		~TraceScope() {
+			if (active) {
+				trace::record(TracePhase::eEnd, category, name);
+			}
+		}
+
+		TraceScope(const TraceScope&) = delete;
+		TraceScope& operator=(const TraceScope&) = delete;
+
+		TraceCategory category;
+		const char* name;
+		bool active;
+	};
+} // namespace vuk
@@ -5,6 +5,7 @@
 #include "vuk/Hash.hpp"
 #include "vuk/vuk_fwd.hpp"
 
+#include <chrono>
 #include <compare>
 #include <string>
 #include <string_view>
@@ -806,11 +807,71 @@ namespace vuk {
 		void* user_data = nullptr;
 	};
 
+	/// @brief Runs command buffer recording tasks, possibly in parallel
+	/// When used, consecutive passes without commands between them are recorded into command buffers of their own, and the profiling callbacks and pass callbacks might be invoked concurrently
+	/// Each worker allocates from its own resource, nested over the resource of the executing allocator - which must be thread-safe, as the frame resources are
+	struct RecordingTaskRunner {
+		virtual ~RecordingTaskRunner() = default;
+
+		/// @brief Number of workers running the tasks - each worker records from its own command pool
+		virtual size_t worker_count() = 0;
+		/// @brief Invoke task(task_data, index, worker) for each index in [0, count) and return once all of them have completed
+		/// worker must be less than worker_count() and the tasks of one worker must not run concurrently
+		virtual void run(size_t count, void (*task)(void* task_data, size_t index, size_t worker), void* task_data) = 0;
+	};
+
+	/// @brief Synchronization of reads of a resource that prefer different image layouts
+	enum class ReadLayoutPolicy {
+		eMerge,    // all reads share a single layout, falling back to eGeneral when they disagree
+		eSplit,    // reads are split into groups, each group using its optimal layout
+		eCostModel // split or merge, whichever is estimated to be cheaper
+	};
+
 	/// @brief Control compilation options when compiling the rendergraph
 	struct RenderGraphCompileOptions {
 		std::string graph_label;
 		ProfilingCallbacks callbacks;
 		bool dump_graph = false;
+		ReadLayoutPolicy read_layout_policy = ReadLayoutPolicy::eMerge;
+		RecordingTaskRunner* recording_task_runner = nullptr; // if set, passes are recorded through it instead of on the executing thread
+	};
+
+	/// @brief Timings and element counts of the phases of the last compilation
+	struct CompileStats {
+		struct Phase {
+			std::chrono::nanoseconds duration = {}; // accumulated over all invocations of the phase
+			size_t count = 0;                       // number of elements processed by the phase
+		};
+
+		Phase module_collection;  // modules reachable from the compiled nodes
+		Phase garbage_collection; // nodes alive after GC
+		Phase implicit_linking;   // nodes linked per module
+		Phase build_nodes;        // nodes collected
+		Phase build_links;        // nodes linked
+		Phase rewrite;            // replaces performed
+		Phase constant_folding;   // pure scalar nodes considered for folding
+		Phase value_numbering;    // pure scalar nodes numbered
+		Phase validation;         // nodes validated
+		Phase collect_chains;     // use chains
+		Phase reify_inference;    // nodes inferred
+		Phase queue_inference;    // scheduled items
+		Phase pass_partitioning;  // partitioned items
+		Phase build_sync;         // nodes synchronized
+
+		size_t folded_nodes = 0; // nodes replaced by a constant during constant folding
+		size_t merged_nodes = 0; // nodes replaced by an identical node during value numbering
+		size_t cached_modules = 0; // unchanged modules that skipped GC and implicit linking, bounded by IRModule::max_cached_compiles
+		size_t general_layout_fallbacks = 0; // merged reads that needed eGeneral
+		size_t split_reads = 0;              // reads split into groups with optimal layouts
+		// allocations the compiler's retained storage had to take from the heap - 0 once a repeated compile fits the retained capacity
+		// nodes created in the IR modules (folded constants, converges, the storage of splices) and the graph dump are not counted
+		size_t heap_allocations = 0;
+
+		std::chrono::nanoseconds total() const noexcept {
+			return module_collection.duration + garbage_collection.duration + implicit_linking.duration + build_nodes.duration + build_links.duration +
+			       rewrite.duration + constant_folding.duration + value_numbering.duration + validation.duration + collect_chains.duration +
+			       reify_inference.duration + queue_inference.duration + pass_partitioning.duration + build_sync.duration;
+		}
 	};
 
 	enum class DescriptorSetStrategyFlagBits {
@@ -886,4 +947,15 @@ namespace vuk {
 	};
 } // namespace vuk
 
+namespace std {
+	template<>
+	struct hash<vuk::Ref> {
+		size_t operator()(vuk::Ref const& x) const noexcept {
+			size_t h = 0;
+			hash_combine(h, x.node, x.index);
+			return h;
+		}
+	};
+} // namespace std
+
 #undef MOV
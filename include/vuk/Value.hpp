@@ -224,6 +224,7 @@ namespace vuk {
 			candidate_node.extract.composite = composite; // writing these out for clang workaround
 			candidate_node.extract.index = first(&constant_node);
 			current_module->garbage.push_back(def.node->construct.args[index + 1].node);
+			current_module->touch(def.node);
 			auto res = [&]() -> Result<void>{
 				if (ty->kind == Type::INTEGER_TY && ty->integer.width == 64) {
 					auto result_ = eval<uint64_t>(first(&candidate_node));
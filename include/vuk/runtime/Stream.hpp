@@ -7,10 +7,14 @@ namespace vuk {
 		Allocator alloc;
 		Executor* executor = nullptr;
 		DomainFlagBits domain;
-		std::vector<Stream*> dependencies;
+		struct Dependency {
+			Stream* stream;
+			PipelineStageFlags dst_stages; // stages on this stream that need to wait for the dependency
+		};
+		std::vector<Dependency> dependencies;
 		std::vector<Signal*> dependent_signals;
 
-		virtual void add_dependency(Stream* dep) = 0;
+		virtual void add_dependency(Stream* dep, PipelineStageFlags dst_stages) = 0;
 		virtual void sync_deps() = 0;
 
 		virtual Signal* make_signal() = 0;
@@ -20,7 +24,7 @@ namespace vuk {
 		}
 
 		virtual void synch_image(ImageAttachment& img_att, Subrange::Image subrange, StreamResourceUse src_use, StreamResourceUse dst_use, void* tag) = 0;
-		virtual void synch_memory(StreamResourceUse src_use, StreamResourceUse dst_use, void* tag) = 0;
+		virtual void synch_memory(const Buffer& buf, Subrange::Buffer subrange, StreamResourceUse src_use, StreamResourceUse dst_use, void* tag) = 0;
 
 		struct SubmitResult {
 			VkSemaphore sema_wait;
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "vuk/Config.hpp"
+#include "vuk/Executor.hpp"
+#include "vuk/Result.hpp"
+
+#include <function2/function2.hpp>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace vuk {
+	/// @brief Abstraction of execution on a pool of host threads
+	/// Each worker owns a deque of ready tasks: it takes work from the back of its own deque and steals from the front of the other deques when it runs dry
+	/// The thread waiting for the work participates as an additional worker
+	struct ThreadPoolExecutor : Executor, RecordingTaskRunner {
+		/// @brief A task of a task graph
+		struct Task {
+			fu2::unique_function<void(size_t worker)> run;
+			std::vector<size_t> dependents; // indices of the tasks that can only start once this task has completed
+			uint32_t dependency_count = 0;  // number of tasks this task waits for
+		};
+
+		/// @param thread_count Number of threads to spawn, the waiting thread comes in addition
+		ThreadPoolExecutor(size_t thread_count);
+		~ThreadPoolExecutor();
+
+		ThreadPoolExecutor(ThreadPoolExecutor&&) = delete;
+		ThreadPoolExecutor& operator=(ThreadPoolExecutor&&) = delete;
+
+		// while locked, no task graph runs
+		void lock() override;
+		void unlock() override;
+		Result<void> wait_idle() override;
+
+		/// @brief Run each task once all of its dependencies have completed, on the workers and the calling thread - returns once all tasks have completed
+		/// The dependencies must not form a cycle, and tasks must not run task graphs themselves
+		void run_graph(std::span<Task> tasks);
+
+		size_t worker_count() override;
+		void run(size_t count, void (*task)(void* task_data, size_t index, size_t worker), void* task_data) override;
+
+	private:
+		std::unique_ptr<struct ThreadPoolExecutorImpl> impl;
+	};
+} // namespace vuk
@@ -89,14 +89,10 @@ namespace vuk {
 		return { expected_value, std::move(img) };
 	}
 
-	/// @brief Allocate a single image from an Allocator
-	/// @param allocator Allocator to use
+	/// @brief Make the creation parameters of the Image for an ImageAttachment
 	/// @param attachment ImageAttachment to make the Image from
-	/// @param loc Source location information
-	/// @return Image in a RAII wrapper (Unique<T>) or AllocateException on error
-	inline Result<Unique<Image>, AllocateException>
-	allocate_image(Allocator& allocator, const ImageAttachment& attachment, SourceLocationAtFrame loc = VUK_HERE_AND_NOW()) {
-		Unique<Image> img(allocator);
+	/// @return ImageCreateInfo without the view format list required for allow_srgb_unorm_mutable
+	inline ImageCreateInfo image_create_info(const ImageAttachment& attachment) {
 		ImageCreateInfo ici;
 		ici.format = vuk::Format(attachment.format);
 		ici.imageType = attachment.image_type;
@@ -107,6 +103,18 @@ namespace vuk {
 		ici.mipLevels = attachment.level_count;
 		ici.usage = attachment.usage;
 		ici.extent = attachment.extent;
+		return ici;
+	}
+
+	/// @brief Allocate a single image from an Allocator
+	/// @param allocator Allocator to use
+	/// @param attachment ImageAttachment to make the Image from
+	/// @param loc Source location information
+	/// @return Image in a RAII wrapper (Unique<T>) or AllocateException on error
+	inline Result<Unique<Image>, AllocateException>
+	allocate_image(Allocator& allocator, const ImageAttachment& attachment, SourceLocationAtFrame loc = VUK_HERE_AND_NOW()) {
+		Unique<Image> img(allocator);
+		ImageCreateInfo ici = image_create_info(attachment);
 
 		VkImageFormatListCreateInfo listci = { VK_STRUCTURE_TYPE_IMAGE_FORMAT_LIST_CREATE_INFO };
 		VkFormat formats[2];
@@ -102,7 +102,8 @@ namespace vuk {
 		/// @brief Wait for the fences / timeline semaphores referencing this frame to complete
 		///
 		/// Called automatically when recycled
-		void wait();
+		/// @return the error of a failed wait
+		Result<void> wait();
 
 		/// @brief Retrieve the parent Runtime
 		/// @return the parent Runtime
@@ -83,7 +83,8 @@ namespace vuk {
 		void wait_sync_points(std::span<const SyncPoint> src) override;
 
 		/// @brief Wait for the fences / timeline semaphores referencing this allocator
-		void wait();
+		/// @return the error of a failed wait
+		Result<void> wait();
 
 		/// @brief Release the resources of this resource into the upstream
 		void free();
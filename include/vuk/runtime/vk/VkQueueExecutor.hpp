@@ -2,6 +2,7 @@
 
 #include "vuk/Config.hpp"
 #include "vuk/Executor.hpp"
+#include "vuk/ResourceUse.hpp"
 #include "vuk/SyncPoint.hpp"
 
 #include <span>
@@ -11,7 +12,11 @@ namespace vuk {
 	struct SubmitInfo {
 		std::vector<VkCommandBuffer> command_buffers;
 		std::vector<std::pair<DomainFlagBits, uint64_t>> relative_waits;
-		std::vector<Signal*> waits;
+		struct Wait {
+			Signal* signal;
+			PipelineStageFlags stages; // stages of the submission that wait on the signal
+		};
+		std::vector<Wait> waits;
 		std::vector<Signal*> signals;
 		std::vector<VkSemaphore> pres_wait;
 		std::vector<VkSemaphore> pres_signal;
@@ -25,8 +30,13 @@ namespace vuk {
 		QueueExecutor(QueueExecutor&&) noexcept;
 		QueueExecutor& operator=(QueueExecutor&&) noexcept;
 
-		Result<void> submit_batch(std::vector<SubmitInfo> batch);
+		Result<void> submit_batch(std::span<SubmitInfo> batch);
+		/// @brief Query the current value of the timeline semaphore of the queue
 		Result<uint64_t> get_sync_value();
+		/// @brief The highest value the timeline semaphore was observed to reach, without querying it
+		uint64_t get_completed_value() const;
+		/// @brief Record that the timeline semaphore reached the value, after waiting for it
+		void mark_completed(uint64_t value);
 		VkSemaphore get_semaphore();
 		uint32_t get_queue_family_index();
 
@@ -8,6 +8,7 @@
 
 #include "vuk/Buffer.hpp"
 #include "vuk/Executor.hpp"
+#include "vuk/Name.hpp"
 #include "vuk/runtime/vk/Allocator.hpp"
 #include "vuk/runtime/vk/Image.hpp"
 #include "vuk/runtime/vk/VkSwapchain.hpp"
@@ -54,6 +55,34 @@ namespace vuk {
 		FunctionPointers pointers;
 	};
 
+	/// @brief GPU duration of a pass or barrier batch, measured by the built-in pass profiler
+	struct PassTiming {
+		Name pass_name;  // name of the pass, or "barriers" for a barrier batch
+		uint64_t frame;  // frame count when the pass was recorded
+		double duration; // in seconds
+	};
+
+	/// @brief A timestamp query of the built-in pass profiler
+	struct PassTimestamp {
+		VkQueryPool pool = VK_NULL_HANDLE;
+		uint32_t index = 0;
+	};
+
+	/// @brief Render pass and framebuffer of a set of attachments, as returned by the framebuffer cache
+	struct RenderPassFramebuffer {
+		VkRenderPass render_pass;
+		VkFramebuffer framebuffer;
+		bool cached; // true if found in the cache, false if created by this lookup
+	};
+
+	/// @brief Receives the buffers and images destroyed through the Runtime's device resource, before their handles can be reused
+	/// Callbacks can arrive from any thread that deallocates
+	struct DestructionListener {
+		virtual ~DestructionListener() = default;
+		virtual void on_destroy(std::span<const Buffer> buffers) {}
+		virtual void on_destroy(std::span<const Image> images) {}
+	};
+
 	class Runtime : public FunctionPointers {
 	public:
 		/// @brief Create a new Runtime
@@ -122,6 +151,10 @@ namespace vuk {
 		/// @return true if the pipeline is available
 		bool is_pipeline_available(Name name) const;
 
+		/// @brief Retrieve a counter that changes whenever a named pipeline is (re)created
+		/// Commands recorded for reuse are only replayed within the same generation
+		uint64_t get_pipeline_generation() const;
+
 		PipelineBaseInfo* get_pipeline(const PipelineBaseCreateInfo& pbci);
 		/// @brief Reflect given pipeline base
 		Program get_pipeline_reflection_info(const PipelineBaseCreateInfo& pbci);
@@ -153,7 +186,10 @@ namespace vuk {
 		/// @brief Wait for the device to become idle. Useful for only a few synchronisation events, like resizing or shutting down.
 		Result<void> wait_idle();
 
+		/// @brief Wait on the host until all the sync points are reached, with one wait for the highest value per queue timeline
+		/// @return an error if the wait fails, or if a sync point is not on a Vulkan device queue
 		Result<void> wait_for_domains(std::span<struct SyncPoint> sync_points);
+		/// @brief Check if a sync point was reached - values already observed to be reached do not query the device
 		static Result<bool> sync_point_ready(SyncPoint sp);
 
 		// Query functionality
@@ -180,12 +216,39 @@ namespace vuk {
 		/// @brief Retrieve results from `TimestampQueryPool`s and make them available to retrieve_timestamp and retrieve_duration
 		Result<void> make_timestamp_results_available(std::span<const TimestampQueryPool> pools);
 
+		/// @brief Enable or disable the built-in pass profiler, which writes timestamps around every pass and barrier batch recorded
+		/// The timestamps come from query pools of the current frame. A frame reuses the pools of the frame 8 frames earlier, in a single pool sized to the
+		/// timestamps of that frame - the work of a frame must have completed by then.
+		void set_pass_profiling(bool enable);
+		bool is_pass_profiling_enabled() const;
+		/// @brief Reserve a timestamp in the query pools of the current frame
+		Result<PassTimestamp> allocate_pass_timestamp();
+		/// @brief Register the begin and end timestamps of a pass recorded in the current frame
+		void register_pass_timing(Name pass_name, PassTimestamp begin, PassTimestamp end);
+		/// @brief Retrieve the durations of profiled passes whose timestamps are available, without waiting - each duration is returned once
+		/// Passes whose timestamps are not available when their pools are reused are discarded
+		std::vector<PassTiming> retrieve_pass_timings();
+
 		// Caches
 
 		/// @brief Acquire a cached sampler
 		Sampler acquire_sampler(const SamplerCreateInfo& cu, uint64_t absolute_frame);
 		/// @brief Acquire a cached descriptor pool
 		struct DescriptorPool& acquire_descriptor_pool(const struct DescriptorSetLayoutAllocInfo& dslai, uint64_t absolute_frame);
+		/// @brief Acquire the render pass and framebuffer for a set of attachments in one lookup, keyed by the attachment descriptions and image view identities
+		/// The handles stay valid until one of the image views is destroyed or they go unused for 16 frames
+		Result<RenderPassFramebuffer, AllocateException> acquire_render_pass_framebuffer(const struct RenderPassCreateInfo& rpci,
+		                                                                                 const struct FramebufferCreateInfo& fbci);
+		/// @brief Drop the cached framebuffers referencing any of the image views - called when image views are destroyed
+		void invalidate_framebuffers(std::span<const ImageView> image_views);
+		/// @brief Register a listener to be notified of destroyed buffers and images
+		void add_destruction_listener(DestructionListener* listener);
+		/// @brief Unregister a listener previously registered with add_destruction_listener
+		void remove_destruction_listener(DestructionListener* listener);
+		/// @brief Notify the listeners of buffers about to be destroyed - called when buffers are deallocated
+		void notify_destroyed(std::span<const Buffer> buffers);
+		/// @brief Notify the listeners of images about to be destroyed - called when images are deallocated
+		void notify_destroyed(std::span<const Image> images);
 		/// @brief Force collection of caches
 		void collect(uint64_t frame);
 
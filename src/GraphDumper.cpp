@@ -210,6 +210,10 @@ namespace vuk {
 		}
 	}
 
+	bool GraphDumper::enabled() {
+		return dumper.enable;
+	}
+
 	void GraphDumper::begin_cluster(std::string label) {
 		if (dumper.enable) {
 			dumper.begin_cluster(label);
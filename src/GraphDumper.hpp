@@ -5,6 +5,8 @@ namespace vuk {
 	struct GraphDumper {
 		static void begin_graph(bool enable, std::string label);
 
+		static bool enabled();
+
 		static void begin_cluster(std::string label);
 
 		static void next_cluster(std::string label);
@@ -172,15 +172,76 @@ namespace vuk {
 		delete impl;
 	}
 
+	void RetainedMonotonicResource::prepare() {
+		if (prepared) {
+			return;
+		}
+		prepared = true;
+		size_t new_size = std::max(min_size, storage_size);
+		if (used > storage_size) {
+			new_size = std::max(min_size, used + used / 4);
+			low_usage_compiles = 0;
+		} else if (used < storage_size / 4) {
+			if (++low_usage_compiles >= trim_after) {
+				new_size = std::max(min_size, storage_size / 2);
+				low_usage_compiles = 0;
+			}
+		} else {
+			low_usage_compiles = 0;
+		}
+		if (new_size != storage_size) {
+			next_storage.reset(new std::byte[new_size]);
+			next_storage_size = new_size;
+			storage_allocations++;
+		}
+	}
+
+	void RetainedMonotonicResource::recycle() {
+		mbr.reset(); // returns the overflow to the upstream
+		prepare();
+		if (next_storage) {
+			storage = std::move(next_storage);
+			storage_size = next_storage_size;
+		}
+		prepared = false;
+		used = 0;
+		mbr.emplace(storage.get(), storage_size, upstream);
+	}
+
+	void RGCImpl::reset() {
+		// links of the last compilation live in mbr - a compilation that was not executed leaves them on the nodes
+		for (auto& node : nodes) {
+			node->links = nullptr;
+		}
+		// the containers living in mbr need to let go of their storage before it is recycled
+		deferred_splices = decltype(deferred_splices)(&mbr);
+		pending_splice_sigs = decltype(pending_splice_sigs)(&mbr);
+		mbr.recycle();
+		arena_->reset();
+
+		scheduled_execables.clear();
+		partitioned_execables.clear();
+		pass_reads.clear();
+		pass_nops.clear();
+		refs.clear();
+		ref_nodes.clear();
+		depnodes.clear();
+		nodes.clear();
+		garbage_nodes.clear();
+		chains.clear();
+		modules.clear();
+		child_chains.clear();
+		transfer_passes = {};
+		compute_passes = {};
+		graphics_passes = {};
+		callbacks = {};
+		read_layout_policy = ReadLayoutPolicy::eMerge;
+		recording_task_runner = nullptr;
+		// the stats of the last compilation are kept around for reflection
+	}
+
 	void Compiler::reset() {
-		auto pool = std::move(impl->pool);
-		auto pass_r = std::move(impl->pass_reads);
-		auto arena = impl->arena_.release();
-		delete impl;
-		arena->reset();
-		impl = new RGCImpl(arena, std::move(pool));
-		impl->pass_reads = std::move(pass_r);
-		impl->pass_reads.clear();
+		impl->reset();
 	}
 
 	template<class It>
@@ -229,6 +290,7 @@ namespace vuk {
 	}
 
 	Result<void> RGCImpl::build_nodes() {
+		PhaseTimer _(stats.build_nodes, "build_nodes");
 		nodes.clear();
 
 		std::vector<Node*, short_alloc<Node*>> work_queue(*arena_);
@@ -268,6 +330,7 @@ namespace vuk {
 		for (auto& node : nodes) {
 			node->flag = 0;
 		}
+		stats.build_nodes.count += nodes.size();
 
 		return { expected_value };
 	}
@@ -334,11 +397,11 @@ namespace vuk {
 							link = &nth(link->undef.node, 0).link();
 							current_range = left;
 						} else { // requested range is partially in left and in right -> converge needed of the tails
-							std::pmr::vector<Ref> tails;
+							std::pmr::vector<Ref> tails(allocator);
 							// walk left and walk right
 							collect_tails(nth(link->undef.node, 0), tails, pass_reads);
 							collect_tails(nth(link->undef.node, 1), tails, pass_reads);
-							std::pmr::vector<char> ws(tails.size(), true);
+							std::pmr::vector<char> ws(tails.size(), true, allocator);
 
 							last_write = module->make_converge(tails, ws);
 							last_write.node->index = node->index - 1;
@@ -627,7 +690,9 @@ namespace vuk {
 		}
 	}
 
-	Result<void> RGCImpl::build_links(std::vector<Node*>& working_set, std::pmr::polymorphic_allocator<std::byte> allocator) {
+	Result<void> RGCImpl::build_links(std::pmr::vector<Node*>& working_set, std::pmr::polymorphic_allocator<std::byte> allocator) {
+		PhaseTimer _(stats.build_links, "build_links");
+		stats.build_links.count += working_set.size();
 		pass_reads.clear();
 		pass_nops.clear();
 		child_chains.clear();
@@ -644,7 +709,7 @@ namespace vuk {
 			allocate_node_links(node, allocator);
 		}
 
-		std::pmr::vector<Node*> new_nodes;
+		std::pmr::vector<Node*> new_nodes(allocator);
 		for (auto& node : working_set) {
 			process_node_links(current_module.get(), node, pass_reads, pass_nops, child_chains, new_nodes, allocator, false);
 		}
@@ -695,20 +760,24 @@ namespace vuk {
 	}
 
 	Result<void> RGCImpl::reify_inference() {
+		PhaseTimer _(stats.reify_inference, "reify_inference");
+		stats.reify_inference.count += nodes.size();
 		auto is_placeholder = [](Ref r) {
 			return r.node->kind == Node::PLACEHOLDER;
 		};
 
 		bool progress = false;
 
-		auto placeholder_to_constant = [&progress]<class T>(Ref r, T value) {
+		ConstantEvaluator evaluator(std::pmr::polymorphic_allocator<std::byte>(&mbr));
+
+		auto placeholder_to_constant = [&progress, &evaluator]<class T>(Ref r, T value) {
 			if (r.node->kind == Node::PLACEHOLDER) {
 				r.node->kind = Node::CONSTANT;
 				assert(sizeof(T) == r.type()->size);
-				r.node->constant.value = new char[sizeof(T)];
-				new (r.node->constant.value) T(value);
+				r.node->constant.value = new (IRModule::allocate_constant(sizeof(T))) T(value);
 				r.node->constant.owned = true;
 				progress = true;
+				evaluator.invalidate_failures();
 			}
 		};
 
@@ -804,8 +873,8 @@ namespace vuk {
 										placeholder_to_constant(args[5], *samples);
 									}
 									if (!extent && !is_placeholder(args[1]) && !is_placeholder(args[2])) { // known extent2D
-										auto e1 = eval<uint32_t>(args[1]);
-										auto e2 = eval<uint32_t>(args[2]);
+										auto e1 = evaluator.eval<uint32_t>(args[1]);
+										auto e2 = evaluator.eval<uint32_t>(args[2]);
 										if (e1.holds_value() && e2.holds_value()) {
 											extent = Extent2D{ *e1, *e2 };
 										}
@@ -814,7 +883,7 @@ namespace vuk {
 										placeholder_to_constant(args[2], extent->height);
 									}
 									if (!layer_count && !is_placeholder(args[7])) { // known layer count
-										auto e = eval<uint32_t>(args[7]);
+										auto e = evaluator.eval<uint32_t>(args[7]);
 										if (e.holds_value()) {
 											layer_count = *e;
 										}
@@ -857,6 +926,7 @@ namespace vuk {
 	}
 
 	Result<void> RGCImpl::collect_chains() {
+		PhaseTimer _(stats.collect_chains, "collect_chains");
 		chains.clear();
 		// collect chains by looking at links without a prev
 		for (auto& node : nodes) {
@@ -868,13 +938,92 @@ namespace vuk {
 				}
 			}
 		}
+		stats.collect_chains.count += chains.size();
 
 		return { expected_value };
 	}
 
+	// relative costs for choosing between merged and split read layouts
+	// a layout transition costs a barrier, while reading in eGeneral loses compression on every read
+	static constexpr float layout_transition_cost = 1.f;
+	static constexpr float general_layout_read_cost = 0.5f;
+
+	// try to split the reads of link into groups with optimal layouts: non-transfer reads first, then transfer reads
+	// returns false if the reads should be merged into a common layout instead
+	bool RGCImpl::split_reads(ChainLink& link) {
+		if (read_layout_policy == ReadLayoutPolicy::eMerge) {
+			return false;
+		}
+
+		auto reads = link.reads.to_span(pass_reads);
+		auto read_access = [](Ref r) -> Access {
+			if (r.node->kind != Node::CALL) {
+				return Access::eNone;
+			}
+			auto fn_type = r.node->call.args[0].type();
+			size_t first_parm = fn_type->kind == Type::OPAQUE_FN_TY ? 1 : 4;
+			auto& args = fn_type->kind == Type::OPAQUE_FN_TY ? fn_type->opaque_fn.args : fn_type->shader_fn.args;
+			auto& arg_ty = args[r.index - first_parm];
+			return arg_ty->kind == Type::IMBUED_TY ? arg_ty->imbued.access : Access::eNone;
+		};
+
+		// non-CALL reads (CONVERGE, SPLICE) don't sync through the read groups, they go with the first group
+		auto is_late = [&](Ref r) { return is_transfer_access(read_access(r)); };
+		size_t late_count = std::count_if(reads.begin(), reads.end(), is_late);
+		size_t group_count = (late_count != reads.size()) + (late_count != 0);
+
+		// decide before touching the reads - a merged link keeps them in their original order
+		if (read_layout_policy == ReadLayoutPolicy::eCostModel) {
+			float merge_cost = layout_transition_cost + general_layout_read_cost * reads.size();
+			float split_cost = layout_transition_cost * group_count;
+			if (split_cost >= merge_cost) {
+				return false;
+			}
+		}
+
+		// order-preserving partition: copy the late reads out to a scratch in mbr, compact the early reads, then append the late reads
+		// (std::stable_partition takes its buffer from the heap)
+		std::pmr::vector<Ref> late_scratch(&mbr);
+		late_scratch.reserve(late_count);
+		std::copy_if(reads.begin(), reads.end(), std::back_inserter(late_scratch), is_late);
+		auto late = std::remove_if(reads.begin(), reads.end(), is_late);
+		std::copy(late_scratch.begin(), late_scratch.end(), late);
+
+		auto merge_group = [&](std::span<Ref> group, ImageLayout layout) {
+			ResourceUse use;
+			use.layout = layout;
+			for (auto& r : group) {
+				auto access = read_access(r);
+				if (access == Access::eNone) {
+					continue;
+				}
+				auto group_use = to_use(access);
+				use.access |= group_use.access;
+				use.stages |= group_use.stages;
+			}
+			return use;
+		};
+		auto early_reads = std::span(reads.begin(), late);
+		auto late_reads = std::span(late, reads.end());
+
+		if (early_reads.empty()) {
+			link.read_sync = merge_group(late_reads, ImageLayout::eTransferSrcOptimal);
+		} else {
+			link.read_sync = merge_group(early_reads, ImageLayout::eReadOnlyOptimalKHR);
+			if (!late_reads.empty()) {
+				link.late_read_sync = merge_group(late_reads, ImageLayout::eTransferSrcOptimal);
+				link.read_split = (uint32_t)early_reads.size();
+			}
+		}
+		stats.split_reads++;
+		return true;
+	}
+
 	// build required synchronization for nodes
 	// at this point we know everything
 	Result<void> RGCImpl::build_sync() {
+		PhaseTimer _(stats.build_sync, "build_sync");
+		stats.build_sync.count += nodes.size();
 		for (auto node : nodes) {
 			switch (node->kind) {
 			case Node::CALL: {
@@ -952,7 +1101,14 @@ namespace vuk {
 								dst_use.layout = ImageLayout::eGeneral;
 							}
 
-							link.read_sync = dst_use;
+							// images read in eGeneral without needing it might rather split their reads into groups with optimal layouts
+							bool is_image = Type::stripped(parm.type())->hash_value == current_module->types.builtin_image;
+							if (!is_image || dst_use.layout != ImageLayout::eGeneral || need_general || !split_reads(link)) {
+								if (is_image && dst_use.layout == ImageLayout::eGeneral) {
+									stats.general_layout_fallbacks++;
+								}
+								link.read_sync = dst_use;
+							}
 						}
 					}
 				}
@@ -1001,6 +1157,8 @@ namespace vuk {
 	}
 
 	void Compiler::queue_inference() {
+		PhaseTimer _(impl->stats.queue_inference, "queue_inference");
+		impl->stats.queue_inference.count += impl->scheduled_execables.size();
 		// queue inference pass
 		DomainFlagBits last_domain = DomainFlagBits::eDevice;
 		auto propagate_domain = [&last_domain](Node* node) {
@@ -1106,6 +1264,7 @@ namespace vuk {
 
 	// partition passes into different queues
 	void Compiler::pass_partitioning() {
+		PhaseTimer _(impl->stats.pass_partitioning, "pass_partitioning");
 		impl->partitioned_execables.reserve(impl->scheduled_execables.size());
 		for (auto& p : impl->scheduled_execables) {
 			if (p.scheduled_domain & DomainFlagBits::eTransferQueue) {
@@ -1127,6 +1286,7 @@ namespace vuk {
 		}
 		impl->graphics_passes = { impl->partitioned_execables.begin() + impl->transfer_passes.size() + impl->compute_passes.size(),
 			                        impl->partitioned_execables.size() - impl->transfer_passes.size() - impl->compute_passes.size() };
+		impl->stats.pass_partitioning.count += impl->partitioned_execables.size();
 	}
 
 	Result<void> Compiler::validate_read_undefined() {
@@ -1189,9 +1349,9 @@ namespace vuk {
 	}
 
 	Result<void> Compiler::validate_duplicated_resource_ref() {
-		std::unordered_set<Buffer> bufs;
-		std::unordered_set<ImageAttachment> ias;
-		std::unordered_set<Swapchain*> swps;
+		std::pmr::unordered_set<Buffer> bufs(&impl->mbr);
+		std::pmr::unordered_set<ImageAttachment> ias(&impl->mbr);
+		std::pmr::unordered_set<Swapchain*> swps(&impl->mbr);
 		for (auto node : impl->nodes) {
 			switch (node->kind) {
 			case Node::CONSTRUCT: {
@@ -1257,6 +1417,7 @@ namespace vuk {
 	}
 
 	Result<void> RGCImpl::implicit_linking(IRModule* module, std::pmr::polymorphic_allocator<std::byte> allocator) {
+		PhaseTimer _(stats.implicit_linking, "implicit_linking");
 		std::pmr::vector<Node*> nodes(allocator);
 
 		for (auto& node : module->op_arena) {
@@ -1267,6 +1428,8 @@ namespace vuk {
 		std::pmr::vector<Ref> pass_nops(allocator);
 		std::pmr::vector<ChainLink*> child_chains(allocator);
 
+		stats.implicit_linking.count += nodes.size();
+
 		std::sort(nodes.begin(), nodes.end(), [](Node* a, Node* b) { return a->index < b->index; });
 		// link with SSA
 		build_links(module, nodes.begin(), nodes.end(), pass_reads, pass_nops, child_chains, allocator);
@@ -1328,8 +1491,9 @@ namespace vuk {
 		}
 	};
 
+	// returns the number of replaces performed
 	template<class Pred>
-	Result<void> Compiler::rewrite(Pred pred) {
+	size_t Compiler::rewrite(Pred pred) {
 		std::vector<Replace, short_alloc<Replace>> replaces(*impl->arena_);
 		Replacer rr(replaces);
 
@@ -1343,45 +1507,221 @@ namespace vuk {
 		    }
 		    fmt::print("]\n");*/
 
-		std::vector<Ref*, short_alloc<Ref*>> args(*impl->arena_);
+		// args with the node they belong to, so that the module owning the node can be touched
+		struct Arg {
+			Ref* ref;
+			Node* node;
+		};
+		std::vector<Arg, short_alloc<Arg>> args(*impl->arena_);
+		size_t arg_count = 0;
+		for (auto node : impl->nodes) {
+			auto count = node->generic_node.arg_count;
+			arg_count += count != (uint8_t)~0u ? count : node->variable_node.args.size();
+		}
+		args.reserve(arg_count);
 		// collect all args
 		for (auto node : impl->nodes) {
 			auto count = node->generic_node.arg_count;
 			if (count != (uint8_t)~0u) {
 				for (int i = 0; i < count; i++) {
 					auto arg = &node->fixed_node.args[i];
-					args.push_back(arg);
+					args.push_back({ arg, node });
 				}
 			} else {
 				for (int i = 0; i < node->variable_node.args.size(); i++) {
 					auto arg = &(*(Ref**)&node->variable_node.args)[i];
-					args.push_back(arg);
+					args.push_back({ arg, node });
 				}
 			}
 		}
 
-		std::sort(args.begin(), args.end(), [](Ref* a, Ref* b) { return a->node < b->node || (a->node == b->node && a->index < b->index); });
+		std::sort(args.begin(), args.end(), [](const Arg& a, const Arg& b) { return *a.ref < *b.ref; });
 
 		// do the replaces
 		auto arg_it = args.begin();
 		auto arg_end = args.end();
 		for (auto replace_it = replaces.begin(); replace_it != replaces.end(); ++replace_it) {
 			auto& replace = *replace_it;
-			while (arg_it != arg_end && **arg_it < replace.needle) {
+			while (arg_it != arg_end && *arg_it->ref < replace.needle) {
 				++arg_it;
 			}
-			while (arg_it != arg_end && **arg_it == replace.needle) {
-				**arg_it = replace.value;
+			while (arg_it != arg_end && *arg_it->ref == replace.needle) {
+				*arg_it->ref = replace.value;
+				impl->touch(arg_it->node);
 				++arg_it;
 			}
 		}
 
+		return replaces.size();
+	}
+
+	// scalar values (integers and plain memory) are pure - they can be folded and merged freely
+	static bool is_pure_scalar(Node* node) {
+		auto kind = Type::stripped(node->type[0])->kind;
+		return kind == Type::INTEGER_TY || kind == Type::MEMORY_TY;
+	}
+
+	// replace scalar computations that only depend on owned constants with a constant
+	// constants pointing into resources (eg. the extent of a declared image) or placeholders are written by inference and allocation later on
+	Result<void> Compiler::constant_folding() {
+		PhaseTimer _(impl->stats.constant_folding, "constant_folding");
+		ConstantEvaluator evaluator(std::pmr::polymorphic_allocator<std::byte>(&impl->mbr));
+
+		rewrite([&](Node* node, auto& replaces) {
+			switch (node->kind) {
+			case Node::MATH_BINARY:
+			case Node::EXTRACT:
+			case Node::CAST: {
+				if (!is_pure_scalar(node)) {
+					break;
+				}
+				impl->stats.constant_folding.count++;
+				auto rov = evaluator.evaluate(first(node));
+				if (!rov.holds_value()) {
+					(void)rov.error();
+					break;
+				}
+				if (rov->is_ref || rov->value == nullptr || !evaluator.is_owned(first(node))) {
+					break;
+				}
+				replaces.replace(first(node), current_module->make_constant(Type::stripped(node->type[0]), rov->value));
+				impl->stats.folded_nodes++;
+			} break;
+			default:
+				break;
+			}
+		});
+		return { expected_value };
+	}
+
+	// hash-based value numbering of pure scalar nodes
+	// nodes are numbered after their operands (on an explicit stack), so identical expression trees get the same number bottom-up
+	struct ValueNumbering {
+		struct Key {
+			Node::Kind kind;
+			uint32_t op;
+			Type::Hash type;
+			Ref a;
+			Ref b;
+			uint64_t value;
+
+			bool operator==(const Key&) const noexcept = default;
+		};
+
+		struct KeyHash {
+			size_t operator()(const Key& k) const noexcept {
+				size_t h = 0;
+				hash_combine(h, (uint32_t)k.kind, k.op, k.type, k.a, k.b, k.value);
+				return h;
+			}
+		};
+
+		ValueNumbering(std::pmr::polymorphic_allocator<std::byte> allocator) : numbers(allocator), table(allocator), stack(allocator) {}
+
+		std::pmr::unordered_map<Ref, Ref> numbers; // ref -> canonical ref
+		std::pmr::unordered_map<Key, Ref, KeyHash> table;
+		std::pmr::vector<Ref> stack;
+
+		// CONSTANTs pointing to external memory can change until execution, only owned integers are numbered
+		// resources are never numbered, two nodes producing the same resource are not interchangeable
+		static bool numbered(Ref ref) {
+			switch (ref.node->kind) {
+			case Node::CONSTANT:
+				return ref.node->constant.owned && Type::stripped(ref.type())->kind == Type::INTEGER_TY && ref.type()->size <= sizeof(uint64_t);
+			case Node::MATH_BINARY:
+			case Node::EXTRACT:
+			case Node::CAST:
+				return is_pure_scalar(ref.node);
+			default:
+				return false;
+			}
+		}
+
+		Ref canonical(Ref ref) {
+			if (!numbered(ref)) {
+				return ref;
+			}
+			return numbers.at(ref);
+		}
+
+		Ref number(Ref ref) {
+			stack.push_back(ref);
+			while (!stack.empty()) {
+				auto top = stack.back();
+				if (numbers.contains(top)) {
+					stack.pop_back();
+					continue;
+				}
+				auto node = top.node;
+				Ref pending;
+				for (uint8_t i = 0; i < node->fixed_node.arg_count; i++) {
+					auto& arg = node->fixed_node.args[i];
+					if (numbered(arg) && !numbers.contains(arg)) {
+						pending = arg;
+						break;
+					}
+				}
+				if (pending) {
+					stack.push_back(pending);
+					continue;
+				}
+
+				Key key{ .kind = node->kind, .op = 0, .type = Type::stripped(top.type())->hash_value, .a = {}, .b = {}, .value = 0 };
+				switch (node->kind) {
+				case Node::CONSTANT:
+					memcpy(&key.value, node->constant.value, top.type()->size);
+					break;
+				case Node::MATH_BINARY:
+					key.op = (uint32_t)node->math_binary.op;
+					key.a = canonical(node->math_binary.a);
+					key.b = canonical(node->math_binary.b);
+					break;
+				case Node::EXTRACT:
+					key.a = canonical(node->extract.composite);
+					key.b = canonical(node->extract.index);
+					break;
+				case Node::CAST:
+					key.a = canonical(node->cast.src);
+					break;
+				default:
+					assert(0);
+				}
+				auto [it, _] = table.try_emplace(key, top);
+				numbers.emplace(top, it->second);
+				stack.pop_back();
+			}
+			return numbers.at(ref);
+		}
+	};
+
+	// merge structurally identical pure nodes
+	Result<void> Compiler::value_numbering() {
+		PhaseTimer _(impl->stats.value_numbering, "value_numbering");
+		ValueNumbering vn(std::pmr::polymorphic_allocator<std::byte>(&impl->mbr));
+
+		rewrite([&](Node* node, auto& replaces) {
+			auto ref = first(node);
+			if (!ValueNumbering::numbered(ref)) {
+				return;
+			}
+			impl->stats.value_numbering.count++;
+			auto canonical = vn.number(ref);
+			if (canonical != ref) {
+				replaces.replace(ref, canonical);
+				impl->stats.merged_nodes++;
+			}
+		});
 		return { expected_value };
 	}
 
 	Result<void> Compiler::compile(std::span<std::shared_ptr<ExtNode>> nodes, const RenderGraphCompileOptions& compile_options) {
+		TraceScope _(TraceCategory::eCompile, "compile");
+		size_t heap_allocations = impl->heap.allocations + impl->mbr.storage_allocations;
 		reset();
+		impl->stats = {};
 		impl->callbacks = compile_options.callbacks;
+		impl->read_layout_policy = compile_options.read_layout_policy;
+		impl->recording_task_runner = compile_options.recording_task_runner;
 		GraphDumper::begin_graph(compile_options.dump_graph, compile_options.graph_label);
 
 		impl->refs.assign(nodes.begin(), nodes.end());
@@ -1393,45 +1733,82 @@ namespace vuk {
 		std::vector<std::shared_ptr<ExtNode>, short_alloc<std::shared_ptr<ExtNode>>> extnode_work_queue(*impl->arena_);
 		extnode_work_queue.assign(nodes.begin(), nodes.end());
 
-		std::unordered_set<IRModule*> modules;
-		modules.emplace(current_module.get());
+		auto& modules = impl->modules;
+		{
+			PhaseTimer _(impl->stats.module_collection, "module_collection");
+			modules.emplace_back(current_module.get());
 
-		while (!extnode_work_queue.empty()) {
-			auto enode = extnode_work_queue.back();
-			extnode_work_queue.pop_back();
-			extnode_work_queue.insert(extnode_work_queue.end(), std::make_move_iterator(enode->deps.begin()), std::make_move_iterator(enode->deps.end()));
-			enode->deps.clear();
+			while (!extnode_work_queue.empty()) {
+				auto enode = extnode_work_queue.back();
+				extnode_work_queue.pop_back();
+				extnode_work_queue.insert(extnode_work_queue.end(), std::make_move_iterator(enode->deps.begin()), std::make_move_iterator(enode->deps.end()));
+				enode->deps.clear();
 
-			modules.emplace(enode->source_module.get());
-			impl->depnodes.push_back(std::move(enode));
+				modules.emplace_back(enode->source_module.get());
+				impl->depnodes.push_back(std::move(enode));
+			}
+			std::sort(modules.begin(), modules.end(), [](IRModule* a, IRModule* b) { return a->module_id < b->module_id; });
+			modules.erase(std::unique(modules.begin(), modules.end()), modules.end());
+			impl->stats.module_collection.count += modules.size();
 		}
 
 		GraphDumper::begin_cluster("fragments");
 		std::pmr::polymorphic_allocator<std::byte> allocator(&impl->mbr);
 
+		std::vector<IRModule*, short_alloc<IRModule*>> linked_modules(*impl->arena_);
 		for (auto& m : modules) {
+			// the module has not changed since it was last collected and linked, so there is nothing to collect or link
+			// every node mutation touches the module owning the node
+			if (m->is_linked() && m->cached_compiles < IRModule::max_cached_compiles) {
+				m->cached_compiles++;
+				impl->stats.cached_modules++;
+				continue;
+			}
+			linked_modules.push_back(m);
+
 			// gc the module
-			m->collect_garbage(allocator);
+			{
+				PhaseTimer _(impl->stats.garbage_collection, "garbage_collection");
+				m->collect_garbage(allocator);
+				impl->stats.garbage_collection.count += m->op_arena.size();
+			}
 
 			// implicit link the module
-			GraphDumper::begin_cluster(std::string("fragments_") + std::to_string(m->module_id));
-			GraphDumper::dump_graph_op(m->op_arena, false, false);
-			GraphDumper::end_cluster();
+			if (GraphDumper::enabled()) {
+				GraphDumper::begin_cluster(std::string("fragments_") + std::to_string(m->module_id));
+				GraphDumper::dump_graph_op(m->op_arena, false, false);
+				GraphDumper::end_cluster();
+			}
 			VUK_DO_OR_RETURN(impl->implicit_linking(m, allocator));
+			// links only live for the duration of linking - this includes the nodes of other modules linked as external nodes
+			// these would otherwise keep stale links while their module is cached
 			for (auto& op : m->op_arena) {
 				op.links = nullptr;
+				apply_generic_args(
+				    [](Ref arg) {
+					    arg.node->links = nullptr;
+					    if (arg.node->kind == Node::SPLICE) {
+						    for (auto& src : arg.node->splice.src) {
+							    src.node->links = nullptr;
+						    }
+					    }
+				    },
+				    &op);
 			}
+			m->mark_linked();
 		}
-		for (auto& m : modules) {
+		for (auto& m : linked_modules) {
 			for (auto& op : m->op_arena) {
 				op.flag = 0;
 			}
 		}
 		GraphDumper::next_cluster("fragments", "modules");
-		for (auto& m : modules) {
-			GraphDumper::begin_cluster(std::string("modules_") + std::to_string(m->module_id));
-			GraphDumper::dump_graph_op(m->op_arena, false, false);
-			GraphDumper::end_cluster();
+		if (GraphDumper::enabled()) {
+			for (auto& m : modules) {
+				GraphDumper::begin_cluster(std::string("modules_") + std::to_string(m->module_id));
+				GraphDumper::dump_graph_op(m->op_arena, false, false);
+				GraphDumper::end_cluster();
+			}
 		}
 
 		std::sort(impl->depnodes.begin(), impl->depnodes.end());
@@ -1445,75 +1822,106 @@ namespace vuk {
 		GraphDumper::dump_graph(impl->nodes, false, false);
 
 		// eliminate useless splices & bridge multiple slices
-		rewrite([&](Node* node, auto& replaces) {
-			switch (node->kind) {
-			case Node::SPLICE: {
-				// splice elimination
-				// an acquire - must be kept
-				if (node->splice.rel_acq != nullptr && node->splice.rel_acq->status != Signal::Status::eDisarmed) {
-					break;
-				}
-
-				// initialise storage
-				if (node->splice.rel_acq != nullptr) {
-					if (!node->splice.values.data()) { // in case of errors, we might still have the allocation hanging around, we can reuse it
-						node->splice.values = { new void*[node->splice.src.size()], node -> splice.src.size() };
-					} else {
-						assert(node->splice.values.size() == node->splice.src.size());
+		{
+			PhaseTimer _(impl->stats.rewrite, "rewrite");
+			impl->stats.rewrite.count += rewrite([&](Node* node, auto& replaces) {
+				switch (node->kind) {
+				case Node::SPLICE: {
+					// splice elimination
+					// an acquire - must be kept
+					if (node->splice.rel_acq != nullptr && node->splice.rel_acq->status != Signal::Status::eDisarmed) {
+						break;
 					}
-					node->splice.rel_acq->last_use.resize(node->splice.src.size());
 
-					for (size_t i = 0; i < node->splice.src.size(); i++) {
-						auto parm = node->splice.src[i];
-						node->splice.values[i] = new std::byte[parm.type()->size];
+					// initialise storage
+					if (node->splice.rel_acq != nullptr) {
+						if (!node->splice.values.data()) {
+							node->splice.values = { new void*[node->splice.src.size()], node -> splice.src.size() };
+							for (size_t i = 0; i < node->splice.src.size(); i++) {
+								auto parm = node->splice.src[i];
+								node->splice.values[i] = new std::byte[parm.type()->size];
+							}
+						} else { // in case of errors or repeated compiles, we might still have the allocation hanging around, we can reuse it
+							assert(node->splice.values.size() == node->splice.src.size());
+						}
+						node->splice.rel_acq->last_use.resize(node->splice.src.size());
 					}
-				}
 
-				// a release - must be kept
-				if (!(node->splice.dst_access == Access::eNone && node->splice.dst_domain == DomainFlagBits::eAny)) {
-					break;
-				}
+					// a release - must be kept
+					if (!(node->splice.dst_access == Access::eNone && node->splice.dst_domain == DomainFlagBits::eAny)) {
+						break;
+					}
 
-				for (size_t i = 0; i < node->splice.src.size(); i++) {
-					auto needle = Ref{ node, i };
-					auto parm = node->splice.src[i];
+					uint32_t slot = ~0u;
+					for (size_t i = 0; i < node->splice.src.size(); i++) {
+						auto needle = Ref{ node, i };
+						auto parm = node->splice.src[i];
 
-					// a splice that requires signalling -> defer it
-					if (node->splice.rel_acq != nullptr) {
-						// find last use that is not splice that we defer away
-						auto link = &parm.link();
-						while (link->next) {
-							link = link->next;
-						}
-						Node* last_use = nullptr;
-						while (link) {
-							if (link->reads.size() > 0) { // splices never read
-								last_use = link->reads.to_span(impl->pass_reads)[0].node;
-								break;
+						// a splice that requires signalling -> defer it
+						if (node->splice.rel_acq != nullptr) {
+							// find last use that is not splice that we defer away
+							auto link = &parm.link();
+							while (link->next) {
+								link = link->next;
 							}
-							if (link->def.node->kind == Node::SPLICE && (node->splice.rel_acq == nullptr || node->splice.rel_acq->status == Signal::Status::eDisarmed)) {
-								;
-							} else {
-								last_use = link->def.node;
-								break;
+							Node* last_use = nullptr;
+							while (link) {
+								if (link->reads.size() > 0) { // splices never read
+									last_use = link->reads.to_span(impl->pass_reads)[0].node;
+									break;
+								}
+								if (link->def.node->kind == Node::SPLICE && (node->splice.rel_acq == nullptr || node->splice.rel_acq->status == Signal::Status::eDisarmed)) {
+									;
+								} else {
+									last_use = link->def.node;
+									break;
+								}
+								link = link->prev;
+							}
+							assert(last_use);
+							if (slot == ~0u) {
+								slot = (uint32_t)impl->pending_splice_sigs.size();
+								impl->pending_splice_sigs.push_back(0);
 							}
-							link = link->prev;
+							impl->deferred_splices.push_back({ last_use, needle, slot });
 						}
-						assert(last_use);
-						impl->deferred_splices[last_use].push_back(needle);
-						impl->pending_splice_sigs[needle.node] = 0;
 					}
-				}
-			} break;
-			case Node::SLICE: {
-				auto& slice = node->slice;
-				Subrange::Image our_slice_range = { constant<uint32_t>(slice.base_level),
-					                                  constant<uint32_t>(slice.level_count),
-					                                  constant<uint32_t>(slice.base_layer),
-					                                  constant<uint32_t>(slice.layer_count) };
-				// walk up
-				auto link = &node->slice.image.link();
-				do {
+				} break;
+				case Node::SLICE: {
+					auto& slice = node->slice;
+					Subrange::Image our_slice_range = { constant<uint32_t>(slice.base_level),
+						                                  constant<uint32_t>(slice.level_count),
+						                                  constant<uint32_t>(slice.base_layer),
+						                                  constant<uint32_t>(slice.layer_count) };
+					// walk up
+					auto link = &node->slice.image.link();
+					do {
+						if (link->def.node->kind == Node::SLICE) { // it is a slice
+							Subrange::Image their_slice_range = { constant<uint32_t>(link->def.node->slice.base_level),
+								                                    constant<uint32_t>(link->def.node->slice.level_count),
+								                                    constant<uint32_t>(link->def.node->slice.base_layer),
+								                                    constant<uint32_t>(link->def.node->slice.layer_count) };
+							if (link->def.index == 0) { //  and we took left
+								auto isect = intersect_one(our_slice_range, their_slice_range);
+								if (isect == our_slice_range) {
+									replaces.replace(first(node), node->slice.image);
+									replaces.replace(nth(node, 1), node->slice.image);
+									break;
+								}
+							} else { //  and we took right
+								auto isect = intersect_one(our_slice_range, their_slice_range);
+								if (isect == our_slice_range) {
+									replaces.replace(first(node), node->slice.image);
+									replaces.replace(nth(node, 1), node->slice.image);
+									break;
+								}
+							}
+						}
+						if (!link->prev) {
+							break;
+						}
+						link = link->prev;
+					} while (link->prev);
 					if (link->def.node->kind == Node::SLICE) { // it is a slice
 						Subrange::Image their_slice_range = { constant<uint32_t>(link->def.node->slice.base_level),
 							                                    constant<uint32_t>(link->def.node->slice.level_count),
@@ -1535,36 +1943,26 @@ namespace vuk {
 							}
 						}
 					}
-					if (!link->prev) {
-						break;
-					}
-					link = link->prev;
-				} while (link->prev);
-				if (link->def.node->kind == Node::SLICE) { // it is a slice
-					Subrange::Image their_slice_range = { constant<uint32_t>(link->def.node->slice.base_level),
-						                                    constant<uint32_t>(link->def.node->slice.level_count),
-						                                    constant<uint32_t>(link->def.node->slice.base_layer),
-						                                    constant<uint32_t>(link->def.node->slice.layer_count) };
-					if (link->def.index == 0) { //  and we took left
-						auto isect = intersect_one(our_slice_range, their_slice_range);
-						if (isect == our_slice_range) {
-							replaces.replace(first(node), node->slice.image);
-							replaces.replace(nth(node, 1), node->slice.image);
-							break;
-						}
-					} else { //  and we took right
-						auto isect = intersect_one(our_slice_range, their_slice_range);
-						if (isect == our_slice_range) {
-							replaces.replace(first(node), node->slice.image);
-							replaces.replace(nth(node, 1), node->slice.image);
-							break;
-						}
-					}
+				} break;
+				default:
+					break;
 				}
-			} break;
-			default:
-				break;
-			}
+			});
+		}
+
+		// fold scalar computations on constants, then merge identical scalar computations
+		// folding creates new CONSTANTs, these need to be collected before numbering
+		auto folded_before = impl->stats.folded_nodes;
+		VUK_DO_OR_RETURN(constant_folding());
+		if (impl->stats.folded_nodes != folded_before) {
+			VUK_DO_OR_RETURN(impl->build_nodes());
+		}
+		VUK_DO_OR_RETURN(value_numbering());
+
+		// group deferred splices by their signaller for lookup during execution, keeping the order they were deferred in
+		// (std::stable_sort takes its buffer from the heap)
+		std::sort(impl->deferred_splices.begin(), impl->deferred_splices.end(), [](auto& a, auto& b) {
+			return a.signaller < b.signaller || (a.signaller == b.signaller && (a.slot < b.slot || (a.slot == b.slot && a.splice.index < b.splice.index)));
 		});
 
 		VUK_DO_OR_RETURN(impl->build_nodes());
@@ -1579,8 +1977,12 @@ namespace vuk {
 		GraphDumper::end_graph();
 		//_dump_graph(impl->nodes, false, false);
 
-		VUK_DO_OR_RETURN(validate_read_undefined());
-		VUK_DO_OR_RETURN(validate_duplicated_resource_ref());
+		{
+			PhaseTimer _(impl->stats.validation, "validation");
+			impl->stats.validation.count += impl->nodes.size();
+			VUK_DO_OR_RETURN(validate_read_undefined());
+			VUK_DO_OR_RETURN(validate_duplicated_resource_ref());
+		}
 
 		VUK_DO_OR_RETURN(impl->collect_chains());
 		VUK_DO_OR_RETURN(impl->reify_inference());
@@ -1614,6 +2016,9 @@ namespace vuk {
 
 		VUK_DO_OR_RETURN(impl->build_sync());
 
+		impl->mbr.prepare();
+		impl->stats.heap_allocations = impl->heap.allocations + impl->mbr.storage_allocations - heap_allocations;
+
 		return { expected_value };
 	}
 
@@ -1631,6 +2036,14 @@ namespace vuk {
 		return impl->get_value(parm);
 	}
 
+	const CompileStats& Compiler::get_compile_stats() const {
+		return impl->stats;
+	}
+
+	const ExecuteStats& Compiler::get_execute_stats() const {
+		return impl->execute_stats;
+	}
+
 	ImageUsageFlags Compiler::compute_usage(const ChainLink* head) {
 		return impl->compute_usage(head);
 	}
@@ -0,0 +1,175 @@
+#include "vuk/Trace.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <fmt/format.h>
+#include <memory>
+#include <robin_hood.h>
+
+namespace {
+	struct TraceBuffer {
+		std::unique_ptr<vuk::TraceEvent[]> events;
+		size_t capacity = 0;
+		std::atomic<uint64_t> head = 0; // total number of events recorded since enable()
+	};
+
+	TraceBuffer trace_buffer;
+	std::atomic<uint32_t> next_thread_id = 0;
+
+	uint32_t current_thread_id() noexcept {
+		thread_local uint32_t id = next_thread_id.fetch_add(1, std::memory_order_relaxed);
+		return id;
+	}
+
+	const char* category_name(vuk::TraceCategory category) noexcept {
+		switch (category) {
+		case vuk::TraceCategory::eCompile:
+			return "compile";
+		case vuk::TraceCategory::eSchedule:
+			return "schedule";
+		case vuk::TraceCategory::eAllocation:
+			return "allocation";
+		case vuk::TraceCategory::eBarrier:
+			return "barrier";
+		case vuk::TraceCategory::eCommandBuffer:
+			return "command_buffer";
+		case vuk::TraceCategory::eSubmit:
+			return "submit";
+		case vuk::TraceCategory::eWait:
+			return "wait";
+		}
+		return "";
+	}
+
+	void append_json_string(std::string& out, const char* str) {
+		out += '"';
+		for (auto c = str; *c; c++) {
+			switch (*c) {
+			case '"':
+				out += "\\\"";
+				break;
+			case '\\':
+				out += "\\\\";
+				break;
+			default:
+				if ((unsigned char)*c < 0x20) {
+					out += fmt::format("\\u{:04x}", (unsigned)*c);
+				} else {
+					out += *c;
+				}
+			}
+		}
+		out += '"';
+	}
+} // namespace
+
+namespace vuk::trace {
+	namespace detail {
+		std::atomic<bool> enabled = false;
+	}
+
+	void enable(size_t capacity) {
+		assert(capacity > 0);
+		if (trace_buffer.capacity != capacity) {
+			trace_buffer.events = std::make_unique<TraceEvent[]>(capacity);
+			trace_buffer.capacity = capacity;
+		}
+		trace_buffer.head.store(0, std::memory_order_relaxed);
+		detail::enabled.store(true, std::memory_order_release);
+	}
+
+	void disable() {
+		detail::enabled.store(false, std::memory_order_release);
+	}
+
+	void record(TracePhase phase, TraceCategory category, const char* name, uint64_t arg) noexcept {
+		if (!is_enabled()) {
+			return;
+		}
+		auto timestamp = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		auto slot = trace_buffer.head.fetch_add(1, std::memory_order_relaxed) % trace_buffer.capacity;
+		trace_buffer.events[slot] = TraceEvent{ timestamp, name, arg, current_thread_id(), category, phase };
+	}
+
+	std::vector<TraceEvent> snapshot() {
+		std::vector<TraceEvent> events;
+		auto head = trace_buffer.head.load(std::memory_order_acquire);
+		if (trace_buffer.capacity == 0 || head == 0) {
+			return events;
+		}
+		auto count = std::min<uint64_t>(head, trace_buffer.capacity);
+		events.reserve(count);
+		for (auto i = head - count; i < head; i++) {
+			events.push_back(trace_buffer.events[i % trace_buffer.capacity]);
+		}
+		// threads race for slots, so the ring is only approximately in time order
+		std::stable_sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) { return a.timestamp < b.timestamp; });
+		return events;
+	}
+
+	std::string export_chrome_json() {
+		auto events = snapshot();
+
+		// per thread stack of open scopes, to keep the exported events properly nested
+		robin_hood::unordered_flat_map<uint32_t, std::vector<const TraceEvent*>> open_scopes;
+		robin_hood::unordered_flat_map<uint32_t, uint64_t> last_timestamps;
+
+		std::string out = "{\"traceEvents\":[";
+		bool first = true;
+		auto emit = [&](const TraceEvent& ev, TracePhase phase, uint64_t timestamp, bool with_arg) {
+			if (!first) {
+				out += ',';
+			}
+			first = false;
+			out += "\n{\"name\":";
+			append_json_string(out, ev.name ? ev.name : "");
+			out += fmt::format(",\"cat\":\"{}\",\"ph\":\"{}\",\"ts\":{}.{:03},\"pid\":0,\"tid\":{}",
+			                   category_name(ev.category),
+			                   phase == TracePhase::eBegin ? "B" : phase == TracePhase::eEnd ? "E" : "i",
+			                   timestamp / 1000,
+			                   timestamp % 1000,
+			                   ev.thread_id);
+			if (phase == TracePhase::eInstant) {
+				out += ",\"s\":\"t\"";
+			}
+			if (with_arg) {
+				out += fmt::format(",\"args\":{{\"value\":{}}}", ev.arg);
+			}
+			out += '}';
+		};
+
+		for (auto& ev : events) {
+			last_timestamps[ev.thread_id] = ev.timestamp;
+			auto& stack = open_scopes[ev.thread_id];
+			switch (ev.phase) {
+			case TracePhase::eBegin:
+				stack.push_back(&ev);
+				emit(ev, TracePhase::eBegin, ev.timestamp, true);
+				break;
+			case TracePhase::eEnd:
+				// the begin was overwritten in the ring buffer
+				if (stack.empty()) {
+					break;
+				}
+				stack.pop_back();
+				emit(ev, TracePhase::eEnd, ev.timestamp, false);
+				break;
+			case TracePhase::eInstant:
+				emit(ev, TracePhase::eInstant, ev.timestamp, true);
+				break;
+			}
+		}
+
+		// close scopes that were still open when the snapshot was taken
+		for (auto& [thread_id, stack] : open_scopes) {
+			while (!stack.empty()) {
+				emit(*stack.back(), TracePhase::eEnd, last_timestamps[thread_id], false);
+				stack.pop_back();
+			}
+		}
+
+		out += "\n],\"displayTimeUnit\":\"ns\"}\n";
+		return out;
+	}
+} // namespace vuk::trace
@@ -0,0 +1,190 @@
+#include "vuk/runtime/ThreadPoolExecutor.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace vuk {
+	struct ThreadPoolExecutorImpl {
+		struct Worker {
+			std::mutex mutex;
+			std::deque<size_t> ready; // the owner takes from the back, thieves from the front
+		};
+
+		std::unique_ptr<Worker[]> workers; // the spawned threads, then the waiting thread
+		size_t worker_count;
+		std::vector<std::thread> threads;
+
+		std::mutex graph_lock; // held while a task graph runs
+
+		// the task graph being run
+		std::span<ThreadPoolExecutor::Task> tasks;
+		std::unique_ptr<std::atomic<uint32_t>[]> dependency_counts;
+		std::atomic<size_t> remaining = 0;
+
+		// sleeping when there is nothing to take or steal
+		std::mutex sleep_mutex;
+		std::condition_variable wake;
+		std::atomic<size_t> ready_count = 0;
+		bool stop = false;
+
+		void push(size_t worker, size_t task) {
+			{
+				std::lock_guard _(workers[worker].mutex);
+				workers[worker].ready.push_back(task);
+			}
+			ready_count.fetch_add(1, std::memory_order_release);
+			std::lock_guard _(sleep_mutex);
+			wake.notify_one();
+		}
+
+		bool pop(size_t worker, size_t& task) {
+			auto& w = workers[worker];
+			std::lock_guard _(w.mutex);
+			if (w.ready.empty()) {
+				return false;
+			}
+			task = w.ready.back();
+			w.ready.pop_back();
+			ready_count.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		bool steal(size_t worker, size_t& task) {
+			for (size_t i = 1; i < worker_count; i++) {
+				auto& victim = workers[(worker + i) % worker_count];
+				std::lock_guard _(victim.mutex);
+				if (victim.ready.empty()) {
+					continue;
+				}
+				task = victim.ready.front();
+				victim.ready.pop_front();
+				ready_count.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+			return false;
+		}
+
+		bool take(size_t worker, size_t& task) {
+			return pop(worker, task) || steal(worker, task);
+		}
+
+		void execute(size_t worker, size_t index) {
+			auto& task = tasks[index];
+			task.run(worker);
+			// dependents made ready here are likely to use the results of this task, so they stay with this worker
+			for (auto dependent : task.dependents) {
+				if (dependency_counts[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+					push(worker, dependent);
+				}
+			}
+			if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				std::lock_guard _(sleep_mutex);
+				wake.notify_all();
+			}
+		}
+
+		void work(size_t worker) {
+			while (true) {
+				size_t task;
+				if (take(worker, task)) {
+					execute(worker, task);
+					continue;
+				}
+				std::unique_lock lock(sleep_mutex);
+				wake.wait(lock, [&] { return stop || ready_count.load(std::memory_order_acquire) > 0; });
+				if (stop) {
+					return;
+				}
+			}
+		}
+	};
+
+	ThreadPoolExecutor::ThreadPoolExecutor(size_t thread_count) :
+	    Executor(Executor::Type::eThreadPool, DomainFlagBits::eHost, 0),
+	    impl(new ThreadPoolExecutorImpl) {
+		impl->worker_count = thread_count + 1;
+		impl->workers = std::make_unique<ThreadPoolExecutorImpl::Worker[]>(impl->worker_count);
+		for (size_t i = 0; i < thread_count; i++) {
+			impl->threads.emplace_back([impl = impl.get(), i] { impl->work(i); });
+		}
+	}
+
+	ThreadPoolExecutor::~ThreadPoolExecutor() {
+		{
+			std::lock_guard _(impl->sleep_mutex);
+			impl->stop = true;
+		}
+		impl->wake.notify_all();
+		for (auto& thread : impl->threads) {
+			thread.join();
+		}
+	}
+
+	void ThreadPoolExecutor::lock() {
+		impl->graph_lock.lock();
+	}
+
+	void ThreadPoolExecutor::unlock() {
+		impl->graph_lock.unlock();
+	}
+
+	Result<void> ThreadPoolExecutor::wait_idle() {
+		// task graphs complete before run_graph returns
+		std::lock_guard _(impl->graph_lock);
+		return { expected_value };
+	}
+
+	void ThreadPoolExecutor::run_graph(std::span<Task> tasks) {
+		if (tasks.empty()) {
+			return;
+		}
+		std::lock_guard _(impl->graph_lock);
+		impl->tasks = tasks;
+		impl->dependency_counts = std::make_unique<std::atomic<uint32_t>[]>(tasks.size());
+		for (size_t i = 0; i < tasks.size(); i++) {
+			impl->dependency_counts[i].store(tasks[i].dependency_count, std::memory_order_relaxed);
+		}
+		impl->remaining.store(tasks.size(), std::memory_order_release);
+
+		// spread the initially ready tasks over the workers
+		size_t next_worker = 0;
+		for (size_t i = 0; i < tasks.size(); i++) {
+			if (tasks[i].dependency_count == 0) {
+				impl->push(next_worker, i);
+				next_worker = (next_worker + 1) % impl->worker_count;
+			}
+		}
+
+		auto self = impl->worker_count - 1;
+		while (impl->remaining.load(std::memory_order_acquire) > 0) {
+			size_t task;
+			if (impl->take(self, task)) {
+				impl->execute(self, task);
+				continue;
+			}
+			std::unique_lock lock(impl->sleep_mutex);
+			impl->wake.wait(lock, [&] {
+				return impl->ready_count.load(std::memory_order_acquire) > 0 || impl->remaining.load(std::memory_order_acquire) == 0;
+			});
+		}
+		impl->tasks = {};
+		impl->dependency_counts.reset();
+	}
+
+	size_t ThreadPoolExecutor::worker_count() {
+		return impl->worker_count;
+	}
+
+	void ThreadPoolExecutor::run(size_t count, void (*task)(void* task_data, size_t index, size_t worker), void* task_data) {
+		std::vector<Task> tasks(count);
+		for (size_t i = 0; i < count; i++) {
+			tasks[i].run = [=](size_t worker) {
+				task(task_data, i, worker);
+			};
+		}
+		run_graph(tasks);
+	}
+} // namespace vuk
@@ -2,30 +2,29 @@
 #include "vuk/IRProcess.hpp"
 #include "vuk/RenderGraph.hpp"
 #include "vuk/SyncLowering.hpp"
+#include "vuk/Trace.hpp"
 #include "vuk/Util.hpp"
 #include "vuk/Value.hpp"
 #include "vuk/runtime/Cache.hpp"
 #include "vuk/runtime/CommandBuffer.hpp"
 #include "vuk/runtime/Stream.hpp"
+#include "vuk/runtime/ThreadPoolExecutor.hpp"
 #include "vuk/runtime/vk/AllocatorHelpers.hpp"
+#include "vuk/runtime/vk/DeviceLinearResource.hpp"
 #include "vuk/runtime/vk/VkQueueExecutor.hpp"
 #include "vuk/runtime/vk/VkRuntime.hpp"
 
+#include <bit>
+#include <cstring>
 #include <fmt/format.h>
 #include <mutex>
 #include <sstream>
-#include <unordered_set>
 #include <vector>
 
 // #define VUK_DUMP_EXEC
 // #define VUK_DEBUG_IMBAR
 // #define VUK_DEBUG_MEMBAR
 
-#define CONCAT(a, b)       CONCAT_INNER(a, b)
-#define CONCAT_INNER(a, b) a##b
-
-#define UNIQUE_NAME(base) CONCAT(base, __LINE__)
-
 namespace vuk {
 	std::string format_source_location(SourceLocationAtFrame& source) {
 		return fmt::format("{}({}): ", source.location.file_name(), source.location.line());
@@ -141,6 +140,10 @@ namespace vuk {
 
 	ExecutableRenderGraph::~ExecutableRenderGraph() {}
 
+	const ExecuteStats& ExecutableRenderGraph::get_execute_stats() const {
+		return impl->execute_stats;
+	}
+
 	struct RenderPassInfo {
 		std::vector<VkImageView> framebuffer_ivs;
 		RenderPassCreateInfo rpci;
@@ -179,11 +182,413 @@ namespace vuk {
 		cobuf.ongoing_render_pass = rpi;
 	}
 
+	// a graph-declared image written by parm that is neither read, consumed nor held afterwards - its contents need not be stored
+	bool is_dead_after_write(Ref parm) {
+		if (!parm.node->links) {
+			return false;
+		}
+		// a slice is a partial view - the rest of the image, and the contents of this part once converged, live on in other chains
+		auto head = &parm.link();
+		while (head->prev) {
+			head = head->prev;
+		}
+		if (!head->def || head->def.node->kind == Node::SLICE) {
+			return false;
+		}
+		auto def = get_def2(parm);
+		if (!def || def->node->kind != Node::CONSTRUCT) {
+			return false;
+		}
+		auto out = parm.link().next;
+		return out && !out->undef && !out->next && out->reads.size() == 0 && out->nops.size() == 0 && out->child_chains.size() == 0;
+	}
+
+	template<class A, class B>
+	bool same_scopes(const A& a, const B& b) {
+		return a.srcStageMask == b.srcStageMask && a.srcAccessMask == b.srcAccessMask && a.dstStageMask == b.dstStageMask && a.dstAccessMask == b.dstAccessMask;
+	}
+
+	// the dependency of a includes the dependency of b
+	template<class A, class B>
+	bool implies(const A& a, const B& b) {
+		return (b.srcStageMask & ~a.srcStageMask) == 0 && (b.srcAccessMask & ~a.srcAccessMask) == 0 && (b.dstStageMask & ~a.dstStageMask) == 0 &&
+		       (b.dstAccessMask & ~a.dstAccessMask) == 0;
+	}
+
+	template<class A, class B>
+	void union_scopes(A& a, const B& b) {
+		a.srcStageMask |= b.srcStageMask;
+		a.srcAccessMask |= b.srcAccessMask;
+		a.dstStageMask |= b.dstStageMask;
+		a.dstAccessMask |= b.dstAccessMask;
+	}
+
+	// a barrier without a layout transition or an ownership transfer only makes memory available and visible - a memory barrier can do the same
+	bool is_memory_only(const VkImageMemoryBarrier2KHR& bar) {
+		return bar.oldLayout == bar.newLayout && bar.srcQueueFamilyIndex == bar.dstQueueFamilyIndex;
+	}
+
+	bool is_memory_only(const VkBufferMemoryBarrier2KHR& bar) {
+		return bar.srcQueueFamilyIndex == bar.dstQueueFamilyIndex;
+	}
+
+	Subrange::Image to_subrange(const VkImageSubresourceRange& range) {
+		return { range.baseMipLevel, range.levelCount, range.baseArrayLayer, range.layerCount };
+	}
+
+	// pairwise fold of the barriers of a batch: fold(a, b) folds b into a and returns true if b can be removed
+	template<class T, class F>
+	void fold_barriers(std::vector<T>& bars, F&& fold) {
+		for (size_t i = 0; i < bars.size(); i++) {
+			for (size_t j = i + 1; j < bars.size();) {
+				if (fold(bars[i], bars[j])) {
+					bars.erase(bars.begin() + j);
+					// a grown barrier might fold barriers we have already passed
+					j = i + 1;
+				} else {
+					j++;
+				}
+			}
+		}
+	}
+
+	void coalesce_barriers(std::vector<VkMemoryBarrier2KHR>& mem_bars,
+	                       std::vector<VkBufferMemoryBarrier2KHR>& buf_bars,
+	                       std::vector<VkImageMemoryBarrier2KHR>& im_bars,
+	                       CoalescedBarriers& result) {
+		fold_barriers(mem_bars, [&](VkMemoryBarrier2KHR& a, VkMemoryBarrier2KHR& b) {
+			if (implies(a, b)) {
+				result.dropped++;
+				return true;
+			}
+			if (implies(b, a)) {
+				a = b;
+				result.dropped++;
+				return true;
+			}
+			// a shared first or second scope makes the union exact
+			if ((a.srcStageMask == b.srcStageMask && a.srcAccessMask == b.srcAccessMask) || (a.dstStageMask == b.dstStageMask && a.dstAccessMask == b.dstAccessMask)) {
+				union_scopes(a, b);
+				result.merged++;
+				return true;
+			}
+			return false;
+		});
+
+		auto implied_by_memory_barrier = [&](const auto& bar) {
+			return is_memory_only(bar) && std::any_of(mem_bars.begin(), mem_bars.end(), [&](const VkMemoryBarrier2KHR& mb) { return implies(mb, bar); });
+		};
+
+		result.dropped += std::erase_if(buf_bars, implied_by_memory_barrier);
+		fold_barriers(buf_bars, [&](VkBufferMemoryBarrier2KHR& a, VkBufferMemoryBarrier2KHR& b) {
+			if (a.buffer != b.buffer || a.srcQueueFamilyIndex != b.srcQueueFamilyIndex || a.dstQueueFamilyIndex != b.dstQueueFamilyIndex) {
+				return false;
+			}
+			Subrange::Buffer ra{ a.offset, a.size };
+			Subrange::Buffer rb{ b.offset, b.size };
+			if (ra == rb) {
+				union_scopes(a, b);
+				result.merged++;
+				return true;
+			}
+			if (auto isection = intersect_one(ra, rb)) {
+				if (*isection == rb && implies(a, b)) {
+					result.dropped++;
+					return true;
+				}
+				if (*isection == ra && implies(b, a)) {
+					a = b;
+					result.dropped++;
+					return true;
+				}
+			} else if (same_scopes(a, b)) {
+				if (auto merged = merge_one(ra, rb)) {
+					a.offset = merged->offset;
+					a.size = merged->size;
+					result.merged++;
+					return true;
+				}
+			}
+			return false;
+		});
+
+		result.dropped += std::erase_if(im_bars, implied_by_memory_barrier);
+		fold_barriers(im_bars, [&](VkImageMemoryBarrier2KHR& a, VkImageMemoryBarrier2KHR& b) {
+			if (a.image != b.image || a.subresourceRange.aspectMask != b.subresourceRange.aspectMask || a.oldLayout != b.oldLayout || a.newLayout != b.newLayout ||
+			    a.srcQueueFamilyIndex != b.srcQueueFamilyIndex || a.dstQueueFamilyIndex != b.dstQueueFamilyIndex) {
+				return false;
+			}
+			auto ra = to_subrange(a.subresourceRange);
+			auto rb = to_subrange(b.subresourceRange);
+			if (ra == rb) {
+				union_scopes(a, b);
+				result.merged++;
+				return true;
+			}
+			if (auto isection = intersect_one(ra, rb)) {
+				if (*isection == rb && implies(a, b)) {
+					result.dropped++;
+					return true;
+				}
+				if (*isection == ra && implies(b, a)) {
+					a = b;
+					result.dropped++;
+					return true;
+				}
+			} else if (same_scopes(a, b)) {
+				if (auto merged = merge_one(ra, rb)) {
+					a.subresourceRange.baseMipLevel = merged->base_level;
+					a.subresourceRange.levelCount = merged->level_count;
+					a.subresourceRange.baseArrayLayer = merged->base_layer;
+					a.subresourceRange.layerCount = merged->layer_count;
+					result.merged++;
+					return true;
+				}
+			}
+			return false;
+		});
+	}
+
+	// images and buffers (and arrays of them) are synchronized in place, which updates their layout as later passes are scheduled
+	bool is_synchronized_in_place(Type* ty) {
+		if (ty->kind == Type::ARRAY_TY) {
+			return is_synchronized_in_place(ty->array.T->get());
+		}
+		return ty->hash_value == current_module->types.builtin_image || ty->hash_value == current_module->types.builtin_buffer ||
+		       ty->hash_value == current_module->types.builtin_sampled_image;
+	}
+
+	// the VkBuffer and VkImage handles an argument refers to - commands recorded against them are invalid once they are destroyed
+	void collect_handles(Type* ty, void* value, std::vector<uint64_t>& handles) {
+		if (ty->kind == Type::ARRAY_TY) {
+			auto elem_ty = ty->array.T->get();
+			auto elems = reinterpret_cast<std::byte*>(value);
+			for (size_t i = 0; i < ty->array.count; i++) {
+				collect_handles(elem_ty, elems, handles);
+				elems += elem_ty->size;
+			}
+		} else if (ty->hash_value == current_module->types.builtin_image) {
+			handles.push_back(reinterpret_cast<uint64_t>(reinterpret_cast<ImageAttachment*>(value)->image.image));
+		} else if (ty->hash_value == current_module->types.builtin_sampled_image) {
+			handles.push_back(reinterpret_cast<uint64_t>(reinterpret_cast<SampledImage*>(value)->ia.image.image));
+		} else if (ty->hash_value == current_module->types.builtin_buffer) {
+			handles.push_back(reinterpret_cast<uint64_t>(reinterpret_cast<Buffer*>(value)->buffer));
+		}
+	}
+
+	void collect_image_key_fields(const ImageAttachment& ia, std::vector<uint64_t>& fields) {
+		fields.insert(fields.end(),
+		              { reinterpret_cast<uint64_t>(ia.image.image),
+		                ia.image_view.id,
+		                reinterpret_cast<uint64_t>(ia.image_view.payload),
+		                (uint64_t)ia.image_flags.m_mask,
+		                (uint64_t)ia.image_type,
+		                (uint64_t)ia.tiling,
+		                (uint64_t)ia.usage.m_mask,
+		                ia.extent.width,
+		                ia.extent.height,
+		                ia.extent.depth,
+		                (uint64_t)ia.format,
+		                (uint64_t)ia.sample_count.count,
+		                (uint64_t)ia.image_view_flags.m_mask,
+		                (uint64_t)ia.view_type,
+		                (uint64_t)ia.components.r,
+		                (uint64_t)ia.components.g,
+		                (uint64_t)ia.components.b,
+		                (uint64_t)ia.components.a,
+		                (uint64_t)ia.layout,
+		                ia.base_level,
+		                ia.level_count,
+		                ia.base_layer,
+		                ia.layer_count });
+	}
+
+	void collect_sampler_key_fields(const SamplerCreateInfo& sci, std::vector<uint64_t>& fields) {
+		fields.insert(fields.end(),
+		              { (uint64_t)sci.flags.m_mask,
+		                (uint64_t)sci.magFilter,
+		                (uint64_t)sci.minFilter,
+		                (uint64_t)sci.mipmapMode,
+		                (uint64_t)sci.addressModeU,
+		                (uint64_t)sci.addressModeV,
+		                (uint64_t)sci.addressModeW,
+		                std::bit_cast<uint32_t>(sci.mipLodBias),
+		                sci.anisotropyEnable,
+		                std::bit_cast<uint32_t>(sci.maxAnisotropy),
+		                sci.compareEnable,
+		                (uint64_t)sci.compareOp,
+		                std::bit_cast<uint32_t>(sci.minLod),
+		                std::bit_cast<uint32_t>(sci.maxLod),
+		                (uint64_t)sci.borderColor,
+		                sci.unnormalizedCoordinates });
+	}
+
+	// the fields of an argument that the recorded commands depend on - compared and hashed field by field, as the padding of the values is indeterminate
+	void collect_key_fields(Type* ty, void* value, std::vector<uint64_t>& fields) {
+		if (ty->kind == Type::ARRAY_TY) {
+			auto elem_ty = ty->array.T->get();
+			auto elems = reinterpret_cast<std::byte*>(value);
+			for (size_t i = 0; i < ty->array.count; i++) {
+				collect_key_fields(elem_ty, elems, fields);
+				elems += elem_ty->size;
+			}
+		} else if (ty->hash_value == current_module->types.builtin_image) {
+			collect_image_key_fields(*reinterpret_cast<ImageAttachment*>(value), fields);
+		} else if (ty->hash_value == current_module->types.builtin_sampled_image) {
+			auto& si = *reinterpret_cast<SampledImage*>(value);
+			collect_image_key_fields(si.ia, fields);
+			collect_sampler_key_fields(si.sci, fields);
+		} else if (ty->hash_value == current_module->types.builtin_buffer) {
+			auto& buf = *reinterpret_cast<Buffer*>(value);
+			fields.insert(fields.end(), { reinterpret_cast<uint64_t>(buf.buffer), (uint64_t)buf.offset, (uint64_t)buf.size });
+		} else {
+			// scalars have no padding, their bytes are the fields
+			auto bytes = reinterpret_cast<const std::byte*>(value);
+			for (size_t offset = 0; offset < ty->size; offset += sizeof(uint64_t)) {
+				uint64_t field = 0;
+				memcpy(&field, bytes + offset, std::min(sizeof(uint64_t), ty->size - offset));
+				fields.push_back(field);
+			}
+		}
+	}
+
+	// command buffers of passes marked to reuse commands, by the pass, its bound resources and the pipeline generation
+	struct CommandBufferCache : DestructionListener {
+		// everything the recorded commands depend on - the hash only selects the candidate entry
+		struct Key {
+			size_t fn_hash;
+			std::string name;
+			uint32_t queue_family;
+			uint64_t pipeline_generation;
+			std::vector<uint64_t> args; // the key fields of the arguments, concatenated
+			bool has_render_pass = false;
+			RenderPassCreateInfo rpci;
+			FramebufferCreateInfo fbci;
+
+			bool operator==(const Key& o) const {
+				if (std::tie(fn_hash, name, queue_family, pipeline_generation, args, has_render_pass) !=
+				    std::tie(o.fn_hash, o.name, o.queue_family, o.pipeline_generation, o.args, o.has_render_pass)) {
+					return false;
+				}
+				// the render pass handle is filled in after the key is made
+				return !has_render_pass || (rpci == o.rpci && std::tie(fbci.flags, fbci.attachments, fbci.width, fbci.height, fbci.layers, fbci.sample_count) ==
+				                                                   std::tie(o.fbci.flags, o.fbci.attachments, o.fbci.width, o.fbci.height, o.fbci.layers, o.fbci.sample_count));
+			}
+		};
+
+		struct Entry {
+			Entry(DeviceResource& upstream, Key key) : resource(upstream), key(std::move(key)) {}
+			~Entry() {
+				if (render_pass != VK_NULL_HANDLE) {
+					resource.deallocate_render_passes(std::span{ &render_pass, 1 });
+				}
+			}
+
+			DeviceLinearResource resource; // owns the command buffer and everything allocated while recording it
+			Key key;
+			std::vector<uint64_t> handles; // buffers and images referenced by the commands
+			VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+			VkRenderPass render_pass = VK_NULL_HANDLE;
+			std::vector<SyncPoint> sync_points; // completion of the last submission that used the entry
+			uint64_t last_use = 0;              // frame of the last use
+		};
+
+		// entries not used for this many frames are destroyed
+		static constexpr uint64_t max_unused_frames = 16;
+
+		CommandBufferCache(Runtime& ctx) : ctx(ctx) {
+			ctx.add_destruction_listener(this);
+		}
+
+		~CommandBufferCache() {
+			ctx.remove_destruction_listener(this);
+			for (auto& [key, entry] : entries) {
+				if (auto res = retire(*entry); !res.holds_value()) {
+					(void)res.error(); // the entries are freed even if their work can't be waited on
+				}
+			}
+		}
+
+		Result<void> retire(Entry& entry) {
+			entry.resource.wait_sync_points(entry.sync_points);
+			return entry.resource.wait();
+		}
+
+		void on_destroy(std::span<const Buffer> buffers) override {
+			std::lock_guard _(destroyed_lock);
+			for (auto& b : buffers) {
+				if (referenced.erase(reinterpret_cast<uint64_t>(b.buffer))) {
+					destroyed.push_back(reinterpret_cast<uint64_t>(b.buffer));
+				}
+			}
+		}
+
+		void on_destroy(std::span<const Image> images) override {
+			std::lock_guard _(destroyed_lock);
+			for (auto& i : images) {
+				if (referenced.erase(reinterpret_cast<uint64_t>(i.image))) {
+					destroyed.push_back(reinterpret_cast<uint64_t>(i.image));
+				}
+			}
+		}
+
+		// track the handles of a new entry, so that their destruction drops it
+		void reference(Entry& entry) {
+			std::lock_guard _(destroyed_lock);
+			for (auto h : entry.handles) {
+				referenced.insert(h);
+			}
+		}
+
+		// drop the entries referencing destroyed handles - must run before a reused handle could match them
+		Result<void> drop_destroyed() {
+			std::vector<uint64_t> handles;
+			{
+				std::lock_guard _(destroyed_lock);
+				handles.swap(destroyed);
+			}
+			if (handles.empty()) {
+				return { expected_value };
+			}
+			for (auto it = entries.begin(); it != entries.end();) {
+				auto& entry_handles = it->second->handles;
+				if (std::any_of(entry_handles.begin(), entry_handles.end(), [&](uint64_t h) { return std::find(handles.begin(), handles.end(), h) != handles.end(); })) {
+					VUK_DO_OR_RETURN(retire(*it->second));
+					it = entries.erase(it);
+				} else {
+					++it;
+				}
+			}
+			return { expected_value };
+		}
+
+		Result<void> collect(uint64_t frame) {
+			VUK_DO_OR_RETURN(drop_destroyed());
+			for (auto it = entries.begin(); it != entries.end();) {
+				if (frame - it->second->last_use > max_unused_frames) {
+					VUK_DO_OR_RETURN(retire(*it->second));
+					it = entries.erase(it);
+				} else {
+					++it;
+				}
+			}
+			return { expected_value };
+		}
+
+		Runtime& ctx;
+		robin_hood::unordered_flat_map<size_t, std::unique_ptr<Entry>> entries;
+
+		std::mutex destroyed_lock;                          // destruction is reported from any thread
+		robin_hood::unordered_flat_set<uint64_t> referenced; // handles referenced by entries, guarded by destroyed_lock
+		std::vector<uint64_t> destroyed;                     // referenced handles destroyed since the last drop, guarded by destroyed_lock
+	};
+
 	struct VkQueueStream : public Stream {
 		Runtime& ctx;
 		QueueExecutor* executor;
 
 		std::vector<SubmitInfo> batch;
+		std::vector<SyncPoint> retired_sync_points;
 		std::deque<Signal> signals;
 		SubmitInfo si;
 		Unique<CommandPool> cpool;
@@ -198,25 +603,67 @@ namespace vuk {
 		std::vector<VkImageMemoryBarrier2KHR> half_im_bars;
 		std::vector<VkMemoryBarrier2KHR> mem_bars;
 		std::vector<VkMemoryBarrier2KHR> half_mem_bars;
+		std::vector<VkBufferMemoryBarrier2KHR> buf_bars;
+		// images synchronized for framebuffer use since the last render pass, and whether their previous contents were undefined
+		struct AttachmentContents {
+			VkImage image;
+			Subrange::Image range;
+			bool undefined;
+		};
+		std::vector<AttachmentContents> attachment_contents;
+
+		// consecutive passes recorded through the task runner when the stream is submitted
+		// a pass begins and ends its render pass in its segment, so segments are only cut between render passes
+		struct DeferredSegment {
+			size_t batch_index; // the command buffer of the segment goes to batch[batch_index].command_buffers[cbuf_index]
+			size_t cbuf_index;
+			std::vector<fu2::unique_function<void(VkCommandBuffer, Allocator&)>> passes;
+			Result<void> result = { expected_value };
+		};
+		// a worker records from its own pool and allocates from its own resource, released into the stream allocator with the stream
+		struct Worker {
+			Worker(DeviceResource& upstream) : resource(upstream), allocator(resource) {}
 
-		VkQueueStream(Allocator alloc, QueueExecutor* qe, ProfilingCallbacks* callbacks) :
+			DeviceLinearResource resource;
+			Allocator allocator;
+			CommandPool pool;
+		};
+		RecordingTaskRunner* task_runner;
+		std::vector<DeferredSegment> deferred_segments;
+		std::vector<Unique<CommandPool>> worker_pools;
+		std::vector<std::unique_ptr<Worker>> workers; // destroyed before the pools of their command buffers
+		bool cbuf_clean = false;          // nothing has been recorded into the current command buffer yet
+		bool cbuf_clean_for_pass = false; // the current command buffer was clean when the pass being recorded was synchronized
+
+		// cache entries submitted in the current batch
+		std::vector<CommandBufferCache::Entry*> reused_entries;
+
+		ExecuteStats* stats;
+
+		VkQueueStream(Allocator alloc, QueueExecutor* qe, ProfilingCallbacks* callbacks, RecordingTaskRunner* task_runner, ExecuteStats* stats) :
 		    Stream(alloc, qe),
 		    ctx(alloc.get_context()),
 		    executor(qe),
-		    callbacks(callbacks) {
+		    callbacks(callbacks),
+		    task_runner(task_runner),
+		    stats(stats) {
 			domain = qe->tag.domain;
 		}
 
-		void add_dependency(Stream* dep) override {
-			if (dep->domain == DomainFlagBits::eHost) {
-				dep->submit();
-				return;
-			}
-			if (is_recording) {
-				end_cbuf();
-				batch.emplace_back();
+		void add_dependency(Stream* dep, PipelineStageFlags dst_stages) override;
+
+		// a barrier recorded here for a dependency is only ordered after the semaphore wait if the wait covers the first scope of the barrier
+		void cover_barrier_scope(Stream* src, VkPipelineStageFlags2 src_stages) {
+			for (auto& dep : dependencies) {
+				if (dep.stream != src) {
+					continue;
+				}
+				if (src_stages == 0) { // an empty first scope is only ordered by waiting at every stage
+					dep.dst_stages = PipelineStageFlagBits::eAllCommands;
+				} else {
+					dep.dst_stages |= PipelineStageFlags(static_cast<PipelineStageFlags::MaskType>(src_stages));
+				}
 			}
-			dependencies.push_back(dep);
 		}
 
 		Signal* make_signal() override {
@@ -227,14 +674,14 @@ namespace vuk {
 			if (batch.empty()) {
 				batch.emplace_back();
 			}
-			for (auto dep : dependencies) {
+			for (auto& [dep, dst_stages] : dependencies) {
 				auto signal = dep->make_signal();
 				if (signal) {
 					dep->add_dependent_signal(signal);
 				}
 				auto res = *dep->submit();
 				if (signal) {
-					batch.back().waits.push_back(signal);
+					batch.back().waits.push_back({ signal, dst_stages });
 				}
 				if (res.sema_wait != VK_NULL_HANDLE) {
 					batch.back().pres_wait.push_back(res.sema_wait);
@@ -244,30 +691,67 @@ namespace vuk {
 			if (!is_recording) {
 				begin_cbuf();
 			}
-			flush_barriers();
+			if (flush_barriers()) {
+				cbuf_clean = false;
+			}
+			// the pass synchronized records into the current command buffer, unless it is deferred
+			cbuf_clean_for_pass = cbuf_clean;
+			cbuf_clean = false;
+		}
+
+		// anything recorded, waited on or synchronized since the last submission
+		bool has_pending_work() const {
+			return is_recording || !batch.empty() || !dependencies.empty() || !im_bars.empty() || !mem_bars.empty() || !buf_bars.empty();
 		}
 
 		Result<SubmitResult> submit() override {
+			TraceScope _(TraceCategory::eSubmit, "queue_submit");
+			// nothing new to submit - the signals go out in an empty submission, without beginning a command buffer
+			if (!has_pending_work()) {
+				if (dependent_signals.empty()) {
+					return { expected_value };
+				}
+				auto& item = batch.emplace_back();
+				for (auto& signal : dependent_signals) {
+					signal->source.executor = executor;
+					item.signals.emplace_back(signal);
+				}
+				VUK_DO_OR_RETURN(executor->submit_batch(batch));
+				count_submit();
+				batch.clear();
+				dependent_signals.clear();
+				return { expected_value };
+			}
 			sync_deps();
 			end_cbuf();
+			VUK_DO_OR_RETURN(record_deferred_passes());
 			for (auto& signal : dependent_signals) {
 				signal->source.executor = executor;
 				batch.back().signals.emplace_back(signal);
 			}
-			executor->submit_batch(batch);
+			VUK_DO_OR_RETURN(executor->submit_batch(batch));
+			count_submit();
+			// resources of this stream retire once the submitted values complete - this never waits on the host
+			retired_sync_points.clear();
 			for (auto& item : batch) {
 				for (auto& signal : item.signals) {
-					alloc.wait_sync_points(std::span{ &signal->source, 1 });
+					retired_sync_points.push_back(signal->source);
 				}
 			}
+			alloc.wait_sync_points(retired_sync_points);
+			for (auto entry : reused_entries) {
+				entry->sync_points = retired_sync_points;
+			}
+			reused_entries.clear();
 			batch.clear();
+			deferred_segments.clear();
 			dependent_signals.clear();
 			return { expected_value };
 		}
 
 		Result<VkResult> present(Swapchain& swp) {
 			batch.back().pres_signal.emplace_back(swp.semaphores[swp.linear_index * 2 + 1]);
-			submit();
+			VUK_DO_OR_RETURN(submit());
 			VkPresentInfoKHR pi{ .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR };
 			pi.swapchainCount = 1;
 			pi.pSwapchains = &swp.swapchain;
@@ -281,15 +765,198 @@ namespace vuk {
 			return res;
 		}
 
+		VkCommandPoolCreateInfo command_pool_create_info() {
+			VkCommandPoolCreateInfo cpci{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+			cpci.flags = VkCommandPoolCreateFlagBits::VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			cpci.queueFamilyIndex = executor->get_queue_family_index(); // currently queue family idx = queue idx
+			return cpci;
+		}
+
+		// the barriers of the pass stay in the current command buffer, the pass goes to a segment with its own command buffer
+		Result<void> defer_pass(fu2::unique_function<void(VkCommandBuffer, Allocator&)> record) {
+			assert(task_runner);
+			// nothing was recorded since the last segment: the pass continues it, and the clean command buffer stays open for the next barriers
+			auto& command_buffers = batch.back().command_buffers;
+			if (cbuf_clean_for_pass && !deferred_segments.empty()) {
+				auto& last = deferred_segments.back();
+				if (last.batch_index == batch.size() - 1 && last.cbuf_index == command_buffers.size() - 1) {
+					last.passes.push_back(std::move(record));
+					cbuf_clean = true;
+					return { expected_value };
+				}
+			}
+			VUK_DO_OR_RETURN(end_cbuf());
+			auto& segment = deferred_segments.emplace_back(DeferredSegment{ batch.size() - 1, command_buffers.size() });
+			segment.passes.push_back(std::move(record));
+			command_buffers.push_back(VK_NULL_HANDLE); // filled in when the segment is recorded
+			return { expected_value };
+		}
+
+		// the command buffer of a cache entry is allocated from the entry, so that it outlives the execution
+		Result<void> begin_reusable_cbuf(CommandBufferCache::Entry& entry) {
+			Allocator entry_alloc(entry.resource);
+			CommandPool pool;
+			auto cpci = command_pool_create_info();
+			cpci.flags = {};
+			VUK_DO_OR_RETURN(entry_alloc.allocate_command_pools(std::span{ &pool, 1 }, std::span{ &cpci, 1 }));
+			CommandBufferAllocation cba;
+			CommandBufferAllocationCreateInfo ci{ .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY, .command_pool = pool };
+			VUK_DO_OR_RETURN(entry_alloc.allocate_command_buffers(std::span{ &cba, 1 }, std::span{ &ci, 1 }));
+			entry.command_buffer = cba.command_buffer;
+
+			// a replay is submitted while earlier submissions of the entry are pending - from frames in flight, or from the same pass appearing twice in a batch
+			// without SIMULTANEOUS_USE every replay would have to wait on the host for the last submission of the entry
+			VkCommandBufferBeginInfo cbi{ .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, .flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT };
+			if (auto result = ctx.vkBeginCommandBuffer(entry.command_buffer, &cbi); result != VK_SUCCESS) {
+				return { expected_error, VkException{ result } };
+			}
+			return { expected_value };
+		}
+
+		// the barriers of the pass stay in the current command buffer, the recorded command buffer of the entry follows it
+		Result<void> append_reusable_cbuf(CommandBufferCache::Entry& entry) {
+			VUK_DO_OR_RETURN(end_cbuf());
+			batch.back().command_buffers.push_back(entry.command_buffer);
+			reused_entries.push_back(&entry);
+			return { expected_value };
+		}
+
+		Result<void> record_deferred_passes() {
+			if (deferred_segments.empty()) {
+				return { expected_value };
+			}
+			// pools are allocated here, so that only the command buffers and the allocations of the passes come from the workers
+			auto worker_count = task_runner->worker_count();
+			while (workers.size() < worker_count) {
+				auto& pool = worker_pools.emplace_back(alloc);
+				auto cpci = command_pool_create_info();
+				VUK_DO_OR_RETURN(alloc.allocate_command_pools(std::span{ &*pool, 1 }, std::span{ &cpci, 1 }));
+				auto& worker = workers.emplace_back(std::make_unique<Worker>(alloc.get_device_resource()));
+				worker->pool = *pool;
+			}
+
+			task_runner->run(
+			    deferred_segments.size(),
+			    [](void* task_data, size_t index, size_t worker) {
+				    auto& self = *reinterpret_cast<VkQueueStream*>(task_data);
+				    auto& segment = self.deferred_segments[index];
+				    segment.result = self.record_deferred_segment(segment, *self.workers[worker]);
+			    },
+			    this);
+
+			for (auto& segment : deferred_segments) {
+				VUK_DO_OR_RETURN(std::move(segment.result));
+			}
+			return { expected_value };
+		}
+
+		void count_barriers() {
+			stats->barrier_flushes++;
+			stats->image_barriers += im_bars.size();
+			stats->buffer_barriers += buf_bars.size();
+			stats->memory_barriers += mem_bars.size();
+			for (auto& bar : im_bars) {
+				if (bar.srcQueueFamilyIndex != bar.dstQueueFamilyIndex) {
+					stats->queue_ownership_transfers++;
+				}
+				if (bar.oldLayout == bar.newLayout) {
+					continue;
+				}
+				auto old_layout = (ImageLayout)bar.oldLayout;
+				auto new_layout = (ImageLayout)bar.newLayout;
+				auto& transitions = stats->layout_transitions;
+				auto it = std::find_if(transitions.begin(), transitions.end(), [&](auto& lt) { return lt.old_layout == old_layout && lt.new_layout == new_layout; });
+				auto& transition = it != transitions.end() ? *it : transitions.emplace_back(ExecuteStats::LayoutTransition{ old_layout, new_layout });
+				transition.count++;
+			}
+		}
+
+		void count_submit() {
+			auto it = std::find_if(stats->queues.begin(), stats->queues.end(), [&](auto& q) { return q.domain == domain; });
+			auto& queue = it != stats->queues.end() ? *it : stats->queues.emplace_back(ExecuteStats::Queue{ .domain = domain });
+			queue.submits++;
+			queue.submit_infos += batch.size();
+			for (auto& item : batch) {
+				queue.command_buffers += item.command_buffers.size();
+				queue.semaphore_waits += item.waits.size() + item.relative_waits.size();
+				queue.semaphore_signals += item.signals.size();
+				queue.presentation_waits += item.pres_wait.size();
+			}
+		}
+
+		// the built-in pass profiler brackets passes and barrier batches with timestamps
+		// they are written outside of render passes - inside a multiview render pass a timestamp would take a query per view
+		struct PassTimer {
+			PassTimestamp begin;
+			bool active = false;
+		};
+
+		bool write_timestamp(VkCommandBuffer cb, VkPipelineStageFlagBits stage, PassTimestamp& ts) {
+			auto result = ctx.allocate_pass_timestamp();
+			if (!result.holds_value()) {
+				(void)result.error();
+				return false; // profiling is best effort
+			}
+			ts = *result;
+			ctx.vkCmdWriteTimestamp(cb, stage, ts.pool, ts.index);
+			return true;
+		}
+
+		PassTimer begin_pass_timer(VkCommandBuffer cb) {
+			if (!ctx.is_pass_profiling_enabled()) {
+				return {};
+			}
+			PassTimer timer;
+			timer.active = write_timestamp(cb, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timer.begin);
+			return timer;
+		}
+
+		void end_pass_timer(VkCommandBuffer cb, PassTimer timer, std::string_view pass_name) {
+			if (!timer.active) {
+				return;
+			}
+			PassTimestamp end;
+			if (write_timestamp(cb, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, end)) {
+				ctx.register_pass_timing(Name(pass_name), timer.begin, end);
+			}
+		}
+
+		// runs on a worker of the task runner
+		Result<void> record_deferred_segment(DeferredSegment& segment, Worker& worker) {
+			CommandBufferAllocation cba;
+			CommandBufferAllocationCreateInfo ci{ .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY, .command_pool = worker.pool };
+			VUK_DO_OR_RETURN(worker.allocator.allocate_command_buffers(std::span{ &cba, 1 }, std::span{ &ci, 1 }));
+			auto cb = cba.command_buffer;
+
+			VkCommandBufferBeginInfo cbi{ .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT };
+			if (auto result = ctx.vkBeginCommandBuffer(cb, &cbi); result != VK_SUCCESS) {
+				return { expected_error, VkException{ result } };
+			}
+			void* profile_data = nullptr;
+			if (callbacks->on_begin_command_buffer) {
+				profile_data = callbacks->on_begin_command_buffer(callbacks->user_data, executor->tag, cb);
+			}
+
+			for (auto& record : segment.passes) {
+				record(cb, worker.allocator);
+			}
+
+			if (callbacks->on_end_command_buffer)
+				callbacks->on_end_command_buffer(callbacks->user_data, profile_data);
+			if (auto result = ctx.vkEndCommandBuffer(cb); result != VK_SUCCESS) {
+				return { expected_error, VkException{ result } };
+			}
+			batch[segment.batch_index].command_buffers[segment.cbuf_index] = cb;
+			return { expected_value };
+		}
+
 		Result<void> begin_cbuf() {
 			assert(!is_recording);
 			is_recording = true;
 			domain = domain;
 			if (cpool->command_pool == VK_NULL_HANDLE) {
 				cpool = Unique<CommandPool>(alloc);
-				VkCommandPoolCreateInfo cpci{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
-				cpci.flags = VkCommandPoolCreateFlagBits::VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
-				cpci.queueFamilyIndex = executor->get_queue_family_index(); // currently queue family idx = queue idx
+				auto cpci = command_pool_create_info();
 
 				VUK_DO_OR_RETURN(alloc.allocate_command_pools(std::span{ &*cpool, 1 }, std::span{ &cpci, 1 }));
 			}
@@ -302,11 +969,16 @@ namespace vuk {
 			cbuf = hl_cbuf->command_buffer;
 
 			VkCommandBufferBeginInfo cbi{ .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT };
-			alloc.get_context().vkBeginCommandBuffer(cbuf, &cbi);
+			if (auto result = alloc.get_context().vkBeginCommandBuffer(cbuf, &cbi); result != VK_SUCCESS) {
+				return { expected_error, VkException{ result } };
+			}
+			trace::record(TracePhase::eInstant, TraceCategory::eCommandBuffer, "begin_command_buffer");
 
 			cbuf_profile_data = nullptr;
+			cbuf_clean = true;
 			if (callbacks->on_begin_command_buffer) {
 				cbuf_profile_data = callbacks->on_begin_command_buffer(callbacks->user_data, executor->tag, cbuf);
+				cbuf_clean = false; // the command buffer must be submitted for the profiler
 			}
 
 			return { expected_value };
@@ -320,24 +992,40 @@ namespace vuk {
 			if (auto result = ctx.vkEndCommandBuffer(hl_cbuf->command_buffer); result != VK_SUCCESS) {
 				return { expected_error, VkException{ result } };
 			}
+			trace::record(TracePhase::eInstant, TraceCategory::eCommandBuffer, "end_command_buffer");
 			batch.back().command_buffers.push_back(hl_cbuf->command_buffer);
 			cbuf = VK_NULL_HANDLE;
 			return { expected_value };
 		};
 
-		void flush_barriers() {
+		// returns true if a barrier was recorded
+		bool flush_barriers() {
+			CoalescedBarriers coalesced;
+			coalesce_barriers(mem_bars, buf_bars, im_bars, coalesced);
+			stats->merged_barriers += coalesced.merged;
+			stats->redundant_barriers += coalesced.dropped;
+
 			VkDependencyInfoKHR dependency_info{ .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR,
 				                                   .memoryBarrierCount = (uint32_t)mem_bars.size(),
 				                                   .pMemoryBarriers = mem_bars.data(),
+				                                   .bufferMemoryBarrierCount = (uint32_t)buf_bars.size(),
+				                                   .pBufferMemoryBarriers = buf_bars.data(),
 				                                   .imageMemoryBarrierCount = (uint32_t)im_bars.size(),
 				                                   .pImageMemoryBarriers = im_bars.data() };
 
-			if (mem_bars.size() > 0 || im_bars.size() > 0) {
+			bool recorded = mem_bars.size() > 0 || buf_bars.size() > 0 || im_bars.size() > 0;
+			if (recorded) {
+				trace::record(TracePhase::eInstant, TraceCategory::eBarrier, "flush_barriers", mem_bars.size() + buf_bars.size() + im_bars.size());
+				auto timer = begin_pass_timer(cbuf);
 				ctx.vkCmdPipelineBarrier2KHR(cbuf, &dependency_info);
+				end_pass_timer(cbuf, timer, "barriers");
+				count_barriers();
 			}
 
 			mem_bars.clear();
+			buf_bars.clear();
 			im_bars.clear();
+			return recorded;
 		}
 
 		void print_ib(VkImageMemoryBarrier2KHR ib, std::string extra = "") {
@@ -452,6 +1140,11 @@ namespace vuk {
 			// assert(img_att.layout == ImageLayout::eUndefined || barrier.oldLayout != VK_IMAGE_LAYOUT_UNDEFINED);
 			assert(barrier.oldLayout != VK_IMAGE_LAYOUT_UNDEFINED || !is_readonly_layout(barrier.newLayout));
 			im_bars.push_back(barrier);
+			cover_barrier_scope(src_use.stream, barrier.srcStageMask);
+
+			if (dst_use.stream == this && is_framebuffer_attachment(dst_use)) {
+				attachment_contents.push_back({ barrier.image, subrange, barrier.oldLayout == VK_IMAGE_LAYOUT_UNDEFINED });
+			}
 
 			img_att.layout = (ImageLayout)barrier.newLayout;
 			if (barrier.oldLayout != VK_IMAGE_LAYOUT_UNDEFINED) {
@@ -459,7 +1152,7 @@ namespace vuk {
 			}
 		};
 
-		void synch_memory(StreamResourceUse src_use, StreamResourceUse dst_use, void* tag) override {
+		void synch_memory(const Buffer& buf, Subrange::Buffer subrange, StreamResourceUse src_use, StreamResourceUse dst_use, void* tag) override {
 			VkMemoryBarrier2KHR barrier{ .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR };
 
 			DomainFlagBits src_domain = src_use.stream ? src_use.stream->domain : DomainFlagBits::eNone;
@@ -485,10 +1178,52 @@ namespace vuk {
 				barrier.srcAccessMask = {};
 			}
 
-			mem_bars.push_back(barrier);
+			// without a handle we can't scope the barrier, fall back to a global one
+			if (buf.buffer == VK_NULL_HANDLE) {
+				mem_bars.push_back(barrier);
+				cover_barrier_scope(src_use.stream, barrier.srcStageMask);
+				return;
+			}
+
+			// the range is tracked relative to the allocation, which backs the whole VkBuffer
+			VkBufferMemoryBarrier2KHR buf_barrier{ .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR,
+				                                     .srcStageMask = barrier.srcStageMask,
+				                                     .srcAccessMask = barrier.srcAccessMask,
+				                                     .dstStageMask = barrier.dstStageMask,
+				                                     .dstAccessMask = barrier.dstAccessMask,
+				                                     .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				                                     .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				                                     .buffer = buf.buffer,
+				                                     .offset = subrange.offset,
+				                                     .size = subrange.size };
+			buf_bars.push_back(buf_barrier);
+			cover_barrier_scope(src_use.stream, buf_barrier.srcStageMask);
 		};
 
-		void prepare_render_pass_attachment(Allocator alloc, ImageAttachment img_att) {
+		// transitioning from UNDEFINED discards the contents anyway, so there is nothing to load
+		// the whole subrange of the attachment must have been transitioned from UNDEFINED, and no part of it from anything else
+		bool has_undefined_contents(const ImageAttachment& img_att) {
+			Subrange::Image range{ img_att.base_level, img_att.level_count, img_att.base_layer, img_att.layer_count };
+			bool found = false;
+			for (auto& contents : attachment_contents) {
+				if (contents.image != img_att.image.image) {
+					continue;
+				}
+				auto isection = intersect_one(contents.range, range);
+				if (!isection) {
+					continue;
+				}
+				if (!contents.undefined) {
+					return false;
+				}
+				if (*isection == range) {
+					found = true;
+				}
+			}
+			return found;
+		}
+
+		void prepare_render_pass_attachment(Allocator alloc, ImageAttachment img_att, bool load_contents, bool store_contents) {
 			auto aspect = format_to_aspect(img_att.format);
 			VkAttachmentReference attref{};
 
@@ -500,8 +1235,16 @@ namespace vuk {
 			descr.finalLayout = (VkImageLayout)img_att.layout;
 			attref.layout = (VkImageLayout)img_att.layout;
 
-			descr.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
-			descr.storeOp = is_readonly_layout((VkImageLayout)img_att.layout) ? VK_ATTACHMENT_STORE_OP_NONE_KHR : VK_ATTACHMENT_STORE_OP_STORE;
+			descr.loadOp = load_contents ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			if (is_readonly_layout((VkImageLayout)img_att.layout)) {
+				descr.storeOp = VK_ATTACHMENT_STORE_OP_NONE_KHR;
+			} else {
+				descr.storeOp = store_contents ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			}
+			if (aspect & ImageAspectFlagBits::eStencil) {
+				descr.stencilLoadOp = descr.loadOp;
+				descr.stencilStoreOp = descr.storeOp;
+			}
 
 			descr.format = (VkFormat)img_att.format;
 			descr.samples = (VkSampleCountFlagBits)img_att.sample_count.count;
@@ -527,7 +1270,8 @@ namespace vuk {
 			rp.fbci.attachments.push_back(img_att.image_view);
 		}
 
-		Result<void> prepare_render_pass() {
+		// with an owner, the render pass and the framebuffer are allocated from it and stay alive with it, otherwise they come from the runtime cache
+		Result<void> prepare_render_pass(bool begin = true, Allocator* owner = nullptr) {
 			SubpassDescription sd;
 			sd.colorAttachmentCount = (uint32_t)rp.rpci.color_refs.size();
 			sd.pColorAttachments = rp.rpci.color_refs.data();
@@ -551,21 +1295,34 @@ namespace vuk {
 
 			rp.rpci.attachmentCount = (uint32_t)rp.rpci.attachments.size();
 			rp.rpci.pAttachments = rp.rpci.attachments.data();
+			attachment_contents.clear();
 
-			auto result = alloc.allocate_render_passes(std::span{ &rp.handle, 1 }, std::span{ &rp.rpci, 1 });
-
-			rp.fbci.renderPass = rp.handle;
 			rp.fbci.pAttachments = rp.framebuffer_ivs.data();
 			rp.fbci.attachmentCount = (uint32_t)rp.framebuffer_ivs.size();
 
-			Unique<VkFramebuffer> fb(alloc);
-			VUK_DO_OR_RETURN(alloc.allocate_framebuffers(std::span{ &*fb, 1 }, std::span{ &rp.fbci, 1 }));
-			rp.framebuffer = *fb; // queue framebuffer for destruction
-			// drop render pass immediately
-			if (result) {
-				alloc.deallocate(std::span{ &rp.handle, 1 });
+			if (owner) {
+				VUK_DO_OR_RETURN(owner->allocate_render_passes(std::span{ &rp.handle, 1 }, std::span{ &rp.rpci, 1 }));
+				rp.fbci.renderPass = rp.handle;
+				Unique<VkFramebuffer> fb(*owner);
+				VUK_DO_OR_RETURN(owner->allocate_framebuffers(std::span{ &*fb, 1 }, std::span{ &rp.fbci, 1 }));
+				rp.framebuffer = *fb;
+			} else {
+				// the runtime keeps the render pass and framebuffer of an attachment set until one of its image views is destroyed
+				auto rpfb = ctx.acquire_render_pass_framebuffer(rp.rpci, rp.fbci);
+				if (!rpfb) {
+					return std::move(rpfb);
+				}
+				rp.handle = rp.fbci.renderPass = rpfb->render_pass;
+				rp.framebuffer = rpfb->framebuffer;
+				if (rpfb->cached) {
+					stats->render_pass_cache_hits++;
+				} else {
+					stats->render_pass_cache_misses++;
+				}
+			}
+			if (begin) {
+				begin_render_pass(alloc.get_context(), rp, cbuf, false);
 			}
-			begin_render_pass(alloc.get_context(), rp, cbuf, false);
 
 			return { expected_value };
 		}
@@ -587,8 +1344,8 @@ namespace vuk {
 			signal->status = Signal::Status::eHostAvailable;
 		}
 
-		void add_dependency(Stream* dep) override {
-			dependencies.push_back(dep);
+		void add_dependency(Stream* dep, PipelineStageFlags dst_stages) override {
+			dependencies.push_back({ dep, dst_stages });
 		}
 		void sync_deps() override {
 			assert(false);
@@ -598,7 +1355,7 @@ namespace vuk {
 			/* host -> host and host -> device not needed, device -> host inserts things on the device side */
 			return;
 		}
-		void synch_memory(StreamResourceUse src_use, StreamResourceUse dst_use, void* tag) override {
+		void synch_memory(const Buffer& buf, Subrange::Buffer subrange, StreamResourceUse src_use, StreamResourceUse dst_use, void* tag) override {
 			/* host -> host and host -> device not needed, device -> host inserts things on the device side */
 			return;
 		}
@@ -607,22 +1364,181 @@ namespace vuk {
 			return nullptr;
 		}
 
-		Result<SubmitResult> submit() override {
+		// the first error of the host passes that ran without a submit to return it from
+		Result<void> failure = { expected_value };
+
+		// runs the queued host passes - an error is kept until the stream is submitted
+		void run_queued() {
+			auto res = run_passes();
+			if (!res) {
+				if (failure) {
+					failure = std::move(res);
+				} else {
+					(void)res.error();
+				}
+				return;
+			}
 			for (auto& sig : dependent_signals) {
 				sig->status = Signal::Status::eHostAvailable;
 			}
+		}
+
+		Result<SubmitResult> submit() override {
+			run_queued();
+			VUK_DO_OR_RETURN(std::exchange(failure, Result<void>{ expected_value }));
+			return { expected_value };
+		}
+
+		// a resource used by a host pass, keyed like in the recorder, and whether the pass writes it
+		struct Access {
+			uint64_t key;
+			bool write;
+		};
+
+		// host passes are deferred: they run when the stream is submitted, which happens before device work depending on them is submitted, or at the end of the execution
+		// they run concurrently if the host executor is a thread pool
+		// passes using the same resource keep their order if either of them writes it
+		struct HostPass {
+			fu2::unique_function<void()> run;
+			std::vector<Access> accesses;
+			std::vector<Signal*> waits; // device work the pass depends on
+			Result<void> result = { expected_value };
+		};
+		std::vector<HostPass> passes;
+
+		static void collect_accesses(Type* base_ty, void* value, bool write, std::vector<Access>& accesses) {
+			if (base_ty->kind == Type::ARRAY_TY) {
+				auto elem_ty = base_ty->array.T->get();
+				auto elems = reinterpret_cast<std::byte*>(value);
+				for (size_t i = 0; i < base_ty->array.count; i++) {
+					collect_accesses(elem_ty, elems, write, accesses);
+					elems += elem_ty->size;
+				}
+				return;
+			}
+			uint64_t key;
+			if (base_ty->hash_value == current_module->types.builtin_image) {
+				key = reinterpret_cast<uint64_t>(reinterpret_cast<ImageAttachment*>(value)->image.image);
+			} else if (base_ty->hash_value == current_module->types.builtin_buffer) {
+				key = reinterpret_cast<uint64_t>(reinterpret_cast<Buffer*>(value)->allocation);
+			} else if (base_ty->hash_value == current_module->types.builtin_sampled_image) {
+				key = reinterpret_cast<uint64_t>(reinterpret_cast<SampledImage*>(value)->ia.image.image);
+			} else {
+				key = reinterpret_cast<uint64_t>(value);
+			}
+			accesses.push_back({ key, write });
+		}
+
+		// queues the pass - it runs when this stream is submitted, not here
+		Result<void> add_pass(fu2::unique_function<void()> run, std::vector<Access> accesses) {
+			auto& pass = passes.emplace_back(HostPass{ std::move(run), std::move(accesses) });
+			// the device work the pass depends on is submitted now, the pass waits for it on the host
+			for (auto& [dep, dst_stages] : dependencies) {
+				auto signal = dep->make_signal();
+				if (signal) {
+					dep->add_dependent_signal(signal);
+					pass.waits.push_back(signal);
+				}
+				VUK_DO_OR_RETURN(dep->submit());
+			}
+			dependencies.clear();
+			return { expected_value };
+		}
+
+		Result<void> run_passes() {
+			if (passes.empty()) {
+				return { expected_value };
+			}
+			auto& ctx = alloc.get_context();
+			auto run_pass = [&ctx](HostPass& pass) {
+				std::vector<SyncPoint> sync_points;
+				for (auto signal : pass.waits) {
+					sync_points.push_back(signal->source);
+				}
+				if (!sync_points.empty()) {
+					pass.result = ctx.wait_for_domains(sync_points);
+					if (!pass.result) {
+						return;
+					}
+				}
+				pass.run();
+			};
+
+			if (executor && executor->type == Executor::Type::eThreadPool) {
+				std::vector<ThreadPoolExecutor::Task> tasks(passes.size());
+				auto add_edge = [&](size_t from, size_t to) {
+					auto& dependents = tasks[from].dependents;
+					if (from != to && (dependents.empty() || dependents.back() != to)) {
+						dependents.push_back(to);
+						tasks[to].dependency_count++;
+					}
+				};
+				struct Uses {
+					size_t writer = SIZE_MAX;
+					std::vector<size_t> readers; // since the last write
+				};
+				robin_hood::unordered_flat_map<uint64_t, Uses> uses;
+				for (size_t i = 0; i < passes.size(); i++) {
+					for (auto& [key, write] : passes[i].accesses) {
+						auto& use = uses[key];
+						if (use.writer != SIZE_MAX) {
+							add_edge(use.writer, i);
+						}
+						if (write) {
+							for (auto reader : use.readers) {
+								add_edge(reader, i);
+							}
+							use.writer = i;
+							use.readers.clear();
+						} else {
+							use.readers.push_back(i);
+						}
+					}
+					tasks[i].run = [&run_pass, &pass = passes[i]](size_t worker) {
+						run_pass(pass);
+					};
+				}
+				static_cast<ThreadPoolExecutor*>(executor)->run_graph(tasks);
+			} else {
+				for (auto& pass : passes) {
+					run_pass(pass);
+				}
+			}
+
+			auto ran = std::move(passes);
+			passes.clear();
+			for (auto& pass : ran) {
+				VUK_DO_OR_RETURN(std::move(pass.result));
+			}
 			return { expected_value };
 		}
 	};
 
+	void VkQueueStream::add_dependency(Stream* dep, PipelineStageFlags dst_stages) {
+		if (dep->domain == DomainFlagBits::eHost) {
+			// the host passes run before the work depending on them is recorded
+			static_cast<HostStream*>(dep)->run_queued();
+			return;
+		}
+		if (is_recording) {
+			end_cbuf();
+			batch.emplace_back();
+		}
+		// a wait without stages would not wait at all
+		if (dst_stages == PipelineStageFlags{}) {
+			dst_stages = PipelineStageFlagBits::eAllCommands;
+		}
+		dependencies.push_back({ dep, dst_stages });
+	}
+
 	struct VkPEStream : Stream {
 		VkPEStream(Allocator alloc, Swapchain& swp) : Stream(alloc, nullptr), swp(&swp) {
 			domain = DomainFlagBits::ePE;
 		}
 		Swapchain* swp;
 
-		void add_dependency(Stream* dep) override {
-			dependencies.push_back(dep);
+		void add_dependency(Stream* dep, PipelineStageFlags dst_stages) override {
+			dependencies.push_back({ dep, dst_stages });
 		}
 		void sync_deps() override {
 			assert(false);
@@ -630,7 +1546,7 @@ namespace vuk {
 
 		void synch_image(ImageAttachment& img_att, Subrange::Image subrange, StreamResourceUse src_use, StreamResourceUse dst_use, void* tag) override {}
 
-		void synch_memory(StreamResourceUse src_use, StreamResourceUse dst_use, void* tag) override { /* PE doesn't do memory */
+		void synch_memory(const Buffer& buf, Subrange::Buffer subrange, StreamResourceUse src_use, StreamResourceUse dst_use, void* tag) override { /* PE doesn't do memory */
 			assert(false);
 		}
 
@@ -650,9 +1566,10 @@ namespace vuk {
 	struct Scheduler {
 		Scheduler(Allocator all, RGCImpl* impl) : allocator(all), pass_reads(impl->pass_reads), pass_nops(impl->pass_nops), scheduled_execables(impl->scheduled_execables), impl(impl) {
 			// these are the items that were determined to run
+			plan.reserve(scheduled_execables.size());
+			plan_index.reserve(scheduled_execables.size());
 			for (auto& i : scheduled_execables) {
-				scheduled.emplace(i.execable);
-				work_queue.emplace_back(i);
+				add_item(i);
 			}
 		}
 
@@ -665,33 +1582,142 @@ namespace vuk {
 
 		RGCImpl* impl;
 
-		std::deque<ScheduledItem> work_queue;
+		// execution runs in two phases over the same item handlers
+		// planning: every item is visited once, and the dependencies it schedules are recorded as edges
+		// running: items are handed out from a ready queue once all of their dependencies have run, so each item runs once
+		struct PlannedItem {
+			ScheduledItem item;
+			uint32_t in_degree = 0; // dependencies that have not run yet
+			uint32_t first_dependent = 0;
+			uint32_t dependent_count = 0;
+			bool ran = false;
+		};
+
+		static constexpr uint32_t no_item = ~0u;
+
+		bool planning = true;
+		std::vector<PlannedItem> plan;
+		robin_hood::unordered_flat_map<Node*, uint32_t> plan_index;
+		std::vector<std::pair<uint32_t, uint32_t>> edges; // (dependency, dependent)
+		std::vector<uint32_t> dependents;
+		std::deque<uint32_t> ready_queue;
+		uint32_t current = no_item;
+		uint32_t plan_cursor = 0;
+		uint32_t unran_cursor = 0;
 
 		size_t naming_index_counter = 0;
 		size_t instr_counter = 0;
-		std::unordered_set<Node*> scheduled;
+
+		uint32_t add_item(const ScheduledItem& item) {
+			auto [it, inserted] = plan_index.try_emplace(item.execable, (uint32_t)plan.size());
+			if (inserted) {
+				plan.push_back(PlannedItem{ .item = item });
+			}
+			return it->second;
+		}
 
 		void schedule_new(Node* node) {
 			assert(node);
-			if (node->scheduled_item) { // we have scheduling info for this
-				work_queue.push_front(*node->scheduled_item);
-			} else { // no info, just schedule it as-is
-				work_queue.push_front(ScheduledItem{ .execable = node });
+			assert(planning);
+			if (node->execution_info) { // already ran, nothing to wait for
+				return;
+			}
+			// we have scheduling info for this, otherwise just schedule it as-is
+			auto dep = add_item(node->scheduled_item ? *node->scheduled_item : ScheduledItem{ .execable = node });
+			if (dep != current) {
+				edges.emplace_back(dep, current);
 			}
 		}
 
-		// returns true if the item is ready
+		// returns true if the item is ready - only when running, while planning the handler schedules its dependencies instead
 		bool process(ScheduledItem& item) {
-			if (item.ready) {
-				return true;
-			} else {
-				item.ready = true;
-				work_queue.push_front(item); // requeue this item
+			return item.ready;
+		}
+
+		// build the dependent lists and seed the ready queue with the items that have no dependencies
+		void finish_planning() {
+			for (auto& [dep, user] : edges) {
+				plan[dep].dependent_count++;
+				plan[user].in_degree++;
+			}
+			uint32_t offset = 0;
+			for (auto& p : plan) {
+				p.first_dependent = offset;
+				offset += p.dependent_count;
+				p.dependent_count = 0;
+			}
+			dependents.resize(offset);
+			for (auto& [dep, user] : edges) {
+				auto& p = plan[dep];
+				dependents[p.first_dependent + p.dependent_count++] = user;
+			}
+			edges.clear();
+
+			for (uint32_t i = 0; i < plan.size(); i++) {
+				if (plan[i].in_degree == 0) {
+					ready_queue.push_back(i);
+				}
+			}
+			planning = false;
+			current = no_item;
+		}
+
+		void retire(uint32_t index) {
+			auto& p = plan[index];
+			// dependents that became ready go to the front, so that consumers run close to their producers
+			for (auto& user : std::span(dependents).subspan(p.first_dependent, p.dependent_count)) {
+				auto& u = plan[user];
+				if (!u.ran && --u.in_degree == 0) {
+					ready_queue.push_front(user);
+				}
+			}
+		}
+
+		// produces the next item to plan or to run, returns false when every item has run
+		Result<bool> next(ScheduledItem& item) {
+			if (planning) {
+				if (plan_cursor < plan.size()) {
+					current = plan_cursor++;
+					item = plan[current].item;
+					return { expected_value, true };
+				}
+				finish_planning();
+			} else if (current != no_item) {
+				retire(current);
+			}
+
+			if (ready_queue.empty()) {
+				while (unran_cursor < plan.size() && plan[unran_cursor].ran) {
+					unran_cursor++;
+				}
+				if (unran_cursor == plan.size()) {
+					return { expected_value, false };
+				}
+				// the remaining items wait on each other - running one would record it before its dependencies
+				assert(false && "scheduled items wait on each other");
+				return { expected_error,
+					       RenderGraphException{ format_graph_message(Level::eError, plan[unran_cursor].item.execable, "waits on dependencies that can never run.") } };
+			}
+
+			current = ready_queue.front();
+			ready_queue.pop_front();
+			auto& p = plan[current];
+			p.ran = true;
+			item = p.item;
+			item.ready = true;
+			return { expected_value, true };
+		}
+
+		// reads that were split into groups run in order - late reads come after the first group
+		bool is_late_read(const ChainLink& link, Node* reader) {
+			if (!link.late_read_sync || !reader) {
 				return false;
 			}
+			auto reads = link.reads.to_span(pass_reads).subspan(link.read_split);
+			return std::any_of(reads.begin(), reads.end(), [=](Ref r) { return r.node == reader; });
 		}
 
-		void schedule_dependency(Ref parm, RW access) {
+		void schedule_dependency(Ref parm, RW access, Node* reader = nullptr) {
 			if (parm.node->kind == Node::CONSTANT || parm.node->kind == Node::PLACEHOLDER || parm.node->kind == Node::MATH_BINARY) {
 				return;
 			}
@@ -711,6 +1737,12 @@ namespace vuk {
 			} else { // just reading or nop, so don't synchronize with reads
 				// just the def
 				schedule_new(link.def.node);
+				// and the first group of reads, if we are in a later one
+				if (access == RW::eRead && is_late_read(link, reader)) {
+					for (auto& r : link.reads.to_span(pass_reads).first(link.read_split)) {
+						schedule_new(r.node);
+					}
+				}
 			}
 
 			// all nops
@@ -767,14 +1799,14 @@ namespace vuk {
 			return Type::stripped(parm.type());
 		}
 
-		std::optional<StreamResourceUse> get_dependency_info(Ref parm, Type* arg_ty, RW type, Stream* dst_stream) {
+		std::optional<StreamResourceUse> get_dependency_info(Ref parm, Type* arg_ty, RW type, Stream* dst_stream, Node* reader = nullptr) {
 			auto parm_ty = parm.type();
 			auto& link = parm.link();
 
 			std::optional<ResourceUse> s = {};
 
 			if (type == RW::eRead) {
-				std::exchange(s, link.read_sync);
+				std::exchange(s, is_late_read(link, reader) ? link.late_read_sync : link.read_sync);
 			} else {
 				std::exchange(s, link.undef_sync);
 			}
@@ -787,27 +1819,31 @@ namespace vuk {
 	};
 
 	struct Recorder {
-		Recorder(Allocator alloc, ProfilingCallbacks* callbacks, std::pmr::vector<Ref>& pass_reads) :
+		Recorder(Allocator alloc, ProfilingCallbacks* callbacks, std::pmr::vector<Ref>& pass_reads, ExecuteStats* stats) :
 		    ctx(alloc.get_context()),
 		    alloc(alloc),
 		    callbacks(callbacks),
-		    pass_reads(pass_reads) {
-			last_modify.emplace(0, new (this->arena.ensure_space(sizeof(PartialStreamResourceUse))) PartialStreamResourceUse{ { to_use(eNone), nullptr } });
+		    pass_reads(pass_reads),
+		    stats(stats) {
+			last_modify[0].push_back(PartialStreamResourceUse{ { to_use(eNone), nullptr } });
 		}
 		Runtime& ctx;
 		Allocator alloc;
 		ProfilingCallbacks* callbacks;
 		std::pmr::vector<Ref>& pass_reads;
+		ExecuteStats* stats;
 		InlineArena<std::byte, 1024> arena;
 
-		std::unordered_map<DomainFlagBits, std::unique_ptr<Stream>> streams;
+		// in creation order, so the streams are always submitted in the same order
+		std::vector<std::pair<DomainFlagBits, std::unique_ptr<Stream>>> streams;
 		struct PartialStreamResourceUse : StreamResourceUse {
 			Subrange subrange;
-			PartialStreamResourceUse* prev = nullptr;
-			PartialStreamResourceUse* next = nullptr;
 		};
+		// the last use of each disjoint subrange of a resource
+		// adjacent subranges with the same last use are merged, so the state stays a handful of entries even for per-mip or per-layer access
+		using ResourceState = gch::small_vector<PartialStreamResourceUse, 2>;
 
-		std::unordered_map<uint64_t, PartialStreamResourceUse*> last_modify;
+		robin_hood::unordered_flat_map<uint64_t, ResourceState> last_modify;
 
 		// start recording if needed
 		// all dependant domains flushed
@@ -816,8 +1852,13 @@ namespace vuk {
 			stream->sync_deps();
 		}
 
+		Stream* add_stream(DomainFlagBits domain, std::unique_ptr<Stream> stream) {
+			assert(!stream_for_domain(domain));
+			return streams.emplace_back(domain, std::move(stream)).second.get();
+		}
+
 		Stream* stream_for_domain(DomainFlagBits domain) {
-			auto it = streams.find(domain);
+			auto it = std::find_if(streams.begin(), streams.end(), [=](auto& entry) { return entry.first == domain; });
 			if (it != streams.end()) {
 				return it->second.get();
 			}
@@ -834,6 +1875,78 @@ namespace vuk {
 			return nullptr;
 		}
 
+		// buffers are tracked as byte ranges of their allocation
+		static Subrange::Buffer buffer_range(const Buffer& buf) {
+			return { .offset = buf.offset, .size = buf.size == ~(0u) ? VK_WHOLE_SIZE : buf.size };
+		}
+
+		template<class R>
+		static R& range_of(PartialStreamResourceUse& psru) {
+			if constexpr (std::is_same_v<R, Subrange::Image>) {
+				return psru.subrange.image;
+			} else {
+				return psru.subrange.buffer;
+			}
+		}
+
+		// index of the first entry overlapping range, or the size of the state if there is none
+		template<class R>
+		static size_t find_overlap(ResourceState& state, R range, R& isection) {
+			for (size_t i = 0; i < state.size(); i++) {
+				if (auto isection_opt = intersect_one(range_of<R>(state[i]), range)) {
+					isection = *isection_opt;
+					return i;
+				}
+			}
+			return state.size();
+		}
+
+		// merge entries with the same last use over adjacent ranges
+		template<class R>
+		static void coalesce(ResourceState& state) {
+			for (size_t i = 0; i < state.size(); i++) {
+				for (size_t j = i + 1; j < state.size();) {
+					auto& a = state[i];
+					auto& b = state[j];
+					if (a.stream == b.stream && static_cast<ResourceUse&>(a) == static_cast<ResourceUse&>(b)) {
+						if (auto merged = merge_one(range_of<R>(a), range_of<R>(b))) {
+							range_of<R>(a) = *merged;
+							state[j] = state.back();
+							state.pop_back();
+							// the grown range might be adjacent to entries we have already passed
+							j = i + 1;
+							continue;
+						}
+					}
+					j++;
+				}
+			}
+		}
+
+		// other views of the allocation might already be tracked - only the bytes not covered yet get the initial use
+		void init_buffer_sync(uint64_t key, PartialStreamResourceUse psru) {
+			auto& state = last_modify[key];
+			if (state.empty()) {
+				state.push_back(psru);
+				return;
+			}
+			std::vector<Subrange::Buffer, inline_alloc<Subrange::Buffer, 1024>> work_queue(this->arena);
+			work_queue.emplace_back(psru.subrange.buffer);
+			while (work_queue.size() > 0) {
+				Subrange::Buffer range = work_queue.back();
+				Subrange::Buffer isection;
+				work_queue.pop_back();
+				auto found = find_overlap(state, range, isection);
+				if (found == state.size()) {
+					psru.subrange.buffer = range;
+					state.push_back(psru);
+					continue;
+				}
+				difference_one(range, isection, [&](Subrange::Buffer nb) { work_queue.push_back(nb); });
+			}
+			coalesce<Subrange::Buffer>(state);
+		}
+
 		void init_sync(Type* base_ty, StreamResourceUse src_use, void* value, bool enforce_unique = true) {
 			uint64_t key = 0;
 			PartialStreamResourceUse psru{ src_use };
@@ -844,7 +1957,9 @@ namespace vuk {
 			} else if (base_ty->hash_value == current_module->types.builtin_buffer) {
 				auto buf = reinterpret_cast<Buffer*>(value);
 				key = reinterpret_cast<uint64_t>(buf->allocation);
-				hash_combine(key, buf->offset);
+				psru.subrange.buffer = buffer_range(*buf);
+				init_buffer_sync(key, psru);
+				return;
 			} else if (base_ty->kind == Type::ARRAY_TY) { // for an array, we init all elements
 				auto elem_ty = base_ty->array.T->get();
 				auto size = base_ty->array.count;
@@ -858,11 +1973,10 @@ namespace vuk {
 				key = reinterpret_cast<uint64_t>(value);
 			}
 
-			if (enforce_unique) {
-				assert(last_modify.find(key) == last_modify.end());
-				last_modify.emplace(key, new (this->arena.ensure_space(sizeof(PartialStreamResourceUse))) PartialStreamResourceUse(psru));
-			} else {
-				last_modify.try_emplace(key, new (this->arena.ensure_space(sizeof(PartialStreamResourceUse))) PartialStreamResourceUse(psru));
+			auto& state = last_modify[key];
+			assert(!enforce_unique || state.empty());
+			if (state.empty()) {
+				state.push_back(psru);
 			}
 		}
 
@@ -888,7 +2002,6 @@ namespace vuk {
 			} else if (base_ty->hash_value == current_module->types.builtin_buffer) {
 				auto buf = reinterpret_cast<Buffer*>(value);
 				key = reinterpret_cast<uint64_t>(buf->allocation);
-				hash_combine(key, buf->offset);
 			} else if (base_ty->hash_value == current_module->types.builtin_sampled_image) { // sync the image
 				auto& img_att = reinterpret_cast<SampledImage*>(value)->ia;
 				add_sync(current_module->types.get_builtin_image().get(), dst_use, &img_att);
@@ -897,7 +2010,7 @@ namespace vuk {
 				return;
 			}
 
-			auto& head = last_modify.at(key);
+			auto& state = last_modify.at(key);
 
 			if (base_ty->hash_value == current_module->types.builtin_image) {
 				auto& img_att = *reinterpret_cast<ImageAttachment*>(value);
@@ -906,63 +2019,77 @@ namespace vuk {
 
 				while (work_queue.size() > 0) {
 					Subrange::Image dst_range = work_queue.back();
-					Subrange::Image src_range, isection;
+					Subrange::Image isection;
 					work_queue.pop_back();
-					auto src = head;
-					assert(src);
-					for (; src != nullptr; src = src->next) {
-						src_range = { src->subrange.image.base_level, src->subrange.image.level_count, src->subrange.image.base_layer, src->subrange.image.layer_count };
-
-						// we want to make a barrier for the intersection of the source and incoming
-						auto isection_opt = intersect_one(src_range, dst_range);
-						if (isection_opt) {
-							isection = *isection_opt;
-							break;
-						}
-					}
-					assert(src);
-					// remove the existing barrier from the candidates
-					auto found = src;
-
-					// wind to the end
-					for (; src->next != nullptr; src = src->next)
-						;
-					// splinter the source and destination ranges
-					difference_one(src_range, isection, [&](Subrange::Image nb) {
-						// push the splintered src uses
-						PartialStreamResourceUse psru{ *src };
-						psru.subrange.image = { nb.base_level, nb.level_count, nb.base_layer, nb.layer_count };
-						src->next = new (this->arena.ensure_space(sizeof(PartialStreamResourceUse))) PartialStreamResourceUse(psru);
-						src->next->prev = src;
-						src = src->next;
+					// we want to make a barrier for the intersection of the source and incoming
+					auto found = find_overlap(state, dst_range, isection);
+					assert(found != state.size());
+					// copied, as splintering grows the state
+					PartialStreamResourceUse src_use = state[found];
+
+					// splinter the source range, the parts outside of the intersection keep their last use
+					difference_one(src_use.subrange.image, isection, [&](Subrange::Image nb) {
+						PartialStreamResourceUse psru{ src_use };
+						psru.subrange.image = nb;
+						state.push_back(psru);
 					});
 
 					// splinter the dst uses, and push into the work queue
 					difference_one(dst_range, isection, [&](Subrange::Image nb) { work_queue.push_back(nb); });
 
-					auto& src_use = *found;
+					stats->synchronized_ranges++;
 					if (src_use.stream && dst_use.stream && (src_use.stream != dst_use.stream)) {
-						dst_use.stream->add_dependency(src_use.stream);
+						stats->stream_dependencies++;
+						dst_use.stream->add_dependency(src_use.stream, dst_use.stages);
 					}
 					if (src_use.stream != dst_use.stream) {
 						src_use.stream->synch_image(img_att, isection, src_use, dst_use, value); // synchronize dst onto first stream
 					}
 					dst_use.stream->synch_image(img_att, isection, src_use, dst_use, value); // synchronize src onto second stream
 
-					static_cast<StreamResourceUse&>(*found) = dst_use;
-					found->subrange.image.base_level = isection.base_level;
-					found->subrange.image.level_count = isection.level_count;
-					found->subrange.image.base_layer = isection.base_layer;
-					found->subrange.image.layer_count = isection.layer_count;
+					static_cast<StreamResourceUse&>(state[found]) = dst_use;
+					state[found].subrange.image = isection;
 				}
+				coalesce<Subrange::Image>(state);
 			} else if (base_ty->hash_value == current_module->types.builtin_buffer) {
-				auto& src_use = *head;
-				if (src_use.stream && dst_use.stream && (src_use.stream != dst_use.stream)) {
-					dst_use.stream->add_dependency(src_use.stream);
-				}
-				dst_use.stream->synch_memory(src_use, dst_use, value);
+				auto& buf = *reinterpret_cast<Buffer*>(value);
+				std::vector<Subrange::Buffer, inline_alloc<Subrange::Buffer, 1024>> work_queue(this->arena);
+				work_queue.emplace_back(buffer_range(buf));
 
-				static_cast<StreamResourceUse&>(src_use) = dst_use;
+				while (work_queue.size() > 0) {
+					Subrange::Buffer dst_range = work_queue.back();
+					Subrange::Buffer isection;
+					work_queue.pop_back();
+					auto found = find_overlap(state, dst_range, isection);
+					// bytes of the allocation that no one has used yet - nothing to synchronize against
+					if (found == state.size()) {
+						PartialStreamResourceUse psru{ dst_use };
+						psru.subrange.buffer = dst_range;
+						state.push_back(psru);
+						continue;
+					}
+					// copied, as splintering grows the state
+					PartialStreamResourceUse src_use = state[found];
+					// splinter the source range, the parts outside of the intersection keep their last use
+					difference_one(src_use.subrange.buffer, isection, [&](Subrange::Buffer nb) {
+						PartialStreamResourceUse psru{ src_use };
+						psru.subrange.buffer = nb;
+						state.push_back(psru);
+					});
+					// splinter the dst range, and push into the work queue
+					difference_one(dst_range, isection, [&](Subrange::Buffer nb) { work_queue.push_back(nb); });
+
+					stats->synchronized_ranges++;
+					if (src_use.stream && dst_use.stream && (src_use.stream != dst_use.stream)) {
+						stats->stream_dependencies++;
+						dst_use.stream->add_dependency(src_use.stream, dst_use.stages);
+					}
+					dst_use.stream->synch_memory(buf, isection, src_use, dst_use, value);
+
+					static_cast<StreamResourceUse&>(state[found]) = dst_use;
+					state[found].subrange.buffer = isection;
+				}
+				coalesce<Subrange::Buffer>(state);
 			}
 		}
 
@@ -973,26 +2100,29 @@ namespace vuk {
 				key = reinterpret_cast<uint64_t>(img_att.image.image);
 			} else if (base_ty->hash_value == current_module->types.builtin_buffer) {
 				auto buf = reinterpret_cast<Buffer*>(value);
-				key = reinterpret_cast<uint64_t>(buf->allocation);
-				hash_combine(key, buf->offset);
+				auto& state = last_modify.at(reinterpret_cast<uint64_t>(buf->allocation));
+				Subrange::Buffer isection;
+				auto found = find_overlap(state, buffer_range(*buf), isection);
+				assert(found != state.size());
+				return state[found];
 			} else if (base_ty->kind == Type::ARRAY_TY) {
 				if (base_ty->array.count > 0) { // for an array, we key off the the first element, as the array syncs together
 					auto elem_ty = base_ty->array.T->get();
 					auto elems = reinterpret_cast<std::byte*>(value);
 					return last_use(elem_ty, elems);
 				} else { // zero-len arrays
-					return *last_modify.at(0);
+					return last_modify.at(0).front();
 				}
 			} else if (base_ty->hash_value == current_module->types.builtin_sampled_image) { // only image syncs
 				auto& img_att = reinterpret_cast<SampledImage*>(value)->ia;
 				key = reinterpret_cast<uint64_t>(img_att.image.image);
 			} else if (base_ty->kind == Type::INTEGER_TY){ // TODO: generalise
-				return *last_modify.at(0);
+				return last_modify.at(0).front();
 			} else { // other types just key on the voidptr
 				key = reinterpret_cast<uint64_t>(value);
 			}
 
-			return *last_modify.at(key);
+			return last_modify.at(key).front();
 		}
 	};
 
@@ -1021,20 +2151,25 @@ namespace vuk {
 	Result<void> ExecutableRenderGraph::execute(Allocator& alloc) {
 		Runtime& ctx = alloc.get_context();
 
-		Recorder recorder(alloc, &impl->callbacks, impl->pass_reads);
-		recorder.streams.emplace(DomainFlagBits::eHost, std::make_unique<HostStream>(alloc));
+		impl->execute_stats = {};
+		if (!impl->command_buffer_cache) {
+			impl->command_buffer_cache = std::make_shared<CommandBufferCache>(ctx);
+		}
+		VUK_DO_OR_RETURN(impl->command_buffer_cache->collect(ctx.get_frame_count()));
+		Recorder recorder(alloc, &impl->callbacks, impl->pass_reads, &impl->execute_stats);
+		recorder.add_stream(DomainFlagBits::eHost, std::make_unique<HostStream>(alloc));
 		if (auto exe = ctx.get_executor(DomainFlagBits::eGraphicsQueue)) {
-			recorder.streams.emplace(DomainFlagBits::eGraphicsQueue, std::make_unique<VkQueueStream>(alloc, static_cast<QueueExecutor*>(exe), &impl->callbacks));
+			recorder.add_stream(DomainFlagBits::eGraphicsQueue, std::make_unique<VkQueueStream>(alloc, static_cast<QueueExecutor*>(exe), &impl->callbacks, impl->recording_task_runner, &impl->execute_stats));
 		}
 		if (auto exe = ctx.get_executor(DomainFlagBits::eComputeQueue)) {
-			recorder.streams.emplace(DomainFlagBits::eComputeQueue, std::make_unique<VkQueueStream>(alloc, static_cast<QueueExecutor*>(exe), &impl->callbacks));
+			recorder.add_stream(DomainFlagBits::eComputeQueue, std::make_unique<VkQueueStream>(alloc, static_cast<QueueExecutor*>(exe), &impl->callbacks, impl->recording_task_runner, &impl->execute_stats));
 		}
 		if (auto exe = ctx.get_executor(DomainFlagBits::eTransferQueue)) {
-			recorder.streams.emplace(DomainFlagBits::eTransferQueue, std::make_unique<VkQueueStream>(alloc, static_cast<QueueExecutor*>(exe), &impl->callbacks));
+			recorder.add_stream(DomainFlagBits::eTransferQueue, std::make_unique<VkQueueStream>(alloc, static_cast<QueueExecutor*>(exe), &impl->callbacks, impl->recording_task_runner, &impl->execute_stats));
 		}
-		auto host_stream = recorder.streams.at(DomainFlagBits::eHost).get();
+		auto host_stream = recorder.stream_for_domain(DomainFlagBits::eHost);
 		host_stream->executor = ctx.get_executor(DomainFlagBits::eHost);
-		recorder.last_modify.at(0)->stream = host_stream;
+		recorder.last_modify.at(0).front().stream = host_stream;
 
 		std::deque<VkPEStream> pe_streams;
 
@@ -1087,20 +2222,205 @@ namespace vuk {
 			return msg;
 		};
 
-		while (!sched.work_queue.empty()) {
-			auto item = sched.work_queue.front();
-			sched.work_queue.pop_front();
+		// evaluate a construct argument into a field of the bound value
+		auto eval_into = []<class T>(ConstantEvaluator& evaluator, T& dst, Ref arg) -> Result<void, CannotBeConstantEvaluated> {
+			auto res = evaluator.eval<T>(arg);
+			if (!res) {
+				return res;
+			}
+			dst = *res;
+			return { expected_value };
+		};
+
+		// collapse inferencing of the construct arguments into the bound value
+		auto infer_buffer = [&](ConstantEvaluator& evaluator, Node* node) -> Result<void, CannotBeConstantEvaluated> {
+			auto& bound = constant<Buffer>(node->construct.args[0]);
+			return eval_into(evaluator, bound.size, node->construct.args[1]);
+		};
+
+		auto infer_image = [&](ConstantEvaluator& evaluator, Node* node) -> Result<void, CannotBeConstantEvaluated> {
+			auto& attachment = *reinterpret_cast<ImageAttachment*>(node->construct.args[0].node->constant.value);
+			auto& args = node->construct.args;
+			VUK_DO_OR_RETURN(eval_into(evaluator, attachment.extent.width, args[1]));
+			VUK_DO_OR_RETURN(eval_into(evaluator, attachment.extent.height, args[2]));
+			VUK_DO_OR_RETURN(eval_into(evaluator, attachment.extent.depth, args[3]));
+			VUK_DO_OR_RETURN(eval_into(evaluator, attachment.format, args[4]));
+			VUK_DO_OR_RETURN(eval_into(evaluator, attachment.sample_count, args[5]));
+			VUK_DO_OR_RETURN(eval_into(evaluator, attachment.base_layer, args[6]));
+			VUK_DO_OR_RETURN(eval_into(evaluator, attachment.layer_count, args[7]));
+			VUK_DO_OR_RETURN(eval_into(evaluator, attachment.base_level, args[8]));
+			VUK_DO_OR_RETURN(eval_into(evaluator, attachment.level_count, args[9]));
+
+			if (attachment.image_view == ImageView{}) {
+				if (attachment.view_type == ImageViewType::eInfer && attachment.layer_count != VK_REMAINING_ARRAY_LAYERS) {
+					if (attachment.image_type == ImageType::e1D) {
+						if (attachment.layer_count == 1) {
+							attachment.view_type = ImageViewType::e1D;
+						} else {
+							attachment.view_type = ImageViewType::e1DArray;
+						}
+					} else if (attachment.image_type == ImageType::e2D) {
+						if (attachment.layer_count == 1) {
+							attachment.view_type = ImageViewType::e2D;
+						} else {
+							attachment.view_type = ImageViewType::e2DArray;
+						}
+					} else if (attachment.image_type == ImageType::e3D) {
+						if (attachment.layer_count == 1) {
+							attachment.view_type = ImageViewType::e3D;
+						} else {
+							attachment.view_type = ImageViewType::e2DArray;
+						}
+					}
+				}
+			}
+			return { expected_value };
+		};
+
+		// constructed buffers can be bound for any use, so they get the strictest offset alignment of the device
+		auto construct_buffer_info = [&](const Buffer& bound) {
+			return BufferCreateInfo{ .mem_usage = bound.memory_usage, .size = bound.size, .alignment = ctx.min_buffer_alignment };
+		};
+
+		// allocate the images and buffers constructed by the graph before executing it, with one call per allocator and resource kind
+		// constructs with arguments that can only be evaluated during execution are inferred and allocated when they are reached
+		std::vector<Node*> inferred_constructs; // sorted, not inferred again when reached
+		auto allocate_constructs = [&]() -> Result<void> {
+			TraceScope _(TraceCategory::eAllocation, "allocate_constructs");
+			// one evaluator for all constructs - nothing runs until they are allocated, and arguments derived from the same values are evaluated once
+			std::pmr::monotonic_buffer_resource resource;
+			ConstantEvaluator evaluator(&resource);
+			auto try_infer = [&](auto& infer, Node* node) {
+				auto res = infer(evaluator, node);
+				if (!res.holds_value()) {
+					(void)res.error();
+					return false;
+				}
+				inferred_constructs.push_back(node);
+				return true;
+			};
+
+			struct Batch {
+				Allocator allocator;
+				std::vector<Buffer*> buffers;
+				std::vector<BufferCreateInfo> bcis;
+				std::vector<Node*> image_nodes;
+				std::vector<ImageCreateInfo> icis;
+			};
+			std::vector<Batch> batches;
+			auto batch_for = [&](Node* node) -> Batch& {
+				auto allocator = node->construct.allocator ? *node->construct.allocator : alloc;
+				for (auto& batch : batches) {
+					if (&batch.allocator.get_device_resource() == &allocator.get_device_resource()) {
+						return batch;
+					}
+				}
+				return batches.emplace_back(Batch{ allocator });
+			};
+
+			for (auto& node : impl->nodes) {
+				if (node->kind != Node::CONSTRUCT || node->execution_info) {
+					continue;
+				}
+				if (node->type[0]->hash_value == current_module->types.builtin_buffer) {
+					auto& bound = constant<Buffer>(node->construct.args[0]);
+					if (bound.buffer != VK_NULL_HANDLE || !try_infer(infer_buffer, node) || bound.size == ~(0u) || bound.memory_usage == (MemoryUsage)0) {
+						continue;
+					}
+					auto& batch = batch_for(node);
+					batch.buffers.push_back(&bound);
+					batch.bcis.push_back(construct_buffer_info(bound));
+				} else if (node->type[0]->hash_value == current_module->types.builtin_image) {
+					auto& attachment = *reinterpret_cast<ImageAttachment*>(node->construct.args[0].node->constant.value);
+					// the view format list can't be batched
+					if (attachment.image || attachment.allow_srgb_unorm_mutable || !try_infer(infer_image, node)) {
+						continue;
+					}
+					attachment.usage |= impl->compute_usage(&first(node).link());
+					assert(attachment.usage != ImageUsageFlags{});
+					auto& batch = batch_for(node);
+					batch.image_nodes.push_back(node);
+					batch.icis.push_back(image_create_info(attachment));
+				}
+			}
+
+			// like the Unique of a single allocation, the resources are handed back to the allocator right away, which keeps them alive until it recycles them
+			for (auto& batch : batches) {
+				if (!batch.bcis.empty()) {
+					TraceScope _(TraceCategory::eAllocation, "allocate_buffers", batch.bcis.size());
+					std::vector<Buffer> buffers(batch.bcis.size());
+					VUK_DO_OR_RETURN(batch.allocator.allocate_buffers(std::span(buffers), std::span(batch.bcis)));
+					for (size_t i = 0; i < buffers.size(); i++) {
+						*batch.buffers[i] = buffers[i];
+					}
+					batch.allocator.deallocate(std::span<const Buffer>(buffers));
+					impl->execute_stats.batched_allocations += buffers.size();
+				}
+				if (!batch.icis.empty()) {
+					TraceScope _(TraceCategory::eAllocation, "allocate_images", batch.icis.size());
+					std::vector<Image> images(batch.icis.size());
+					VUK_DO_OR_RETURN(batch.allocator.allocate_images(std::span(images), std::span(batch.icis)));
+					for (size_t i = 0; i < images.size(); i++) {
+						auto node = batch.image_nodes[i];
+						auto& attachment = *reinterpret_cast<ImageAttachment*>(node->construct.args[0].node->constant.value);
+						attachment.image = images[i];
+						if (node->debug_info && node->debug_info->result_names.size() > 0 && !node->debug_info->result_names[0].empty()) {
+							ctx.set_name(attachment.image.image, node->debug_info->result_names[0].c_str());
+						}
+					}
+					batch.allocator.deallocate(std::span<const Image>(images));
+					impl->execute_stats.batched_allocations += images.size();
+				}
+			}
+			std::sort(inferred_constructs.begin(), inferred_constructs.end());
+			return { expected_value };
+		};
+		VUK_DO_OR_RETURN(allocate_constructs());
+		// constructs reached during execution, one evaluator each - intermediate results live on the stack unless the expression is large
+		auto infer_reached = [&](auto& infer, Node* node) -> Result<void, CannotBeConstantEvaluated> {
+			if (std::binary_search(inferred_constructs.begin(), inferred_constructs.end(), node)) {
+				return { expected_value };
+			}
+			std::byte buffer[1024];
+			std::pmr::monotonic_buffer_resource resource(buffer, sizeof(buffer));
+			ConstantEvaluator evaluator(&resource);
+			return infer(evaluator, node);
+		};
+
+		// passes that run after scheduling continues see the values of their arguments as of when they were scheduled
+		auto snapshot_value = [&](Ref parm) -> void* {
+			auto value = sched.get_value(parm);
+			auto base_ty = sched.base_type(parm).get();
+			if (!is_synchronized_in_place(base_ty)) {
+				return value;
+			}
+			auto snapshot = impl->mbr.allocate(base_ty->size, alignof(std::max_align_t));
+			memcpy(snapshot, value, base_ty->size);
+			return snapshot;
+		};
+
+		TraceScope execute_scope(TraceCategory::eSchedule, "execute");
+		ScheduledItem item;
+		while (true) {
+			auto has_next = sched.next(item);
+			if (!has_next) {
+				return std::move(has_next);
+			}
+			if (!*has_next) {
+				break;
+			}
 			auto& node = item.execable;
 			if (node->execution_info) { // only going execute things once
 				continue;
 			}
+			TraceScope node_scope(TraceCategory::eSchedule, node->kind_to_sv().data(), sched.instr_counter + 1, item.ready);
 			if (item.ready) {
 				sched.instr_counter++;
 #ifdef VUK_DUMP_EXEC
 				fmt::print("[{:#06x}] ", sched.instr_counter);
 #endif
 			}
-			// we run nodes twice - first time we reenqueue at the front and then put all deps before it
+			// we see nodes twice - first time we only schedule their deps, which records them in the plan
 			// second time we see it, we know that all deps have run, so we can run the node itself
 			switch (node->kind) {
 			case Node::MATH_BINARY: {
@@ -1147,26 +2467,11 @@ namespace vuk {
 				}
 				break;
 			}
-#define EVAL(dst, arg)                                                                                                                                         \
-	auto UNIQUE_NAME(A) = eval2(arg);                                                                                                                            \
-	if (!UNIQUE_NAME(A)) {                                                                                                                                       \
-		return UNIQUE_NAME(A);                                                                                                                                     \
-	}                                                                                                                                                            \
-	if (UNIQUE_NAME(A)->is_ref) {                                                                                                                                \
-		return { expected_error, CannotBeConstantEvaluated{ arg } };                                                                                               \
-	}                                                                                                                                                            \
-	dst = *reinterpret_cast<decltype(dst)*>(UNIQUE_NAME(A)->value);                                                                                              \
-	if (UNIQUE_NAME(A)->owned) {                                                                                                                                 \
-		delete[] UNIQUE_NAME(A)->value;                                                                                                                            \
-	}
 			case Node::CONSTRUCT: { // when encountering a CONSTRUCT, allocate the thing if needed
 				if (sched.process(item)) {
 					if (node->type[0]->hash_value == current_module->types.builtin_buffer) {
 						auto& bound = constant<Buffer>(node->construct.args[0]);
-						auto res = [&]() -> Result<void, CannotBeConstantEvaluated> {
-							EVAL(bound.size, node->construct.args[1]);
-							return { expected_value };
-						}();
+						auto res = infer_reached(infer_buffer, node);
 						if (!res) {
 							if (res.error().ref.node->kind == Node::PLACEHOLDER) {
 								return { expected_error,
@@ -1186,8 +2491,10 @@ namespace vuk {
 						if (bound.buffer == VK_NULL_HANDLE) {
 							assert(bound.size != ~(0u));
 							assert(bound.memory_usage != (MemoryUsage)0);
-							BufferCreateInfo bci{ .mem_usage = bound.memory_usage, .size = bound.size, .alignment = 1 }; // TODO: alignment?
+							auto bci = construct_buffer_info(bound);
 							auto allocator = node->construct.allocator ? *node->construct.allocator : alloc;
+							TraceScope _(TraceCategory::eAllocation, "allocate_buffer", bci.size);
+							impl->execute_stats.deferred_allocations++;
 							auto buf = allocate_buffer(allocator, bci);
 							if (!buf) {
 								return buf;
@@ -1198,43 +2505,7 @@ namespace vuk {
 						recorder.init_sync(node->type[0].get(), { to_use(eNone), host_stream }, sched.get_value(first(node)));
 					} else if (node->type[0]->hash_value == current_module->types.builtin_image) {
 						auto& attachment = *reinterpret_cast<ImageAttachment*>(node->construct.args[0].node->constant.value);
-						// collapse inferencing
-						auto res = [&]() -> Result<void, CannotBeConstantEvaluated> {
-							EVAL(attachment.extent.width, node->construct.args[1]);
-							EVAL(attachment.extent.height, node->construct.args[2]);
-							EVAL(attachment.extent.depth, node->construct.args[3]);
-							EVAL(attachment.format, node->construct.args[4]);
-							EVAL(attachment.sample_count, node->construct.args[5]);
-							EVAL(attachment.base_layer, node->construct.args[6]);
-							EVAL(attachment.layer_count, node->construct.args[7]);
-							EVAL(attachment.base_level, node->construct.args[8]);
-							EVAL(attachment.level_count, node->construct.args[9]);
-
-							if (attachment.image_view == ImageView{}) {
-								if (attachment.view_type == ImageViewType::eInfer && attachment.layer_count != VK_REMAINING_ARRAY_LAYERS) {
-									if (attachment.image_type == ImageType::e1D) {
-										if (attachment.layer_count == 1) {
-											attachment.view_type = ImageViewType::e1D;
-										} else {
-											attachment.view_type = ImageViewType::e1DArray;
-										}
-									} else if (attachment.image_type == ImageType::e2D) {
-										if (attachment.layer_count == 1) {
-											attachment.view_type = ImageViewType::e2D;
-										} else {
-											attachment.view_type = ImageViewType::e2DArray;
-										}
-									} else if (attachment.image_type == ImageType::e3D) {
-										if (attachment.layer_count == 1) {
-											attachment.view_type = ImageViewType::e3D;
-										} else {
-											attachment.view_type = ImageViewType::e2DArray;
-										}
-									}
-								}
-							}
-							return { expected_value };
-						}();
+						auto res = infer_reached(infer_image, node);
 						if (!res) {
 							if (res.error().ref.node->kind == Node::PLACEHOLDER) {
 								return { expected_error,
@@ -1255,6 +2526,8 @@ namespace vuk {
 							auto allocator = node->construct.allocator ? *node->construct.allocator : alloc;
 							attachment.usage |= impl->compute_usage(&first(node).link());
 							assert(attachment.usage != ImageUsageFlags{});
+							TraceScope _(TraceCategory::eAllocation, "allocate_image");
+							impl->execute_stats.deferred_allocations++;
 							auto img = allocate_image(allocator, attachment);
 							if (!img) {
 								return img;
@@ -1338,6 +2611,47 @@ namespace vuk {
 				if (sched.process(item)) {                    // we have executed every dep, so execute ourselves too
 					Stream* dst_stream = item.scheduled_stream; // the domain this call will execute on
 
+					// host passes run when the host stream is submitted, the scheduling continues with their aliased returns
+					if (dst_stream->domain == DomainFlagBits::eHost) {
+						assert(fn_type->kind == Type::OPAQUE_FN_TY);
+						auto host = static_cast<HostStream*>(dst_stream);
+						std::pmr::polymorphic_allocator<void*> allocator(&impl->mbr);
+						auto& ret_types = fn_type->opaque_fn.return_types;
+						size_t arg_count = node->call.args.size() - first_parm;
+						std::span<void*> opaque_args{ allocator.allocate(arg_count), arg_count };
+						std::span<void*> opaque_meta{ allocator.allocate(arg_count), arg_count };
+						std::span<void*> opaque_rets{ allocator.allocate(ret_types.size()), ret_types.size() };
+						std::vector<HostStream::Access> accesses;
+						for (size_t i = first_parm; i < node->call.args.size(); i++) {
+							auto& arg_ty = args[i - first_parm];
+							auto& parm = node->call.args[i];
+							assert(arg_ty->kind == Type::IMBUED_TY);
+							bool write = is_write_access(arg_ty->imbued.access);
+							recorder.add_sync(sched.base_type(parm).get(),
+							                  sched.get_dependency_info(parm, arg_ty.get(), write ? RW::eWrite : RW::eRead, dst_stream, node),
+							                  sched.get_value(parm));
+							HostStream::collect_accesses(sched.base_type(parm).get(), sched.get_value(parm), write, accesses);
+							opaque_args[i - first_parm] = snapshot_value(parm);
+							opaque_meta[i - first_parm] = &parm;
+						}
+						// the returns alias the live values
+						for (size_t i = 0; i < ret_types.size(); i++) {
+							opaque_rets[i] = sched.get_value(node->call.args[ret_types[i]->aliased.ref_idx]);
+						}
+						VUK_DO_OR_RETURN(host->add_pass(
+						    [&ctx, &alloc, host, fn_type, opaque_args, opaque_meta, opaque_rets]() mutable {
+							    CommandBuffer cobuf(*host, ctx, alloc, VK_NULL_HANDLE);
+							    (*fn_type->callback)(cobuf, opaque_args, opaque_meta, opaque_rets);
+						    },
+						    std::move(accesses)));
+#ifdef VUK_DUMP_EXEC
+						print_results(node);
+						fmt::print(" = call ${} <{}> (host)\n", domain_to_string(dst_stream->domain), fn_type->debug_info.name);
+#endif
+						sched.done(node, dst_stream, opaque_rets);
+						break;
+					}
+
 					auto vk_rec = dynamic_cast<VkQueueStream*>(dst_stream); // TODO: change this into dynamic dispatch on the Stream
 					assert(vk_rec);
 					// run all the barriers here!
@@ -1373,11 +2687,16 @@ namespace vuk {
 
 							// Write and ReadWrite
 							RW sync_access = (is_write_access(access)) ? RW::eWrite : RW::eRead;
-							recorder.add_sync(sched.base_type(parm).get(), sched.get_dependency_info(parm, arg_ty.get(), sync_access, dst_stream), sched.get_value(parm));
+							recorder.add_sync(
+							    sched.base_type(parm).get(), sched.get_dependency_info(parm, arg_ty.get(), sync_access, dst_stream, node), sched.get_value(parm));
 
 							if (is_framebuffer_attachment(access)) {
 								auto& img_att = sched.get_value<ImageAttachment>(parm);
-								vk_rec->prepare_render_pass_attachment(alloc, img_att);
+								bool load_contents = !vk_rec->has_undefined_contents(img_att);
+								bool store_contents = !is_write_access(access) || !is_dead_after_write(parm);
+								impl->execute_stats.avoided_loads += !load_contents;
+								impl->execute_stats.avoided_stores += !store_contents;
+								vk_rec->prepare_render_pass_attachment(alloc, img_att, load_contents, store_contents);
 							}
 						} else {
 							assert(0);
@@ -1386,6 +2705,167 @@ namespace vuk {
 
 					// make the renderpass if needed!
 					recorder.synchronize_stream(dst_stream);
+					// replay the commands recorded by an earlier execution of the pass, or record them for reuse
+					if (fn_type->kind == Type::OPAQUE_FN_TY && node->scheduling_info && node->scheduling_info->reuse_commands) {
+						std::pmr::polymorphic_allocator<void*> allocator(&impl->mbr);
+						auto& ret_types = fn_type->opaque_fn.return_types;
+						size_t arg_count = node->call.args.size() - first_parm;
+						std::span<void*> opaque_args{ allocator.allocate(arg_count), arg_count };
+						std::span<void*> opaque_meta{ allocator.allocate(arg_count), arg_count };
+						std::span<void*> opaque_rets{ allocator.allocate(ret_types.size()), ret_types.size() };
+						for (size_t i = first_parm; i < node->call.args.size(); i++) {
+							auto& parm = node->call.args[i];
+							opaque_args[i - first_parm] = sched.get_value(parm);
+							opaque_meta[i - first_parm] = &parm;
+						}
+						// the returns alias the arguments, so they are known without running the callback
+						for (size_t i = 0; i < ret_types.size(); i++) {
+							opaque_rets[i] = opaque_args[ret_types[i]->aliased.ref_idx - first_parm];
+						}
+
+						auto& rp = vk_rec->rp;
+						CommandBufferCache::Key cache_key{ .fn_hash = Type::hash(fn_type.get()),
+							                                 .name = fn_type->debug_info.name,
+							                                 .queue_family = vk_rec->executor->get_queue_family_index(),
+							                                 .pipeline_generation = ctx.get_pipeline_generation(),
+							                                 .has_render_pass = rp.rpci.attachments.size() > 0 };
+						size_t key = 0;
+						hash_combine(key, cache_key.fn_hash, cache_key.name, cache_key.queue_family, cache_key.pipeline_generation);
+						for (size_t i = 0; i < arg_count; i++) {
+							collect_key_fields(args[i].get(), opaque_args[i], cache_key.args);
+						}
+						for (auto field : cache_key.args) {
+							hash_combine(key, field);
+						}
+						if (cache_key.has_render_pass) {
+							cache_key.rpci = rp.rpci;
+							cache_key.fbci = rp.fbci;
+							hash_combine(key, rp.rpci, rp.fbci);
+						}
+
+						auto& cache = *impl->command_buffer_cache;
+						VUK_DO_OR_RETURN(cache.drop_destroyed());
+						auto& entries = cache.entries;
+						auto it = entries.find(key);
+						// a hash collision - the previous entry is replaced
+						if (it != entries.end() && !(it->second->key == cache_key)) {
+							VUK_DO_OR_RETURN(cache.retire(*it->second));
+							entries.erase(it);
+							it = entries.end();
+						}
+						if (it != entries.end()) {
+							impl->execute_stats.replayed_command_buffers++;
+							vk_rec->attachment_contents.clear();
+						} else {
+							impl->execute_stats.recorded_command_buffers++;
+							it = entries.emplace(key, std::make_unique<CommandBufferCache::Entry>(ctx.get_vk_resource(), std::move(cache_key))).first;
+							for (size_t i = 0; i < arg_count; i++) {
+								collect_handles(args[i].get(), opaque_args[i], it->second->handles);
+							}
+							cache.reference(*it->second);
+							auto& entry = *it->second;
+							// queries would be written again by every replay, so the pass profiler and the profiling callbacks are not invoked
+							auto record = [&]() -> Result<void> {
+								VUK_DO_OR_RETURN(vk_rec->begin_reusable_cbuf(entry));
+								auto cb = entry.command_buffer;
+								Allocator entry_alloc(entry.resource);
+								if (rp.rpci.attachments.size() > 0) {
+									VUK_DO_OR_RETURN(vk_rec->prepare_render_pass(false, &entry_alloc));
+									entry.render_pass = rp.handle;
+								}
+								CommandBuffer cobuf(*vk_rec, ctx, entry_alloc, cb);
+								if (!fn_type->debug_info.name.empty()) {
+									ctx.begin_region(cb, fn_type->debug_info.name.c_str());
+								}
+								if (rp.handle) {
+									begin_render_pass(ctx, rp, cb, false);
+								}
+								fill_render_pass_info(rp, 0, cobuf);
+								(*fn_type->callback)(cobuf, opaque_args, opaque_meta, opaque_rets);
+								if (rp.handle) {
+									ctx.vkCmdEndRenderPass(cb);
+								}
+								if (!fn_type->debug_info.name.empty()) {
+									ctx.end_region(cb);
+								}
+								if (auto result = ctx.vkEndCommandBuffer(cb); result != VK_SUCCESS) {
+									return { expected_error, VkException{ result } };
+								}
+								return { expected_value };
+							};
+							if (auto result = record(); !result) {
+								entries.erase(it);
+								return result;
+							}
+						}
+						auto& entry = *it->second;
+						entry.last_use = ctx.get_frame_count();
+						vk_rec->rp = {};
+						VUK_DO_OR_RETURN(vk_rec->append_reusable_cbuf(entry));
+#ifdef VUK_DUMP_EXEC
+						print_results(node);
+						fmt::print(" = call ${} <{}> (reused)\n", domain_to_string(dst_stream->domain), fn_type->debug_info.name);
+#endif
+						sched.done(node, dst_stream, opaque_rets);
+						break;
+					}
+					// record the user cb through the task runner
+					if (fn_type->kind == Type::OPAQUE_FN_TY && vk_rec->task_runner) {
+						std::pmr::polymorphic_allocator<void*> allocator(&impl->mbr);
+						auto& ret_types = fn_type->opaque_fn.return_types;
+						size_t arg_count = node->call.args.size() - first_parm;
+						std::span<void*> opaque_args{ allocator.allocate(arg_count), arg_count };
+						std::span<void*> opaque_meta{ allocator.allocate(arg_count), arg_count };
+						std::span<void*> opaque_rets{ allocator.allocate(ret_types.size()), ret_types.size() };
+						for (size_t i = first_parm; i < node->call.args.size(); i++) {
+							auto& parm = node->call.args[i];
+							opaque_args[i - first_parm] = snapshot_value(parm);
+							opaque_meta[i - first_parm] = &parm;
+						}
+						// the returns alias the live values, so they are known before the callback runs
+						for (size_t i = 0; i < ret_types.size(); i++) {
+							opaque_rets[i] = sched.get_value(node->call.args[ret_types[i]->aliased.ref_idx]);
+						}
+
+						if (vk_rec->rp.rpci.attachments.size() > 0) {
+							VUK_DO_OR_RETURN(vk_rec->prepare_render_pass(false));
+						}
+						VUK_DO_OR_RETURN(vk_rec->defer_pass(
+						    [&ctx, vk_rec, fn_type, opaque_args, opaque_meta, opaque_rets, rp = std::move(vk_rec->rp)](VkCommandBuffer cb, Allocator& worker_alloc) mutable {
+							    CommandBuffer cobuf(*vk_rec, ctx, worker_alloc, cb);
+							    if (!fn_type->debug_info.name.empty()) {
+								    ctx.begin_region(cb, fn_type->debug_info.name.c_str());
+							    }
+							    auto timer = vk_rec->begin_pass_timer(cb);
+
+							    void* rpass_profile_data = nullptr;
+							    if (vk_rec->callbacks->on_begin_pass)
+								    rpass_profile_data =
+								        vk_rec->callbacks->on_begin_pass(vk_rec->callbacks->user_data, fn_type->debug_info.name.c_str(), cobuf, vk_rec->domain);
+
+							    if (rp.handle) {
+								    begin_render_pass(ctx, rp, cb, false);
+							    }
+							    fill_render_pass_info(rp, 0, cobuf);
+							    (*fn_type->callback)(cobuf, opaque_args, opaque_meta, opaque_rets);
+							    if (rp.handle) {
+								    ctx.vkCmdEndRenderPass(cb);
+							    }
+							    vk_rec->end_pass_timer(cb, timer, fn_type->debug_info.name);
+							    if (!fn_type->debug_info.name.empty()) {
+								    ctx.end_region(cb);
+							    }
+							    if (vk_rec->callbacks->on_end_pass)
+								    vk_rec->callbacks->on_end_pass(vk_rec->callbacks->user_data, rpass_profile_data);
+						    }));
+						vk_rec->rp = {};
+#ifdef VUK_DUMP_EXEC
+						print_results(node);
+						fmt::print(" = call ${} <{}> (deferred)\n", domain_to_string(dst_stream->domain), fn_type->debug_info.name);
+#endif
+						sched.done(node, dst_stream, opaque_rets);
+						break;
+					}
 					// run the user cb!
 					std::vector<void*, short_alloc<void*>> opaque_rets(*impl->arena_);
 					if (fn_type->kind == Type::OPAQUE_FN_TY) {
@@ -1393,6 +2873,7 @@ namespace vuk {
 						if (!fn_type->debug_info.name.empty()) {
 							ctx.begin_region(vk_rec->cbuf, fn_type->debug_info.name.c_str());
 						}
+						auto timer = vk_rec->begin_pass_timer(vk_rec->cbuf);
 
 						void* rpass_profile_data = nullptr;
 						if (vk_rec->callbacks->on_begin_pass)
@@ -1415,6 +2896,7 @@ namespace vuk {
 						if (vk_rec->rp.handle) {
 							vk_rec->end_render_pass();
 						}
+						vk_rec->end_pass_timer(vk_rec->cbuf, timer, fn_type->debug_info.name);
 						if (!fn_type->debug_info.name.empty()) {
 							ctx.end_region(vk_rec->cbuf);
 						}
@@ -1425,6 +2907,7 @@ namespace vuk {
 						if (!fn_type->debug_info.name.empty()) {
 							ctx.begin_region(vk_rec->cbuf, fn_type->debug_info.name.c_str());
 						}
+						auto timer = vk_rec->begin_pass_timer(vk_rec->cbuf);
 
 						void* rpass_profile_data = nullptr;
 						if (vk_rec->callbacks->on_begin_pass)
@@ -1478,6 +2961,7 @@ namespace vuk {
 						if (vk_rec->rp.handle) {
 							vk_rec->end_render_pass();
 						}
+						vk_rec->end_pass_timer(vk_rec->cbuf, timer, fn_type->debug_info.name);
 						if (!fn_type->debug_info.name.empty()) {
 							ctx.end_region(vk_rec->cbuf);
 						}
@@ -1505,7 +2989,7 @@ namespace vuk {
 							auto access = arg_ty->imbued.access;
 							// Write and ReadWrite
 							RW sync_access = (is_write_access(access)) ? RW::eWrite : RW::eRead;
-							sched.schedule_dependency(parm, sync_access);
+							sched.schedule_dependency(parm, sync_access, node);
 						} else {
 							assert(0);
 						}
@@ -1576,23 +3060,24 @@ namespace vuk {
 						}
 						if (is_release) {
 							// for releases, run deferred splices before submission
-							auto it = impl->deferred_splices.find(node);
-							if (it != impl->deferred_splices.end()) {
-								for (auto& splice_ref : it->second) {
-									assert(splice_ref.node->kind == Node::SPLICE);
-									auto pending = ++impl->pending_splice_sigs.at(splice_ref.node);
-									auto& splice = splice_ref.node->splice;
-									assert(splice.rel_acq);
-									auto& parm = splice.src[splice_ref.index];
-									splice.rel_acq->last_use[splice_ref.index] = recorder.last_use(sched.base_type(parm).get(), sched.get_value(parm));
-									memcpy(splice.values[splice_ref.index], impl->get_value(parm), parm.type()->size);
-
-									// if all of the splice was encountered, add signal to the stream where this node ran
-									if (pending == splice_ref.node->splice.src.size()) {
-										sched_stream->add_dependent_signal(splice.rel_acq);
-									}
+							for (auto& deferred : impl->get_deferred_splices(node)) {
+								auto splice_ref = deferred.splice;
+								if (!splice_ref) {
+									continue;
+								}
+								assert(splice_ref.node->kind == Node::SPLICE);
+								auto pending = ++impl->pending_splice_sigs[deferred.slot];
+								auto& splice = splice_ref.node->splice;
+								assert(splice.rel_acq);
+								auto& parm = splice.src[splice_ref.index];
+								splice.rel_acq->last_use[splice_ref.index] = recorder.last_use(sched.base_type(parm).get(), sched.get_value(parm));
+								memcpy(splice.values[splice_ref.index], impl->get_value(parm), parm.type()->size);
+
+								// if all of the splice was encountered, add signal to the stream where this node ran
+								if (pending == splice_ref.node->splice.src.size()) {
+									sched_stream->add_dependent_signal(splice.rel_acq);
 								}
-								impl->deferred_splices.erase(it);
+								deferred.splice = {};
 							}
 
 							if (acqrel && sched_domain == DomainFlagBits::eHost) {
@@ -1607,9 +3092,9 @@ namespace vuk {
 								if (acqrel) {
 									acqrel->status = Signal::Status::eHostAvailable; // TODO: ???
 								}
-							} else {
-								sched_stream->submit();
 							}
+							// other releases are submitted when another stream waits on this one or at the end of the execution
+
 #ifdef VUK_DUMP_EXEC
 							print_results(node);
 							fmt::print(" = release ${} -> ${} ", domain_to_string(sched_domain), domain_to_string(dst_domain));
@@ -1820,27 +3305,39 @@ namespace vuk {
 
 			// run splice signalling
 			if (node->execution_info) {
-				auto it = impl->deferred_splices.find(node);
-				if (it != impl->deferred_splices.end()) {
-					for (auto& splice_ref : it->second) {
-						assert(splice_ref.node->kind == Node::SPLICE);
-						auto pending = ++impl->pending_splice_sigs.at(splice_ref.node);
-						auto& splice = splice_ref.node->splice;
-						assert(splice.rel_acq);
-						auto& parm = splice.src[splice_ref.index];
-						splice.rel_acq->last_use[splice_ref.index] = recorder.last_use(sched.base_type(parm).get(), sched.get_value(parm));
-						memcpy(splice.values[splice_ref.index], impl->get_value(parm), parm.type()->size);
-
-						// if all of the splice was encountered, add signal to the stream where this node ran
-						if (pending == splice_ref.node->splice.src.size()) {
-							node->execution_info->stream->add_dependent_signal(splice.rel_acq);
-						}
+				for (auto& deferred : impl->get_deferred_splices(node)) {
+					auto splice_ref = deferred.splice;
+					if (!splice_ref) {
+						continue;
+					}
+					assert(splice_ref.node->kind == Node::SPLICE);
+					auto pending = ++impl->pending_splice_sigs[deferred.slot];
+					auto& splice = splice_ref.node->splice;
+					assert(splice.rel_acq);
+					auto& parm = splice.src[splice_ref.index];
+					splice.rel_acq->last_use[splice_ref.index] = recorder.last_use(sched.base_type(parm).get(), sched.get_value(parm));
+					memcpy(splice.values[splice_ref.index], impl->get_value(parm), parm.type()->size);
+
+					// if all of the splice was encountered, add signal to the stream where this node ran
+					if (pending == splice_ref.node->splice.src.size()) {
+						node->execution_info->stream->add_dependent_signal(splice.rel_acq);
 					}
+					deferred.splice = {};
 				}
 			}
 		}
 
+		// submit all streams with pending signals - each stream submits the streams it waits on first
+		for (auto& [domain, stream] : recorder.streams) {
+			if (!stream->dependent_signals.empty()) {
+				VUK_DO_OR_RETURN(stream->submit());
+			}
+		}
+		// the host passes nothing waited on yet
+		VUK_DO_OR_RETURN(host_stream->submit());
+
 		// post-run: checks and cleanup
+		// the modules are kept alive until the nodes we ran are cleaned up
 		std::vector<std::shared_ptr<IRModule>> modules;
 		for (auto& depnode : impl->depnodes) {
 			modules.push_back(depnode->source_module);
@@ -1862,13 +3359,18 @@ namespace vuk {
 				// SPLICE nodes are unlinked
 				if (node->kind == Node::SPLICE) {
 					assert(!node->splice.rel_acq || node->splice.rel_acq->status != Signal::Status::eDisarmed);
-					delete node->splice.src.data();
-					node->splice.src = {};
+					if (!node->splice.src.empty()) {
+						delete node->splice.src.data();
+						node->splice.src = {};
+						impl->touch(node);
+					}
 				}
 			}
 		}
+		impl->nodes.clear();
 
 		impl->deferred_splices.clear();
+		impl->pending_splice_sigs.clear();
 		impl->garbage_nodes.insert(impl->garbage_nodes.end(), current_module->garbage.begin(), current_module->garbage.end());
 		std::sort(impl->garbage_nodes.begin(), impl->garbage_nodes.end());
 		impl->garbage_nodes.erase(std::unique(impl->garbage_nodes.begin(), impl->garbage_nodes.end()), impl->garbage_nodes.end());
@@ -1879,12 +3381,6 @@ namespace vuk {
 		current_module->garbage.clear();
 		impl->garbage_nodes.clear();
 
-		for (auto& m : modules) {
-			for (auto& op : m->op_arena) {
-				op.links = nullptr;
-			}
-		}
-
 		current_module->types.collect();
 
 		return { expected_value };
@@ -1,4 +1,5 @@
 #include "vuk/runtime/vk/DeviceFrameResource.hpp"
+#include "vuk/Trace.hpp"
 #include "vuk/runtime/Cache.hpp"
 #include "vuk/runtime/vk/BufferAllocator.hpp"
 #include "vuk/runtime/vk/Descriptor.hpp"
@@ -8,6 +9,7 @@
 #include "vuk/runtime/vk/VkRuntime.hpp"
 #include "vuk/runtime/vk/VkQueueExecutor.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <mutex>
 #include <numeric>
@@ -498,39 +500,20 @@ namespace vuk {
 
 	void DeviceFrameResource::deallocate_render_passes(std::span<const VkRenderPass> src) {}
 
-	void DeviceFrameResource::wait() {
-		if (impl->fences.size() > 0) {
-			if (impl->fences.size() > 64) {
-				int i = 0;
-				for (; i < impl->fences.size() - 64; i += 64) {
-					impl->ctx->vkWaitForFences(device, 64, impl->fences.data() + i, true, UINT64_MAX);
-				}
-				impl->ctx->vkWaitForFences(device, (uint32_t)impl->fences.size() - i, impl->fences.data() + i, true, UINT64_MAX);
-			} else {
-				impl->ctx->vkWaitForFences(device, (uint32_t)impl->fences.size(), impl->fences.data(), true, UINT64_MAX);
+	Result<void> DeviceFrameResource::wait() {
+		// at most 64 fences per wait
+		for (size_t i = 0; i < impl->fences.size(); i += 64) {
+			auto count = (uint32_t)std::min<size_t>(impl->fences.size() - i, 64);
+			VkResult result = impl->ctx->vkWaitForFences(device, count, impl->fences.data() + i, true, UINT64_MAX);
+			if (result != VK_SUCCESS) {
+				return { expected_error, VkException{ result } };
 			}
 		}
 		if (impl->syncpoints.size() > 0) {
-			VkSemaphoreWaitInfo swi{ VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
-
-			std::vector<VkSemaphore> semas;
-			semas.reserve(impl->syncpoints.size());
-			std::vector<uint64_t> values;
-			values.reserve(impl->syncpoints.size());
-
-			for (uint64_t i = 0; i < impl->syncpoints.size(); i++) {
-				auto& sp = impl->syncpoints[i];
-				if (sp.executor->type == Executor::Type::eVulkanDeviceQueue) {
-					auto dev_queue = static_cast<QueueExecutor*>(sp.executor);
-					semas.push_back(dev_queue->get_semaphore());
-					values.push_back(sp.visibility);
-				}
-			}
-			swi.pSemaphores = semas.data();
-			swi.pValues = values.data();
-			swi.semaphoreCount = (uint32_t)semas.size();
-			impl->ctx->vkWaitSemaphores(device, &swi, UINT64_MAX);
+			TraceScope _(TraceCategory::eWait, "wait_frame");
+			VUK_DO_OR_RETURN(impl->ctx->wait_for_domains(impl->syncpoints));
 		}
+		return { expected_value };
 	}
 
 	DeviceMultiFrameResource::DeviceMultiFrameResource(VkDevice device, DeviceSuperFrameResource& upstream, uint32_t frame_lifetime) :
@@ -804,7 +787,9 @@ namespace vuk {
 
 		// handle FrameResource
 		auto& f = impl->frames[impl->local_frame];
-		f.wait();
+		if (auto res = f.wait(); !res.holds_value()) {
+			res.error().throw_this(); // recycling a frame whose work can't be waited on is not recoverable
+		}
 		deallocate_frame(f);
 		f.construction_frame = impl->frame_counter.load();
 
@@ -813,7 +798,9 @@ namespace vuk {
 			auto& multi_frame = *it;
 			multi_frame.remaining_lifetime--;
 			if (multi_frame.remaining_lifetime == 0) {
-				multi_frame.wait();
+				if (auto res = multi_frame.wait(); !res.holds_value()) {
+					res.error().throw_this();
+				}
 				deallocate_frame(multi_frame);
 				it = impl->multi_frames.erase(it);
 			} else {
@@ -926,7 +913,9 @@ namespace vuk {
 		for (auto i = 0; i < frames_in_flight; i++) {
 			auto lframe = (impl->frame_counter + i) % frames_in_flight;
 			auto& f = impl->frames[lframe];
-			f.wait();
+			if (auto res = f.wait(); !res.holds_value()) {
+				(void)res.error(); // the frames are freed even if their work can't be waited on
+			}
 			// free the resources manually, because we are destroying the individual FAs
 			f.impl->linear_cpu_gpu.free();
 			f.impl->linear_gpu_cpu.free();
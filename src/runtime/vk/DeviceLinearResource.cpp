@@ -1,4 +1,5 @@
 #include "vuk/runtime/vk/DeviceLinearResource.hpp"
+#include "vuk/Trace.hpp"
 #include "vuk/runtime/vk/BufferAllocator.hpp"
 #include "vuk/runtime/vk/Descriptor.hpp"
 #include "vuk/runtime/vk/Query.hpp"
@@ -6,6 +7,7 @@
 #include "vuk/runtime/vk/VkQueueExecutor.hpp"
 #include "vuk/runtime/vk/VkRuntime.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <mutex>
 #include <numeric>
@@ -286,39 +288,20 @@ namespace vuk {
 		vec.insert(vec.end(), src.begin(), src.end());
 	}
 
-	void DeviceLinearResource::wait() {
-		if (impl->fences.size() > 0) {
-			if (impl->fences.size() > 64) {
-				int i = 0;
-				for (; i < impl->fences.size() - 64; i += 64) {
-					impl->ctx->vkWaitForFences(impl->device, 64, impl->fences.data() + i, true, UINT64_MAX);
-				}
-				impl->ctx->vkWaitForFences(impl->device, (uint32_t)impl->fences.size() - i, impl->fences.data() + i, true, UINT64_MAX);
-			} else {
-				impl->ctx->vkWaitForFences(impl->device, (uint32_t)impl->fences.size(), impl->fences.data(), true, UINT64_MAX);
+	Result<void> DeviceLinearResource::wait() {
+		// at most 64 fences per wait
+		for (size_t i = 0; i < impl->fences.size(); i += 64) {
+			auto count = (uint32_t)std::min<size_t>(impl->fences.size() - i, 64);
+			VkResult result = impl->ctx->vkWaitForFences(impl->device, count, impl->fences.data() + i, true, UINT64_MAX);
+			if (result != VK_SUCCESS) {
+				return { expected_error, VkException{ result } };
 			}
 		}
 		if (impl->syncpoints.size() > 0) {
-			VkSemaphoreWaitInfo swi{ VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
-
-			std::vector<VkSemaphore> semas;
-			semas.reserve(impl->syncpoints.size());
-			std::vector<uint64_t> values;
-			values.reserve(impl->syncpoints.size());
-
-			for (uint64_t i = 0; i < impl->syncpoints.size(); i++) {
-				auto& sp = impl->syncpoints[i];
-				if (sp.executor->type == Executor::Type::eVulkanDeviceQueue) {
-					auto dev_queue = static_cast<QueueExecutor*>(sp.executor);
-					semas.push_back(dev_queue->get_semaphore());
-					values.push_back(sp.visibility);
-				}
-			}
-			swi.pSemaphores = semas.data();
-			swi.pValues = values.data();
-			swi.semaphoreCount = (uint32_t)semas.size();
-			impl->ctx->vkWaitSemaphores(impl->device, &swi, UINT64_MAX);
+			TraceScope _(TraceCategory::eWait, "wait_linear_resource");
+			VUK_DO_OR_RETURN(impl->ctx->wait_for_domains(impl->syncpoints));
 		}
+		return { expected_value };
 	}
 
 	void DeviceLinearResource::free() {
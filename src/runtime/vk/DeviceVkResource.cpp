@@ -244,6 +244,7 @@ namespace vuk {
 	}
 
 	void DeviceVkResource::deallocate_buffers(std::span<const Buffer> src) {
+		ctx->notify_destroyed(src);
 		for (auto& v : src) {
 			if (v) {
 				vmaDestroyBuffer(impl->allocator, v.buffer, static_cast<VmaAllocation>(v.allocation));
@@ -282,6 +283,7 @@ namespace vuk {
 	}
 
 	void DeviceVkResource::deallocate_images(std::span<const Image> src) {
+		ctx->notify_destroyed(src);
 		for (auto& v : src) {
 			if (v) {
 				vmaDestroyImage(impl->allocator, v.image, static_cast<VmaAllocation>(v.allocation));
@@ -482,6 +484,7 @@ namespace vuk {
 	}
 
 	void DeviceVkResource::deallocate_image_views(std::span<const ImageView> src) {
+		ctx->invalidate_framebuffers(src);
 		for (auto& v : src) {
 			if (v.payload != VK_NULL_HANDLE) {
 				ctx->vkDestroyImageView(device, v.payload, nullptr);
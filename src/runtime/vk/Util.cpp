@@ -64,7 +64,7 @@ namespace vuk {
 		}
 		assert(node->acqrel->status != Signal::Status::eDisarmed);
 		if (node->acqrel->status == Signal::Status::eSynchronizable) {
-			allocator.get_context().wait_for_domains(std::span{ &node->acqrel->source, 1 });
+			VUK_DO_OR_RETURN(allocator.get_context().wait_for_domains(std::span{ &node->acqrel->source, 1 }));
 		}
 
 		return { expected_value };
@@ -21,6 +21,7 @@ namespace vuk {
 		PFN_vkGetSemaphoreCounterValue getSemaphoreCounterValue;
 		VkSemaphore submit_sync;
 		uint64_t sync_value = 0;
+		std::atomic<uint64_t> completed_value = 0; // highest value the semaphore was observed to reach
 		VkQueue queue;
 		uint32_t family_index;
 
@@ -136,9 +137,20 @@ namespace vuk {
 		if (res != VK_SUCCESS) {
 			return { expected_error, VkException{ res } };
 		}
+		mark_completed(value);
 		return { expected_value, value };
 	}
 
+	uint64_t QueueExecutor::get_completed_value() const {
+		return impl->completed_value.load(std::memory_order_acquire);
+	}
+
+	void QueueExecutor::mark_completed(uint64_t value) {
+		auto completed = impl->completed_value.load(std::memory_order_relaxed);
+		while (completed < value && !impl->completed_value.compare_exchange_weak(completed, value, std::memory_order_release, std::memory_order_relaxed))
+			;
+	}
+
 	VkSemaphore QueueExecutor::get_semaphore() {
 		return impl->submit_sync;
 	}
@@ -147,7 +159,7 @@ namespace vuk {
 		return impl->family_index;
 	}
 
-	Result<void> QueueExecutor::submit_batch(std::vector<SubmitInfo> batch) {
+	Result<void> QueueExecutor::submit_batch(std::span<SubmitInfo> batch) {
 		std::unique_lock _(*this);
 
 		sis.clear();
@@ -170,11 +182,9 @@ namespace vuk {
 		for (uint64_t i = 0; i < batch.size(); i++) {
 			SubmitInfo& submit_info = batch[i];
 
-			for (auto& fut : submit_info.signals) {
-				fut->status = Signal::Status::eSynchronizable;
-			}
-
-			if (submit_info.command_buffers.size() == 0) {
+			// an entry without command buffers is still submitted if it waits or signals - the signal then orders after everything submitted before it
+			if (submit_info.command_buffers.empty() && submit_info.waits.empty() && submit_info.pres_wait.empty() && submit_info.signals.empty() &&
+			    submit_info.pres_signal.empty()) {
 				continue;
 			}
 
@@ -184,13 +194,13 @@ namespace vuk {
 			}
 
 			uint32_t wait_sema_count = 0;
-			for (auto& w : submit_info.waits) {
+			for (auto& [w, stages] : submit_info.waits) {
 				assert(w->source.executor->type == Executor::Type::eVulkanDeviceQueue);
 				QueueExecutor* executor = static_cast<QueueExecutor*>(w->source.executor);
 				VkSemaphoreSubmitInfoKHR ssi{ VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR };
 				ssi.semaphore = executor->get_semaphore();
 				ssi.value = w->source.visibility;
-				ssi.stageMask = (VkPipelineStageFlagBits2KHR)PipelineStageFlagBits::eAllCommands; // TODO: w now has stage info
+				ssi.stageMask = (VkPipelineStageFlags2KHR)stages.m_mask;
 				wait_semas.emplace_back(ssi);
 				wait_sema_count++;
 			}
@@ -225,7 +235,8 @@ namespace vuk {
 			}
 
 			VkSubmitInfo2KHR& si = sis.emplace_back(VkSubmitInfo2KHR{ VK_STRUCTURE_TYPE_SUBMIT_INFO_2_KHR });
-			VkCommandBufferSubmitInfoKHR* p_cbuf_infos = &cbufsis.back() - (submit_info.command_buffers.size() - 1);
+			VkCommandBufferSubmitInfoKHR* p_cbuf_infos =
+			    submit_info.command_buffers.size() > 0 ? &cbufsis.back() - (submit_info.command_buffers.size() - 1) : nullptr;
 			VkSemaphoreSubmitInfoKHR* p_wait_semas = wait_sema_count > 0 ? &wait_semas.back() - (wait_sema_count - 1) : nullptr;
 			VkSemaphoreSubmitInfoKHR* p_signal_semas = &signal_semas.back() - (signal_sema_count - 1);
 
@@ -236,6 +247,10 @@ namespace vuk {
 			si.pSignalSemaphoreInfos = p_signal_semas;
 			si.signalSemaphoreInfoCount = signal_sema_count;
 		}
+		// every entry was empty
+		if (sis.empty()) {
+			return { expected_value };
+		}
 		VUK_DO_OR_RETURN(submit(std::span{ sis }, VK_NULL_HANDLE));
 
 		return { expected_value };
@@ -4,6 +4,7 @@
 
 #include "vuk/Exception.hpp"
 #include "vuk/RenderGraph.hpp"
+#include "vuk/Trace.hpp"
 #include "vuk/runtime/Cache.hpp"
 #include "vuk/runtime/vk/Allocator.hpp"
 #include "vuk/runtime/vk/AllocatorHelpers.hpp"
@@ -118,6 +119,7 @@ namespace vuk {
 
 		std::mutex named_pipelines_lock;
 		robin_hood::unordered_flat_map<Name, PipelineBaseInfo*> named_pipelines;
+		std::atomic<uint64_t> pipeline_generation = 0;
 
 		std::atomic<uint64_t> query_id_counter = 0;
 		VkPhysicalDeviceProperties physical_device_properties;
@@ -128,6 +130,198 @@ namespace vuk {
 		std::mutex query_lock;
 		robin_hood::unordered_map<Query, uint64_t> timestamp_result_map;
 
+		struct PendingPassTiming {
+			Name pass_name;
+			uint64_t frame;
+			PassTimestamp begin;
+			PassTimestamp end;
+		};
+
+		struct PassTimingPool {
+			VkQueryPool pool;
+			uint32_t size;
+			uint32_t used = 0;
+		};
+
+		// the query pools of the pass profiler in a frame, and the timings written into them
+		struct PassTimingFrame {
+			std::vector<PassTimingPool> pools;
+			std::vector<PendingPassTiming> pending;
+		};
+
+		// frames after which the query pools of a frame are reused, and its unavailable timings discarded
+		static constexpr uint64_t pass_timing_frames = 8;
+		static constexpr uint32_t pass_timing_min_queries = 64;
+
+		std::atomic<bool> pass_profiling = false;
+		std::mutex pass_timing_lock;
+		std::array<PassTimingFrame, pass_timing_frames> pass_timing_frames_in_use;
+		std::vector<PassTiming> resolved_pass_timings;
+
+		Result<void> add_pass_timing_pool(Runtime& ctx, PassTimingFrame& f, uint32_t size) {
+			VkQueryPoolCreateInfo qpci{ .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, .queryType = VK_QUERY_TYPE_TIMESTAMP, .queryCount = size };
+			VkQueryPool pool;
+			if (auto result = ctx.vkCreateQueryPool(device, &qpci, nullptr, &pool); result != VK_SUCCESS) {
+				return { expected_error, AllocateException{ result } };
+			}
+			ctx.vkResetQueryPool(device, pool, 0, size);
+			f.pools.push_back({ pool, size });
+			return { expected_value };
+		}
+
+		void destroy_pass_timing_pools(Runtime& ctx, PassTimingFrame& f) {
+			for (auto& p : f.pools) {
+				ctx.vkDestroyQueryPool(device, p.pool, nullptr);
+			}
+			f.pools.clear();
+		}
+
+		std::optional<uint64_t> get_pass_timestamp(Runtime& ctx, PassTimestamp ts) {
+			uint64_t result[2]; // value, availability
+			auto res = ctx.vkGetQueryPoolResults(
+			    device, ts.pool, ts.index, 1, sizeof(result), result, sizeof(result), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+			if ((res != VK_SUCCESS && res != VK_NOT_READY) || result[1] == 0) {
+				return {};
+			}
+			return result[0];
+		}
+
+		// moves the timings of the frame with both timestamps available to the resolved timings
+		void resolve_pass_timings(Runtime& ctx, PassTimingFrame& f) {
+			auto period = physical_device_properties.limits.timestampPeriod;
+			std::erase_if(f.pending, [&](const PendingPassTiming& pending) {
+				auto begin = get_pass_timestamp(ctx, pending.begin);
+				auto end = get_pass_timestamp(ctx, pending.end);
+				if (!begin || !end) {
+					return false;
+				}
+				// timestamps are monotonic within a queue, but clamp in case of an unordered pair
+				auto ticks = *end > *begin ? *end - *begin : 0;
+				resolved_pass_timings.push_back({ pending.pass_name, pending.frame, (double)period * ticks * 1e-9 });
+				return true;
+			});
+		}
+
+		// the new frame takes over the pools of the frame pass_timing_frames earlier, merged into one pool sized to all of its timestamps
+		void recycle_pass_timings(Runtime& ctx, uint64_t frame) {
+			std::scoped_lock _(pass_timing_lock);
+			auto& f = pass_timing_frames_in_use[frame % pass_timing_frames];
+			resolve_pass_timings(ctx, f);
+			f.pending.clear();
+			if (f.pools.size() == 1) {
+				ctx.vkResetQueryPool(device, f.pools[0].pool, 0, f.pools[0].used);
+				f.pools[0].used = 0;
+			} else if (f.pools.size() > 1) {
+				uint32_t used = 0;
+				for (auto& p : f.pools) {
+					used += p.used;
+				}
+				destroy_pass_timing_pools(ctx, f);
+				if (auto result = add_pass_timing_pool(ctx, f, used); !result.holds_value()) {
+					(void)result.error(); // allocated again when a timestamp is written
+				}
+			}
+		}
+
+		// render passes and framebuffers by their attachments, see acquire_render_pass_framebuffer
+		// the fields an entry is looked up by, held by value - the pointers of the Vulkan create infos point into the caller's vectors
+		struct FramebufferKey {
+			VkRenderPassCreateFlags render_pass_flags;
+			std::vector<VkAttachmentDescription> attachments;
+			std::vector<std::pair<VkSubpassDescriptionFlags, VkPipelineBindPoint>> subpasses;
+			std::vector<VkSubpassDependency> subpass_dependencies;
+			std::vector<VkAttachmentReference> color_refs;
+			std::vector<VkAttachmentReference> resolve_refs;
+			std::optional<VkAttachmentReference> ds_ref;
+			VkFramebufferCreateFlags framebuffer_flags;
+			std::vector<ImageView> image_views;
+			uint32_t width;
+			uint32_t height;
+			uint32_t layers;
+			Samples sample_count;
+
+			FramebufferKey(const RenderPassCreateInfo& rpci, const FramebufferCreateInfo& fbci) :
+			    render_pass_flags(rpci.flags),
+			    attachments(rpci.attachments),
+			    subpass_dependencies(rpci.subpass_dependencies),
+			    color_refs(rpci.color_refs),
+			    resolve_refs(rpci.resolve_refs),
+			    ds_ref(rpci.ds_ref),
+			    framebuffer_flags(fbci.flags),
+			    image_views(fbci.attachments),
+			    width(fbci.width),
+			    height(fbci.height),
+			    layers(fbci.layers),
+			    sample_count(fbci.sample_count) {
+				for (auto& sd : rpci.subpass_descriptions) {
+					subpasses.emplace_back(sd.flags, sd.pipelineBindPoint);
+				}
+			}
+
+			bool matches(const RenderPassCreateInfo& rpci, const FramebufferCreateInfo& fbci) const noexcept {
+				auto same_subpass = [](auto& subpass, const SubpassDescription& sd) {
+					return subpass == std::pair{ sd.flags, sd.pipelineBindPoint };
+				};
+				return std::tie(render_pass_flags, attachments, subpass_dependencies, color_refs, resolve_refs, ds_ref) ==
+				           std::tie(rpci.flags, rpci.attachments, rpci.subpass_dependencies, rpci.color_refs, rpci.resolve_refs, rpci.ds_ref) &&
+				       std::equal(subpasses.begin(), subpasses.end(), rpci.subpass_descriptions.begin(), rpci.subpass_descriptions.end(), same_subpass) &&
+				       std::tie(framebuffer_flags, image_views, width, height, layers, sample_count) ==
+				           std::tie(fbci.flags, fbci.attachments, fbci.width, fbci.height, fbci.layers, fbci.sample_count);
+			}
+		};
+
+		struct FramebufferCacheEntry {
+			size_t hash;
+			FramebufferKey key;
+			VkRenderPass render_pass = VK_NULL_HANDLE;
+			VkFramebuffer framebuffer = VK_NULL_HANDLE;
+			uint64_t last_use;
+		};
+
+		// frames after which unused render passes and framebuffers are destroyed
+		static constexpr uint64_t framebuffer_cache_max_unused_frames = 16;
+
+		std::mutex framebuffer_cache_lock;
+		robin_hood::unordered_flat_map<size_t, std::vector<std::unique_ptr<FramebufferCacheEntry>>> framebuffer_cache; // by hash of the attachments
+		robin_hood::unordered_flat_map<size_t, std::vector<FramebufferCacheEntry*>> framebuffer_cache_views;            // by image view id
+
+		std::mutex destruction_listeners_lock;
+		std::vector<DestructionListener*> destruction_listeners;
+
+		void destroy_framebuffer_entry(Runtime& ctx, FramebufferCacheEntry* entry) {
+			for (auto& iv : entry->key.image_views) {
+				auto it = framebuffer_cache_views.find(iv.id);
+				if (it != framebuffer_cache_views.end()) {
+					std::erase(it->second, entry);
+					if (it->second.empty()) {
+						framebuffer_cache_views.erase(it);
+					}
+				}
+			}
+			ctx.vkDestroyFramebuffer(ctx.device, entry->framebuffer, nullptr);
+			ctx.vkDestroyRenderPass(ctx.device, entry->render_pass, nullptr);
+			auto bucket = framebuffer_cache.find(entry->hash);
+			std::erase_if(bucket->second, [=](auto& e) { return e.get() == entry; });
+			if (bucket->second.empty()) {
+				framebuffer_cache.erase(bucket);
+			}
+		}
+
+		void collect_framebuffers(Runtime& ctx, uint64_t absolute_frame) {
+			std::lock_guard _(framebuffer_cache_lock);
+			std::vector<FramebufferCacheEntry*> unused;
+			for (auto& [hash, bucket] : framebuffer_cache) {
+				for (auto& entry : bucket) {
+					if (absolute_frame - entry->last_use > framebuffer_cache_max_unused_frames) {
+						unused.push_back(entry.get());
+					}
+				}
+			}
+			for (auto entry : unused) {
+				destroy_framebuffer_entry(ctx, entry);
+			}
+		}
+
 		void collect(uint64_t absolute_frame) {
 			// collect rarer resources
 			static constexpr uint32_t cache_collection_frequency = 16;
@@ -537,6 +731,7 @@ namespace vuk {
 		auto pbi = &impl->pipelinebase_cache.acquire(std::move(ci));
 		std::lock_guard _(impl->named_pipelines_lock);
 		impl->named_pipelines.insert_or_assign(name, pbi);
+		impl->pipeline_generation++;
 	}
 
 	PipelineBaseInfo* Runtime::get_named_pipeline(Name name) {
@@ -549,6 +744,10 @@ namespace vuk {
 		return impl->named_pipelines.contains(name);
 	}
 
+	uint64_t Runtime::get_pipeline_generation() const {
+		return impl->pipeline_generation;
+	}
+
 	PipelineBaseInfo* Runtime::get_pipeline(const PipelineBaseCreateInfo& pbci) {
 		return &impl->pipelinebase_cache.acquire(pbci);
 	}
@@ -608,6 +807,10 @@ namespace vuk {
 
 			this->vkDestroyPipelineCache(device, vk_pipeline_cache, nullptr);
 
+			impl->collect_framebuffers(*this, UINT64_MAX);
+			for (auto& f : impl->pass_timing_frames_in_use) {
+				impl->destroy_pass_timing_pools(*this, f);
+			}
 			delete impl;
 		}
 	}
@@ -618,10 +821,13 @@ namespace vuk {
 
 	void Runtime::next_frame() {
 		impl->frame_counter++;
+		impl->recycle_pass_timings(*this, impl->frame_counter);
 		collect(impl->frame_counter);
+		impl->collect_framebuffers(*this, impl->frame_counter);
 	}
 
 	Result<void> Runtime::wait_idle() {
+		TraceScope _(TraceCategory::eWait, "wait_idle");
 		std::unique_lock<std::recursive_mutex> graphics_lock;
 		for (auto& exe : impl->executors) {
 			exe->lock();
@@ -641,6 +847,91 @@ namespace vuk {
 		impl->collect(frame);
 	}
 
+	Result<RenderPassFramebuffer, AllocateException> Runtime::acquire_render_pass_framebuffer(const RenderPassCreateInfo& rpci, const FramebufferCreateInfo& fbci) {
+		size_t hash = 0;
+		hash_combine(hash, rpci, fbci);
+
+		std::lock_guard _(impl->framebuffer_cache_lock);
+		auto& bucket = impl->framebuffer_cache[hash];
+		for (auto& entry : bucket) {
+			// the render pass of the framebuffer is the one cached with it
+			if (entry->key.matches(rpci, fbci)) {
+				entry->last_use = impl->frame_counter;
+				return { expected_value, RenderPassFramebuffer{ entry->render_pass, entry->framebuffer, true } };
+			}
+		}
+
+		auto entry = std::unique_ptr<ContextImpl::FramebufferCacheEntry>(
+		    new ContextImpl::FramebufferCacheEntry{ .hash = hash, .key = { rpci, fbci }, .last_use = impl->frame_counter });
+		VkResult result = this->vkCreateRenderPass(device, &rpci, nullptr, &entry->render_pass);
+		if (result == VK_SUCCESS) {
+			VkFramebufferCreateInfo vkfbci = fbci;
+			vkfbci.renderPass = entry->render_pass;
+			result = this->vkCreateFramebuffer(device, &vkfbci, nullptr, &entry->framebuffer);
+			if (result != VK_SUCCESS) {
+				this->vkDestroyRenderPass(device, entry->render_pass, nullptr);
+			}
+		}
+		if (result != VK_SUCCESS) {
+			if (bucket.empty()) {
+				impl->framebuffer_cache.erase(hash);
+			}
+			return { expected_error, AllocateException{ result } };
+		}
+
+		for (auto& iv : fbci.attachments) {
+			auto& entries = impl->framebuffer_cache_views[iv.id];
+			if (std::find(entries.begin(), entries.end(), entry.get()) == entries.end()) {
+				entries.push_back(entry.get());
+			}
+		}
+		RenderPassFramebuffer rpfb{ entry->render_pass, entry->framebuffer, false };
+		bucket.push_back(std::move(entry));
+		return { expected_value, rpfb };
+	}
+
+	void Runtime::invalidate_framebuffers(std::span<const ImageView> image_views) {
+		std::lock_guard _(impl->framebuffer_cache_lock);
+		if (impl->framebuffer_cache_views.empty()) {
+			return;
+		}
+		for (auto& iv : image_views) {
+			auto it = impl->framebuffer_cache_views.find(iv.id);
+			if (it == impl->framebuffer_cache_views.end()) {
+				continue;
+			}
+			auto entries = std::move(it->second);
+			impl->framebuffer_cache_views.erase(it);
+			for (auto entry : entries) {
+				impl->destroy_framebuffer_entry(*this, entry);
+			}
+		}
+	}
+
+	void Runtime::add_destruction_listener(DestructionListener* listener) {
+		std::lock_guard _(impl->destruction_listeners_lock);
+		impl->destruction_listeners.push_back(listener);
+	}
+
+	void Runtime::remove_destruction_listener(DestructionListener* listener) {
+		std::lock_guard _(impl->destruction_listeners_lock);
+		std::erase(impl->destruction_listeners, listener);
+	}
+
+	void Runtime::notify_destroyed(std::span<const Buffer> buffers) {
+		std::lock_guard _(impl->destruction_listeners_lock);
+		for (auto listener : impl->destruction_listeners) {
+			listener->on_destroy(buffers);
+		}
+	}
+
+	void Runtime::notify_destroyed(std::span<const Image> images) {
+		std::lock_guard _(impl->destruction_listeners_lock);
+		for (auto listener : impl->destruction_listeners) {
+			listener->on_destroy(images);
+		}
+	}
+
 	Unique<PersistentDescriptorSet>
 	Runtime::create_persistent_descriptorset(Allocator& allocator, DescriptorSetLayoutCreateInfo dslci, unsigned num_descriptors) {
 		dslci.dslci.bindingCount = (uint32_t)dslci.bindings.size();
@@ -743,40 +1034,95 @@ namespace vuk {
 		return { expected_value };
 	}
 
-	Result<void> Runtime::wait_for_domains(std::span<SyncPoint> queue_waits) {
-		std::array<uint32_t, 3> domain_to_sema_index = { ~0u, ~0u, ~0u };
-		std::array<VkSemaphore, 3> queue_timeline_semaphores;
-		std::array<uint64_t, 3> values = {};
+	void Runtime::set_pass_profiling(bool enable) {
+		impl->pass_profiling.store(enable, std::memory_order_relaxed);
+	}
+
+	bool Runtime::is_pass_profiling_enabled() const {
+		return impl->pass_profiling.load(std::memory_order_relaxed);
+	}
+
+	Result<PassTimestamp> Runtime::allocate_pass_timestamp() {
+		std::scoped_lock _(impl->pass_timing_lock);
+		auto& f = impl->pass_timing_frames_in_use[impl->frame_counter % ContextImpl::pass_timing_frames];
+		if (f.pools.empty() || f.pools.back().used == f.pools.back().size) {
+			// the frame outgrew its pools - the new pool doubles its queries
+			uint32_t size = 0;
+			for (auto& p : f.pools) {
+				size += p.size;
+			}
+			size = std::max(size, ContextImpl::pass_timing_min_queries);
+			VUK_DO_OR_RETURN(impl->add_pass_timing_pool(*this, f, size));
+		}
+		auto& pool = f.pools.back();
+		return { expected_value, PassTimestamp{ pool.pool, pool.used++ } };
+	}
+
+	void Runtime::register_pass_timing(Name pass_name, PassTimestamp begin, PassTimestamp end) {
+		std::scoped_lock _(impl->pass_timing_lock);
+		uint64_t frame = impl->frame_counter;
+		impl->pass_timing_frames_in_use[frame % ContextImpl::pass_timing_frames].pending.push_back({ pass_name, frame, begin, end });
+	}
 
-		uint32_t count = 0;
-		for (auto& [executor, v] : queue_waits) {
-			assert(executor->type == Executor::Type::eVulkanDeviceQueue);
+	std::vector<PassTiming> Runtime::retrieve_pass_timings() {
+		std::scoped_lock _(impl->pass_timing_lock);
+		for (auto& f : impl->pass_timing_frames_in_use) {
+			impl->resolve_pass_timings(*this, f);
+		}
+		return std::exchange(impl->resolved_pass_timings, {});
+	}
+
+	Result<void> Runtime::wait_for_domains(std::span<SyncPoint> sync_points) {
+		// a single wait for the highest value of each timeline, skipping the values already observed
+		std::vector<std::pair<QueueExecutor*, uint64_t>> timelines;
+		for (auto& [executor, value] : sync_points) {
+			// only queue timelines can be waited on - host values are complete once visible and never reach here
+			if (executor->type != Executor::Type::eVulkanDeviceQueue) {
+				return { expected_error, RenderGraphException{ "wait_for_domains: only sync points of device queues can be waited on." } };
+			}
 			auto vkq = static_cast<QueueExecutor*>(executor);
-			auto idx = vkq->get_queue_family_index();
-			auto& mapping = domain_to_sema_index[idx];
-			if (mapping == -1) {
-				mapping = count++;
+			if (vkq->get_completed_value() >= value) {
+				continue;
 			}
-			queue_timeline_semaphores[mapping] = vkq->get_semaphore();
-			values[mapping] = values[mapping] > v ? values[mapping] : v;
+			auto it = std::find_if(timelines.begin(), timelines.end(), [=](auto& tl) { return tl.first == vkq; });
+			if (it == timelines.end()) {
+				timelines.emplace_back(vkq, value);
+			} else {
+				it->second = std::max(it->second, value);
+			}
+		}
+		if (timelines.empty()) {
+			return { expected_value };
 		}
 
+		std::vector<VkSemaphore> semaphores;
+		std::vector<uint64_t> values;
+		for (auto& [vkq, value] : timelines) {
+			semaphores.push_back(vkq->get_semaphore());
+			values.push_back(value);
+		}
 		VkSemaphoreWaitInfo swi{ .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
-		swi.pSemaphores = queue_timeline_semaphores.data();
+		swi.pSemaphores = semaphores.data();
 		swi.pValues = values.data();
-		swi.semaphoreCount = count;
+		swi.semaphoreCount = (uint32_t)semaphores.size();
+		TraceScope _(TraceCategory::eWait, "wait_for_domains");
 		VkResult result = this->vkWaitSemaphores(device, &swi, UINT64_MAX);
 		if (result != VK_SUCCESS) {
 			return { expected_error, VkException{ result } };
 		}
+		for (auto& [vkq, value] : timelines) {
+			vkq->mark_completed(value);
+		}
 		return { expected_value };
 	}
 
 	Result<bool> Runtime::sync_point_ready(SyncPoint sp) {
-		auto& [executor, v] = sp; 
+		auto& [executor, v] = sp;
 		assert(executor->type == Executor::Type::eVulkanDeviceQueue);
 		auto vkq = static_cast<QueueExecutor*>(executor);
-		auto idx = vkq->get_queue_family_index();
+		if (vkq->get_completed_value() >= v) {
+			return { expected_value, true };
+		}
 		auto val = vkq->get_sync_value();
 		if (!val) {
 			return val;
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "vuk/runtime/ThisThreadExecutor.hpp"
+#include "vuk/runtime/vk/Allocator.hpp"
+#include "vuk/runtime/vk/DeviceFrameResource.hpp"
+#include "vuk/runtime/vk/VkRuntime.hpp"
+
+#include <VkBootstrap.h>
+#include <atomic>
+#include <cstdio>
+#include <optional>
+
+namespace vuk {
+	// device backed tests run on whatever Vulkan 1.3 implementation is available (lavapipe on CI)
+	// without one, prepare() fails and the tests skip themselves
+	struct TestContext {
+		bool prepared = false;
+		bool has_device = false;
+
+		vkb::Instance vkbinstance;
+		vkb::Device vkbdevice;
+		VkQueue graphics_queue = VK_NULL_HANDLE;
+		VkQueue transfer_queue = VK_NULL_HANDLE;
+		std::optional<Runtime> runtime;
+		std::optional<DeviceSuperFrameResource> superframe_resource;
+		std::optional<Allocator> allocator;
+		std::atomic<size_t> validation_errors = 0; // reported by the validation layers, when they are available
+
+		static VKAPI_ATTR VkBool32 VKAPI_CALL count_validation_errors(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+		                                                              VkDebugUtilsMessageTypeFlagsEXT,
+		                                                              const VkDebugUtilsMessengerCallbackDataEXT* data,
+		                                                              void* user_data) {
+			if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) {
+				static_cast<TestContext*>(user_data)->validation_errors++;
+				fprintf(stderr, "%s\n", data->pMessage);
+			}
+			return VK_FALSE;
+		}
+
+		bool prepare() {
+			if (prepared) {
+				return has_device;
+			}
+			prepared = true;
+
+			vkb::InstanceBuilder builder;
+			builder.request_validation_layers().set_headless().set_app_name("vuk_tests").require_api_version(1, 3, 0);
+			builder.set_debug_callback(&count_validation_errors).set_debug_callback_user_data_pointer(this);
+			// hazards between submissions are only reported by synchronization validation
+			auto system_info = vkb::SystemInfo::get_system_info();
+			if (system_info && system_info->validation_layers_available) {
+				builder.add_validation_feature_enable(VK_VALIDATION_FEATURE_ENABLE_SYNCHRONIZATION_VALIDATION_EXT);
+			}
+			auto inst_ret = builder.build();
+			if (!inst_ret) {
+				return false;
+			}
+			vkbinstance = inst_ret.value();
+
+			VkPhysicalDeviceVulkan12Features vk12features{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+			vk12features.timelineSemaphore = true;
+			vk12features.hostQueryReset = true;
+			vk12features.bufferDeviceAddress = true;
+			VkPhysicalDeviceVulkan13Features vk13features{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+			vk13features.synchronization2 = true;
+			vkb::PhysicalDeviceSelector selector{ vkbinstance };
+			auto phys_ret = selector.set_minimum_version(1, 3).set_required_features_12(vk12features).set_required_features_13(vk13features).select();
+			if (!phys_ret) {
+				return false;
+			}
+			vkb::DeviceBuilder device_builder{ phys_ret.value() };
+			auto dev_ret = device_builder.build();
+			if (!dev_ret) {
+				return false;
+			}
+			vkbdevice = dev_ret.value();
+
+			graphics_queue = vkbdevice.get_queue(vkb::QueueType::graphics).value();
+			auto graphics_queue_family_index = vkbdevice.get_queue_index(vkb::QueueType::graphics).value();
+			auto transfer_queue_ret = vkbdevice.get_dedicated_queue(vkb::QueueType::transfer);
+
+			FunctionPointers fps;
+			fps.vkGetInstanceProcAddr = vkbinstance.fp_vkGetInstanceProcAddr;
+			if (!fps.load_pfns(vkbinstance.instance, vkbdevice.device, true).holds_value()) {
+				return false;
+			}
+
+			std::vector<std::unique_ptr<Executor>> executors;
+			executors.push_back(create_vkqueue_executor(fps, vkbdevice.device, graphics_queue, graphics_queue_family_index, DomainFlagBits::eGraphicsQueue));
+			if (transfer_queue_ret) {
+				transfer_queue = transfer_queue_ret.value();
+				auto transfer_queue_family_index = vkbdevice.get_dedicated_queue_index(vkb::QueueType::transfer).value();
+				executors.push_back(create_vkqueue_executor(fps, vkbdevice.device, transfer_queue, transfer_queue_family_index, DomainFlagBits::eTransferQueue));
+			}
+			executors.push_back(std::make_unique<ThisThreadExecutor>());
+
+			runtime.emplace(RuntimeCreateParameters{ vkbinstance.instance, vkbdevice.device, vkbdevice.physical_device, std::move(executors), fps });
+			superframe_resource.emplace(*runtime, 3);
+			allocator.emplace(*superframe_resource);
+			has_device = true;
+			return true;
+		}
+
+		~TestContext() {
+			if (!has_device) {
+				return;
+			}
+			(void)runtime->wait_idle().holds_value();
+			allocator.reset();
+			superframe_resource.reset();
+			runtime.reset();
+			vkb::destroy_device(vkbdevice);
+			vkb::destroy_instance(vkbinstance);
+		}
+	};
+
+	inline TestContext test_context;
+} // namespace vuk
+
+// skips the rest of a test case when no Vulkan device could be created
+#define VUK_REQUIRE_DEVICE()                                                                                                                                   \
+	if (!vuk::test_context.prepare()) {                                                                                                                          \
+		MESSAGE("no Vulkan 1.3 device available, skipped");                                                                                                       \
+		return;                                                                                                                                                    \
+	}
+
+// fails the test case with the message of the error held by a Result
+#define VUK_REQUIRE_OK(expr)                                                                                                                                   \
+	do {                                                                                                                                                         \
+		auto&& _result = (expr);                                                                                                                                   \
+		if (!_result.holds_value()) {                                                                                                                              \
+			FAIL(_result.error().what());                                                                                                                            \
+		}                                                                                                                                                          \
+	} while (0)
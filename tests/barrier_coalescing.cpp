@@ -0,0 +1,231 @@
+#include "vuk/SyncLowering.hpp"
+
+#include <doctest/doctest.h>
+
+using namespace vuk;
+
+namespace {
+	// the barriers are never recorded, so any distinct values do as handles
+	const VkImage image_a = (VkImage)uintptr_t{ 1 };
+	const VkImage image_b = (VkImage)uintptr_t{ 2 };
+	const VkBuffer buffer_a = (VkBuffer)uintptr_t{ 3 };
+	const VkBuffer buffer_b = (VkBuffer)uintptr_t{ 4 };
+
+	constexpr VkPipelineStageFlags2KHR transfer = VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR;
+	constexpr VkPipelineStageFlags2KHR fragment = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR;
+	constexpr VkPipelineStageFlags2KHR compute = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+	constexpr VkAccessFlags2KHR transfer_write = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR;
+	constexpr VkAccessFlags2KHR shader_read = VK_ACCESS_2_SHADER_READ_BIT_KHR;
+	constexpr VkAccessFlags2KHR shader_write = VK_ACCESS_2_SHADER_WRITE_BIT_KHR;
+
+	VkImageMemoryBarrier2KHR image_barrier(VkImage image, uint32_t base_level, uint32_t level_count, uint32_t base_layer = 0, uint32_t layer_count = 1) {
+		return { .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR,
+			       .srcStageMask = transfer,
+			       .srcAccessMask = transfer_write,
+			       .dstStageMask = fragment,
+			       .dstAccessMask = shader_read,
+			       .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			       .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			       .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			       .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			       .image = image,
+			       .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, base_level, level_count, base_layer, layer_count } };
+	}
+
+	VkBufferMemoryBarrier2KHR buffer_barrier(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size) {
+		return { .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR,
+			       .srcStageMask = transfer,
+			       .srcAccessMask = transfer_write,
+			       .dstStageMask = fragment,
+			       .dstAccessMask = shader_read,
+			       .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			       .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			       .buffer = buffer,
+			       .offset = offset,
+			       .size = size };
+	}
+
+	VkMemoryBarrier2KHR
+	memory_barrier(VkPipelineStageFlags2KHR src_stages, VkAccessFlags2KHR src_access, VkPipelineStageFlags2KHR dst_stages, VkAccessFlags2KHR dst_access) {
+		return { .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR,
+			       .srcStageMask = src_stages,
+			       .srcAccessMask = src_access,
+			       .dstStageMask = dst_stages,
+			       .dstAccessMask = dst_access };
+	}
+
+	struct Batch {
+		std::vector<VkMemoryBarrier2KHR> mem_bars;
+		std::vector<VkBufferMemoryBarrier2KHR> buf_bars;
+		std::vector<VkImageMemoryBarrier2KHR> im_bars;
+
+		CoalescedBarriers coalesce() {
+			CoalescedBarriers result;
+			coalesce_barriers(mem_bars, buf_bars, im_bars, result);
+			return result;
+		}
+	};
+} // namespace
+
+TEST_CASE("barriers over adjacent mips of an image merge into one") {
+	Batch batch;
+	for (uint32_t level = 0; level < 4; level++) {
+		batch.im_bars.push_back(image_barrier(image_a, level, 1));
+	}
+	auto result = batch.coalesce();
+
+	CHECK(result.merged == 3);
+	CHECK(result.dropped == 0);
+	REQUIRE(batch.im_bars.size() == 1);
+	CHECK(batch.im_bars[0].subresourceRange.baseMipLevel == 0);
+	CHECK(batch.im_bars[0].subresourceRange.levelCount == 4);
+	CHECK(batch.im_bars[0].subresourceRange.layerCount == 1);
+}
+
+TEST_CASE("barriers over adjacent layers merge regardless of their order in the batch") {
+	Batch batch;
+	batch.im_bars = { image_barrier(image_a, 0, 1, 2, 1), image_barrier(image_a, 0, 1, 0, 1), image_barrier(image_a, 0, 1, 1, 1) };
+	auto result = batch.coalesce();
+
+	CHECK(result.merged == 2);
+	REQUIRE(batch.im_bars.size() == 1);
+	CHECK(batch.im_bars[0].subresourceRange.baseArrayLayer == 0);
+	CHECK(batch.im_bars[0].subresourceRange.layerCount == 3);
+}
+
+TEST_CASE("image barriers that cannot be expressed as one are kept") {
+	Batch batch;
+	SUBCASE("a gap between the mips") {
+		batch.im_bars = { image_barrier(image_a, 0, 1), image_barrier(image_a, 2, 1) };
+	}
+	SUBCASE("different images") {
+		batch.im_bars = { image_barrier(image_a, 0, 1), image_barrier(image_b, 1, 1) };
+	}
+	SUBCASE("different layout transitions") {
+		batch.im_bars = { image_barrier(image_a, 0, 1), image_barrier(image_a, 1, 1) };
+		batch.im_bars[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	}
+	SUBCASE("adjacent mips with different scopes") {
+		batch.im_bars = { image_barrier(image_a, 0, 1), image_barrier(image_a, 1, 1) };
+		batch.im_bars[1].dstStageMask = compute;
+	}
+	SUBCASE("a queue family ownership transfer") {
+		batch.im_bars = { image_barrier(image_a, 0, 1), image_barrier(image_a, 1, 1) };
+		batch.im_bars[1].srcQueueFamilyIndex = 0;
+		batch.im_bars[1].dstQueueFamilyIndex = 1;
+	}
+	auto result = batch.coalesce();
+
+	CHECK(result.merged == 0);
+	CHECK(result.dropped == 0);
+	CHECK(batch.im_bars.size() == 2);
+}
+
+TEST_CASE("image barriers over the same range take the union of their scopes") {
+	Batch batch;
+	batch.im_bars = { image_barrier(image_a, 0, 2), image_barrier(image_a, 0, 2) };
+	batch.im_bars[1].dstStageMask = compute;
+	batch.im_bars[1].dstAccessMask = shader_write;
+	auto result = batch.coalesce();
+
+	CHECK(result.merged == 1);
+	REQUIRE(batch.im_bars.size() == 1);
+	CHECK(batch.im_bars[0].dstStageMask == (fragment | compute));
+	CHECK(batch.im_bars[0].dstAccessMask == (shader_read | shader_write));
+}
+
+TEST_CASE("an image barrier inside the range of a barrier with wider scopes is dropped") {
+	Batch batch;
+	// the narrow barrier comes first, it is replaced by the wider one
+	batch.im_bars = { image_barrier(image_a, 1, 1), image_barrier(image_a, 0, 4) };
+	batch.im_bars[1].dstStageMask |= compute;
+	auto result = batch.coalesce();
+
+	CHECK(result.dropped == 1);
+	CHECK(result.merged == 0);
+	REQUIRE(batch.im_bars.size() == 1);
+	CHECK(batch.im_bars[0].subresourceRange.baseMipLevel == 0);
+	CHECK(batch.im_bars[0].subresourceRange.levelCount == 4);
+	CHECK(batch.im_bars[0].dstStageMask == (fragment | compute));
+}
+
+TEST_CASE("a memory barrier implied by another is dropped") {
+	Batch batch;
+	batch.mem_bars = { memory_barrier(transfer, transfer_write, fragment, shader_read),
+		                 memory_barrier(transfer | compute, transfer_write | shader_write, fragment | compute, shader_read) };
+	auto result = batch.coalesce();
+
+	CHECK(result.dropped == 1);
+	CHECK(result.merged == 0);
+	REQUIRE(batch.mem_bars.size() == 1);
+	CHECK(batch.mem_bars[0].srcStageMask == (transfer | compute));
+}
+
+TEST_CASE("memory barriers sharing a scope are unioned") {
+	Batch batch;
+	batch.mem_bars = { memory_barrier(transfer, transfer_write, fragment, shader_read), memory_barrier(transfer, transfer_write, compute, shader_write) };
+	auto result = batch.coalesce();
+
+	CHECK(result.merged == 1);
+	REQUIRE(batch.mem_bars.size() == 1);
+	CHECK(batch.mem_bars[0].dstStageMask == (fragment | compute));
+	CHECK(batch.mem_bars[0].dstAccessMask == (shader_read | shader_write));
+
+	SUBCASE("unless neither scope is shared") {
+		batch.mem_bars = { memory_barrier(transfer, transfer_write, fragment, shader_read), memory_barrier(compute, shader_write, transfer, transfer_write) };
+		auto kept = batch.coalesce();
+		CHECK(kept.merged == 0);
+		CHECK(kept.dropped == 0);
+		CHECK(batch.mem_bars.size() == 2);
+	}
+}
+
+TEST_CASE("resource barriers implied by a memory barrier are dropped, unless they transition or transfer ownership") {
+	Batch batch;
+	batch.mem_bars = { memory_barrier(transfer, transfer_write, fragment | compute, shader_read) };
+	batch.buf_bars = { buffer_barrier(buffer_a, 0, 256) };
+	batch.im_bars = { image_barrier(image_a, 0, 1), image_barrier(image_b, 0, 1) };
+	batch.im_bars[1].oldLayout = batch.im_bars[1].newLayout;
+	auto result = batch.coalesce();
+
+	CHECK(result.dropped == 2);
+	CHECK(batch.mem_bars.size() == 1);
+	CHECK(batch.buf_bars.empty());
+	// the layout transition still needs its image barrier
+	REQUIRE(batch.im_bars.size() == 1);
+	CHECK(batch.im_bars[0].image == image_a);
+
+	SUBCASE("ownership transfers are kept") {
+		batch.buf_bars = { buffer_barrier(buffer_a, 0, 256) };
+		batch.buf_bars[0].srcQueueFamilyIndex = 0;
+		batch.buf_bars[0].dstQueueFamilyIndex = 1;
+		auto kept = batch.coalesce();
+		CHECK(kept.dropped == 0);
+		CHECK(batch.buf_bars.size() == 1);
+	}
+}
+
+TEST_CASE("buffer barriers over adjacent ranges merge") {
+	Batch batch;
+	batch.buf_bars = { buffer_barrier(buffer_a, 256, 256), buffer_barrier(buffer_a, 0, 256), buffer_barrier(buffer_b, 512, 256) };
+	auto result = batch.coalesce();
+
+	CHECK(result.merged == 1);
+	CHECK(result.dropped == 0);
+	REQUIRE(batch.buf_bars.size() == 2);
+	CHECK(batch.buf_bars[0].buffer == buffer_a);
+	CHECK(batch.buf_bars[0].offset == 0);
+	CHECK(batch.buf_bars[0].size == 512);
+	CHECK(batch.buf_bars[1].buffer == buffer_b);
+}
+
+TEST_CASE("a buffer barrier inside another with the same scopes is dropped") {
+	Batch batch;
+	batch.buf_bars = { buffer_barrier(buffer_a, 0, 1024), buffer_barrier(buffer_a, 256, 256) };
+	auto result = batch.coalesce();
+
+	CHECK(result.dropped == 1);
+	REQUIRE(batch.buf_bars.size() == 1);
+	CHECK(batch.buf_bars[0].offset == 0);
+	CHECK(batch.buf_bars[0].size == 1024);
+}
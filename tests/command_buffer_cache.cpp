@@ -0,0 +1,63 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+
+#include <doctest/doctest.h>
+
+using namespace vuk;
+
+namespace {
+	SchedulingInfo reused_on_any_queue() {
+		SchedulingInfo info(DomainFlagBits::eAny);
+		info.reuse_commands = true;
+		return info;
+	}
+
+	auto fill = make_pass(
+	    "fill", [](CommandBuffer& cbuf, VUK_BA(Access::eTransferWrite) dst) {
+		    cbuf.fill_buffer(dst, 0);
+		    return dst;
+	    },
+	    reused_on_any_queue());
+
+	ExecuteStats execute_fill(Compiler& compiler, const Buffer& buffer) {
+		auto res = fill(acquire_buf("buf", buffer, Access::eNone));
+		VUK_REQUIRE_OK(res.wait(*test_context.allocator, compiler));
+		return compiler.get_execute_stats();
+	}
+} // namespace
+
+TEST_CASE("reused commands are recorded again when the pass arguments change") {
+	VUK_REQUIRE_DEVICE();
+
+	// destroyed immediately on deallocation, so the cache hears of it before the next execute
+	Allocator direct(test_context.runtime->get_vk_resource());
+	auto buffer = allocate_buffer(direct, BufferCreateInfo{ .mem_usage = MemoryUsage::eGPUonly, .size = 1024 });
+	REQUIRE(buffer.holds_value());
+
+	Compiler compiler;
+	auto first = execute_fill(compiler, **buffer);
+	CHECK(first.recorded_command_buffers == 1);
+	CHECK(first.replayed_command_buffers == 0);
+	auto second = execute_fill(compiler, **buffer);
+	CHECK(second.recorded_command_buffers == 0);
+	CHECK(second.replayed_command_buffers == 1);
+
+	SUBCASE("a different range of the same buffer") {
+		Buffer half = **buffer;
+		half.offset += 512;
+		half.size = 512;
+		auto stats = execute_fill(compiler, half);
+		CHECK(stats.recorded_command_buffers == 1);
+		CHECK(stats.replayed_command_buffers == 0);
+	}
+
+	SUBCASE("a destroyed buffer") {
+		buffer->reset();
+		// may get the handle of the destroyed buffer back
+		auto other = allocate_buffer(direct, BufferCreateInfo{ .mem_usage = MemoryUsage::eGPUonly, .size = 1024 });
+		REQUIRE(other.holds_value());
+		auto stats = execute_fill(compiler, **other);
+		CHECK(stats.recorded_command_buffers == 1);
+		CHECK(stats.replayed_command_buffers == 0);
+	}
+}
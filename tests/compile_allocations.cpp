@@ -0,0 +1,114 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <new>
+
+// counts every allocation made through the global operator new on the thread that enables counting
+namespace {
+	thread_local bool counting = false;
+	thread_local size_t allocations = 0;
+
+	void* allocate(std::size_t size) {
+		if (counting) {
+			allocations++;
+		}
+		if (auto p = std::malloc(size > 0 ? size : 1)) {
+			return p;
+		}
+		throw std::bad_alloc{};
+	}
+
+	void* allocate_aligned(std::size_t size, std::align_val_t alignment) {
+		if (counting) {
+			allocations++;
+		}
+		auto align = static_cast<std::size_t>(alignment);
+		size = (std::max<std::size_t>(size, 1) + align - 1) & ~(align - 1);
+#ifdef _MSC_VER
+		auto p = _aligned_malloc(size, align);
+#else
+		auto p = std::aligned_alloc(align, size);
+#endif
+		if (p) {
+			return p;
+		}
+		throw std::bad_alloc{};
+	}
+
+	void deallocate_aligned(void* p) noexcept {
+#ifdef _MSC_VER
+		_aligned_free(p);
+#else
+		std::free(p);
+#endif
+	}
+} // namespace
+
+void* operator new(std::size_t size) {
+	return allocate(size);
+}
+void* operator new[](std::size_t size) {
+	return allocate(size);
+}
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	return allocate_aligned(size, alignment);
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+	return allocate_aligned(size, alignment);
+}
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+void operator delete[](void* p) noexcept {
+	std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+void operator delete[](void* p, std::size_t) noexcept {
+	std::free(p);
+}
+void operator delete(void* p, std::align_val_t) noexcept {
+	deallocate_aligned(p);
+}
+void operator delete[](void* p, std::align_val_t) noexcept {
+	deallocate_aligned(p);
+}
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+	deallocate_aligned(p);
+}
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+	deallocate_aligned(p);
+}
+
+using namespace vuk;
+
+namespace {
+	auto write_buf = make_pass("write", [](CommandBuffer&, VUK_BA(Access::eTransferWrite) dst) { return dst; });
+	auto read_buf = make_pass("read", [](CommandBuffer&, VUK_BA(Access::eTransferRead) src) { return src; });
+} // namespace
+
+TEST_CASE("compiling the same graph again does not allocate") {
+	std::vector<std::shared_ptr<ExtNode>> heads;
+	for (size_t i = 0; i < 1000; i++) {
+		auto buf = declare_buf("buf", Buffer{ .size = 1024, .memory_usage = MemoryUsage::eGPUonly });
+		heads.push_back(read_buf(write_buf(std::move(buf))).node);
+	}
+
+	Compiler compiler;
+	VUK_REQUIRE_OK(compiler.compile(heads, {}));
+	REQUIRE(compiler.get_compile_stats().validation.count >= 5000);
+
+	allocations = 0;
+	counting = true;
+	auto result = compiler.compile(heads, {});
+	counting = false;
+	auto second_compile_allocations = allocations;
+	VUK_REQUIRE_OK(result);
+
+	CHECK(second_compile_allocations == 0);
+	CHECK(compiler.get_compile_stats().heap_allocations == 0);
+}
@@ -0,0 +1,61 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+
+#include <doctest/doctest.h>
+
+using namespace vuk;
+
+namespace {
+	auto write_buf = make_pass("write", [](CommandBuffer&, VUK_BA(Access::eTransferWrite) dst) { return dst; });
+	auto read_buf = make_pass("read", [](CommandBuffer&, VUK_BA(Access::eTransferRead) src) { return src; });
+} // namespace
+
+TEST_CASE("compile stats of a known graph") {
+	auto buf = declare_buf("a", Buffer{ .size = 1024, .memory_usage = MemoryUsage::eGPUonly });
+	auto res = read_buf(write_buf(std::move(buf)));
+
+	Compiler compiler;
+	std::shared_ptr<ExtNode> heads[] = { res.node };
+	VUK_REQUIRE_OK(compiler.compile(heads, {}));
+	auto& stats = compiler.get_compile_stats();
+
+	// everything was declared in the current module
+	CHECK(stats.module_collection.count == 1);
+	// the two passes and the tail
+	CHECK(stats.queue_inference.count == 3);
+	CHECK(stats.pass_partitioning.count == stats.queue_inference.count);
+	// validation, inference and sync all see the final node set
+	CHECK(stats.validation.count > 0);
+	CHECK(stats.reify_inference.count == stats.validation.count);
+	CHECK(stats.build_sync.count == stats.validation.count);
+	CHECK(stats.build_nodes.count >= stats.validation.count);
+	CHECK(stats.collect_chains.count > 0);
+	// nothing to fold, merge or split on a buffer
+	CHECK(stats.folded_nodes == 0);
+	CHECK(stats.merged_nodes == 0);
+	CHECK(stats.split_reads == 0);
+	CHECK(stats.general_layout_fallbacks == 0);
+
+	CHECK(stats.total() >= stats.build_sync.duration);
+	CHECK(stats.total() >= stats.collect_chains.duration);
+}
+
+TEST_CASE("compile stats are reset between compiles") {
+	Compiler compiler;
+	{
+		auto buf = declare_buf("a", Buffer{ .size = 1024, .memory_usage = MemoryUsage::eGPUonly });
+		auto res = read_buf(write_buf(std::move(buf)));
+		std::shared_ptr<ExtNode> heads[] = { res.node };
+		VUK_REQUIRE_OK(compiler.compile(heads, {}));
+	}
+	auto two_pass_nodes = compiler.get_compile_stats().validation.count;
+
+	auto buf = declare_buf("b", Buffer{ .size = 1024, .memory_usage = MemoryUsage::eGPUonly });
+	auto res = write_buf(std::move(buf));
+	std::shared_ptr<ExtNode> heads[] = { res.node };
+	VUK_REQUIRE_OK(compiler.compile(heads, {}));
+	auto& stats = compiler.get_compile_stats();
+
+	CHECK(stats.queue_inference.count == 2);
+	CHECK(stats.validation.count < two_pass_nodes);
+}
@@ -0,0 +1,126 @@
+#include "vuk/RenderGraph.hpp"
+
+#include <chrono>
+#include <doctest/doctest.h>
+
+using namespace vuk;
+
+namespace {
+	ImageAttachment pyramid_ia(uint32_t levels, uint32_t layers) {
+		return { .extent = { 1024, 512, 1 },
+			       .format = Format::eR16G16B16A16Sfloat,
+			       .sample_count = Samples::e1,
+			       .base_level = 0,
+			       .level_count = levels,
+			       .base_layer = 0,
+			       .layer_count = layers };
+	}
+
+	Ref field(const Value<ImageAttachment>& v, uint64_t index) {
+		return current_module->make_extract(v.get_head(), index);
+	}
+
+	Ref construct_of(const UntypedValue& v) {
+		auto def = get_def(v.get_head());
+		REQUIRE(def.holds_value());
+		REQUIRE(def->is_ref);
+		REQUIRE(def->ref.node->kind == Node::CONSTRUCT);
+		return def->ref;
+	}
+} // namespace
+
+TEST_CASE("extracting from a slice") {
+	auto img = declare_ia("img", pyramid_ia(16, 64));
+	auto level = img.mip(3);
+
+	// the extent and format are those of the sliced image
+	CHECK(*eval<uint32_t>(field(level, 0)) == 1024);
+	CHECK(*eval<uint32_t>(field(level, 1)) == 512);
+	CHECK(*eval<Format>(field(level, 3)) == Format::eR16G16B16A16Sfloat);
+	// the range is that of the slice
+	CHECK(*eval<uint32_t>(field(level, 5)) == 0);
+	CHECK(*eval<uint32_t>(field(level, 6)) == VK_REMAINING_ARRAY_LAYERS);
+	CHECK(*eval<uint32_t>(field(level, 7)) == 3);
+	CHECK(*eval<uint32_t>(field(level, 8)) == 1);
+
+	// the remainder of the slice has no single range
+	auto remainder = current_module->make_extract(Ref{ level.get_head().node, 1 }, 7);
+	auto result = eval<uint32_t>(remainder);
+	CHECK(!result.holds_value());
+	(void)result.error();
+}
+
+TEST_CASE("inferring the shape of a slice") {
+	auto img = declare_ia("img", pyramid_ia(16, 64));
+	auto dst = declare_ia("dst", ImageAttachment{ .format = Format::eR16G16B16A16Sfloat });
+	dst.same_shape_as(img.mip(2));
+
+	auto args = construct_of(dst).node->construct.args;
+	CHECK(*eval<uint32_t>(args[1]) == 1024);
+	CHECK(*eval<uint32_t>(args[2]) == 512);
+	CHECK(*eval<uint32_t>(args[8]) == 2);
+	CHECK(*eval<uint32_t>(args[9]) == 1);
+}
+
+TEST_CASE("evaluation through math on values") {
+	auto buf = declare_buf("a", Buffer{ .size = 1024, .memory_usage = MemoryUsage::eGPUonly });
+	auto size = buf.get_size() * 3 / 2 + 16;
+	CHECK(*eval<uint64_t>(size.get_head()) == 1552);
+
+	std::pmr::monotonic_buffer_resource resource;
+	ConstantEvaluator evaluator(&resource);
+	CHECK(*evaluator.eval<uint64_t>(size.get_head()) == 1552);
+	// memoized
+	CHECK(*evaluator.eval<uint64_t>(size.get_head()) == 1552);
+}
+
+// sizes of a 16 level, 64 layer pyramid of buffers, each level derived from the previous one
+// one-shot evaluation revisits every level below, the memoizing evaluator visits each node once
+TEST_CASE("bench constant evaluation of a mip pyramid" * doctest::skip()) {
+	constexpr uint32_t levels = 16;
+	constexpr uint32_t layers = 64;
+
+	auto img = declare_ia("img", pyramid_ia(levels, layers));
+	std::vector<Value<ImageAttachment>> images;
+	std::vector<Value<Buffer>> buffers;
+	auto inference_start = std::chrono::steady_clock::now();
+	for (uint32_t layer = 0; layer < layers; layer++) {
+		auto base = declare_buf("base", Buffer{ .size = 1u << 26, .memory_usage = MemoryUsage::eGPUonly });
+		auto size = base.get_size();
+		for (uint32_t level = 0; level < levels; level++) {
+			auto level_img = declare_ia("level", ImageAttachment{ .format = Format::eR16G16B16A16Sfloat });
+			level_img.same_shape_as(img.mip(level));
+			images.push_back(std::move(level_img));
+
+			size = size / 4 + 256;
+			auto buf = declare_buf("level", Buffer{ .memory_usage = MemoryUsage::eGPUonly });
+			buf.set_size(size);
+			buffers.push_back(std::move(buf));
+		}
+	}
+	auto inference_end = std::chrono::steady_clock::now();
+
+	auto one_shot_start = std::chrono::steady_clock::now();
+	uint64_t one_shot_sum = 0;
+	for (auto& buf : buffers) {
+		one_shot_sum += *eval<uint64_t>(construct_of(buf).node->construct.args[1]);
+	}
+	auto one_shot_end = std::chrono::steady_clock::now();
+
+	auto memo_start = std::chrono::steady_clock::now();
+	std::pmr::monotonic_buffer_resource resource;
+	ConstantEvaluator evaluator(&resource);
+	uint64_t memo_sum = 0;
+	for (auto& buf : buffers) {
+		memo_sum += *evaluator.eval<uint64_t>(construct_of(buf).node->construct.args[1]);
+	}
+	auto memo_end = std::chrono::steady_clock::now();
+
+	CHECK(one_shot_sum == memo_sum);
+	auto us = [](auto d) {
+		return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+	};
+	MESSAGE("shape inference of " << images.size() << " images: " << us(inference_end - inference_start) << " us");
+	MESSAGE("one-shot evaluation of " << buffers.size() << " sizes: " << us(one_shot_end - one_shot_start) << " us");
+	MESSAGE("memoized evaluation of " << buffers.size() << " sizes: " << us(memo_end - memo_start) << " us");
+}
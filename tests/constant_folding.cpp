@@ -0,0 +1,137 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+
+#include <doctest/doctest.h>
+#include <random>
+
+using namespace vuk;
+
+namespace {
+	Value<uint64_t> constant_value(uint64_t v) {
+		return { make_ext_ref(current_module->make_constant<uint64_t>(v)) };
+	}
+
+	// the node computing a value, looking through the splice holding it
+	Ref computed_by(const Value<uint64_t>& v) {
+		auto head = v.get_head();
+		return head.node->splice.src[head.index];
+	}
+
+	uint64_t value_of(const Value<uint64_t>& v) {
+		auto result = eval<uint64_t>(v.get_head());
+		REQUIRE(result.holds_value());
+		return *result;
+	}
+
+	// random expression tree over the leaves, divisors are never 0
+	Value<uint64_t> random_expression(std::mt19937& rng, std::span<Value<uint64_t>> leaves, int depth) {
+		std::uniform_int_distribution<size_t> leaf_dist(0, leaves.size() - 1);
+		if (depth == 0) {
+			return leaves[leaf_dist(rng)];
+		}
+		auto a = random_expression(rng, leaves, depth - 1);
+		std::uniform_int_distribution<uint64_t> constant_dist(1, 17);
+		switch (rng() % 6) {
+		case 0:
+			return a + random_expression(rng, leaves, depth - 1);
+		case 1:
+			return a * random_expression(rng, leaves, depth - 1);
+		case 2:
+			return a + constant_dist(rng);
+		case 3:
+			return a * constant_dist(rng);
+		case 4:
+			return a / constant_dist(rng);
+		default:
+			return a % constant_dist(rng);
+		}
+	}
+
+	struct FoldingResult {
+		std::vector<uint64_t> unfolded;
+		std::vector<uint64_t> folded;
+		CompileStats stats;
+	};
+
+	FoldingResult fold_random_expressions(std::span<Value<uint64_t>> leaves, uint32_t seed) {
+		std::mt19937 rng(seed);
+		std::vector<Value<uint64_t>> expressions;
+		// every expression is built twice, the copies are merged by value numbering
+		for (int i = 0; i < 16; i++) {
+			auto expr_seed = rng();
+			for (int copy = 0; copy < 2; copy++) {
+				std::mt19937 expr_rng(expr_seed);
+				expressions.push_back(random_expression(expr_rng, leaves, 1 + i % 5));
+			}
+		}
+
+		FoldingResult result;
+		for (auto& e : expressions) {
+			result.unfolded.push_back(value_of(e));
+		}
+
+		std::vector<std::shared_ptr<ExtNode>> heads;
+		for (auto& e : expressions) {
+			heads.push_back(e.node);
+		}
+		Compiler compiler;
+		VUK_REQUIRE_OK(compiler.compile(heads, {}));
+		result.stats = compiler.get_compile_stats();
+		for (auto& e : expressions) {
+			result.folded.push_back(value_of(e));
+		}
+		return result;
+	}
+} // namespace
+
+TEST_CASE("constant folding of owned constants gives the unfolded results") {
+	for (uint32_t seed = 0; seed < 8; seed++) {
+		std::vector<Value<uint64_t>> leaves;
+		for (uint64_t i = 0; i < 4; i++) {
+			leaves.push_back(constant_value(3 + i * 5 + seed));
+		}
+		auto result = fold_random_expressions(leaves, seed);
+		CHECK(result.folded == result.unfolded);
+		CHECK(result.stats.folded_nodes > 0);
+		CHECK(result.stats.merged_nodes > 0);
+		CHECK(result.stats.constant_folding.count >= result.stats.folded_nodes);
+		CHECK(result.stats.value_numbering.count >= result.stats.merged_nodes);
+	}
+}
+
+TEST_CASE("values read from resources are not folded") {
+	for (uint32_t seed = 0; seed < 8; seed++) {
+		auto buf = declare_buf("a", Buffer{ .size = 1024 + seed, .memory_usage = MemoryUsage::eGPUonly });
+		// the size is a constant pointing into the buffer, which is only final after allocation
+		std::vector<Value<uint64_t>> leaves = { buf.get_size(), buf.get_size() };
+		auto result = fold_random_expressions(leaves, seed);
+		CHECK(result.folded == result.unfolded);
+		CHECK(result.stats.folded_nodes == 0);
+		// the identical computations on the size are still merged
+		CHECK(result.stats.merged_nodes > 0);
+	}
+}
+
+TEST_CASE("expressions over a buffer size are not folded") {
+	auto buf = declare_buf("a", Buffer{ .size = 1024, .memory_usage = MemoryUsage::eGPUonly });
+	auto size = buf.get_size() * 2 + 16;
+
+	Compiler compiler;
+	std::shared_ptr<ExtNode> heads[] = { size.node };
+	VUK_REQUIRE_OK(compiler.compile(heads, {}));
+
+	CHECK(computed_by(size).node->kind == Node::MATH_BINARY);
+	CHECK(value_of(size) == 1024 * 2 + 16);
+}
+
+TEST_CASE("expressions over owned constants are folded into a constant") {
+	auto size = constant_value(1024) * 2 + 16;
+
+	Compiler compiler;
+	std::shared_ptr<ExtNode> heads[] = { size.node };
+	VUK_REQUIRE_OK(compiler.compile(heads, {}));
+
+	CHECK(compiler.get_compile_stats().folded_nodes == 2);
+	CHECK(computed_by(size).node->kind == Node::CONSTANT);
+	CHECK(value_of(size) == 1024 * 2 + 16);
+}
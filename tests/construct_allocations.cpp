@@ -0,0 +1,54 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+
+#include <algorithm>
+#include <doctest/doctest.h>
+
+using namespace vuk;
+
+namespace {
+	ImageAttachment color_ia() {
+		return { .image_type = ImageType::e2D,
+			       .extent = { 64, 64, 1 },
+			       .format = Format::eR8G8B8A8Unorm,
+			       .sample_count = Samples::e1,
+			       .base_level = 0,
+			       .level_count = 1,
+			       .base_layer = 0,
+			       .layer_count = 1 };
+	}
+} // namespace
+
+TEST_CASE("constructs with arguments known before execution are allocated in batches") {
+	VUK_REQUIRE_DEVICE();
+
+	std::vector<Buffer> seen;
+	auto write = make_pass("write", [&seen](CommandBuffer&, VUK_BA(Access::eTransferWrite) dst) {
+		seen.push_back(dst);
+		return dst;
+	});
+	auto draw = make_pass("draw", [](CommandBuffer&, VUK_IA(Access::eColorWrite) dst) { return dst; });
+
+	auto a = declare_buf("a", Buffer{ .size = 100, .memory_usage = MemoryUsage::eGPUonly });
+	// the size of b is derived from a, and evaluated before execution
+	auto b = declare_buf("b", Buffer{ .memory_usage = MemoryUsage::eGPUonly });
+	b.same_size(a);
+	auto c = declare_buf("c", Buffer{ .size = 3, .memory_usage = MemoryUsage::eGPUonly });
+	auto img = declare_ia("img", color_ia());
+	auto copy = declare_ia("copy", ImageAttachment{ .image_type = ImageType::e2D });
+	copy.similar_to(img);
+
+	UntypedValue values[] = { write(std::move(a)), write(std::move(b)), write(std::move(c)), draw(std::move(img)), draw(std::move(copy)) };
+	Compiler compiler;
+	VUK_REQUIRE_OK(wait_for_values_explicit(*test_context.allocator, compiler, values, {}));
+
+	auto stats = compiler.get_execute_stats();
+	CHECK(stats.batched_allocations == 5);
+	CHECK(stats.deferred_allocations == 0);
+	REQUIRE(seen.size() == 3);
+	for (auto& buf : seen) {
+		CHECK(buf.offset % test_context.runtime->min_buffer_alignment == 0);
+	}
+	// a and b
+	CHECK(std::count_if(seen.begin(), seen.end(), [](auto& buf) { return buf.size == 100; }) == 2);
+}
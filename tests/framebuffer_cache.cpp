@@ -0,0 +1,68 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+
+#include <doctest/doctest.h>
+
+using namespace vuk;
+
+namespace {
+	auto color_write = make_pass("color write", [](CommandBuffer&, VUK_IA(Access::eColorWrite) dst) { return dst; });
+
+	ImageAttachment color_ia() {
+		return { .image_type = ImageType::e2D,
+			       .usage = ImageUsageFlagBits::eColorAttachment,
+			       .extent = { 64, 64, 1 },
+			       .format = Format::eR8G8B8A8Unorm,
+			       .sample_count = Samples::e1,
+			       .view_type = ImageViewType::e2D,
+			       .base_level = 0,
+			       .level_count = 1,
+			       .base_layer = 0,
+			       .layer_count = 1 };
+	}
+
+	ExecuteStats execute_write(Compiler& compiler, const ImageAttachment& ia, Access previous_access) {
+		auto res = color_write(acquire_ia("img", ia, previous_access));
+		VUK_REQUIRE_OK(res.wait(*test_context.allocator, compiler));
+		return compiler.get_execute_stats();
+	}
+} // namespace
+
+TEST_CASE("render passes and framebuffers are found in the cache until their attachments change") {
+	VUK_REQUIRE_DEVICE();
+
+	// destroyed immediately on deallocation, so the cache hears of destroyed image views before the next execute
+	Allocator direct(test_context.runtime->get_vk_resource());
+	auto ia = color_ia();
+	auto image = allocate_image(direct, ia);
+	REQUIRE(image.holds_value());
+	ia.image = **image;
+	auto view = allocate_image_view(direct, ia);
+	REQUIRE(view.holds_value());
+	ia.image_view = **view;
+
+	Compiler compiler;
+	auto first = execute_write(compiler, ia, Access::eNone);
+	CHECK(first.render_pass_cache_misses == 1);
+	CHECK(first.render_pass_cache_hits == 0);
+	auto second = execute_write(compiler, ia, Access::eNone);
+	CHECK(second.render_pass_cache_misses == 0);
+	CHECK(second.render_pass_cache_hits == 1);
+
+	SUBCASE("a different load op and initial layout") {
+		auto stats = execute_write(compiler, ia, Access::eColorWrite);
+		CHECK(stats.render_pass_cache_misses == 1);
+		CHECK(stats.render_pass_cache_hits == 0);
+	}
+
+	SUBCASE("a destroyed image view") {
+		view->reset();
+		// may get the handle of the destroyed view back
+		auto other = allocate_image_view(direct, ia);
+		REQUIRE(other.holds_value());
+		ia.image_view = **other;
+		auto stats = execute_write(compiler, ia, Access::eNone);
+		CHECK(stats.render_pass_cache_misses == 1);
+		CHECK(stats.render_pass_cache_hits == 0);
+	}
+}
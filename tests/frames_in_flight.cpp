@@ -0,0 +1,92 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+
+#include <doctest/doctest.h>
+#include <utility>
+
+using namespace vuk;
+
+namespace {
+	// every host wait of a CountingRuntime is counted, then forwarded to the driver
+	PFN_vkWaitSemaphores forward_wait_semaphores = nullptr;
+	PFN_vkWaitForFences forward_wait_for_fences = nullptr;
+	PFN_vkQueueWaitIdle forward_queue_wait_idle = nullptr;
+	size_t host_waits = 0;
+
+	VKAPI_ATTR VkResult VKAPI_CALL counting_wait_semaphores(VkDevice device, const VkSemaphoreWaitInfo* info, uint64_t timeout) {
+		host_waits++;
+		return forward_wait_semaphores(device, info, timeout);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL counting_wait_for_fences(VkDevice device, uint32_t count, const VkFence* fences, VkBool32 wait_all, uint64_t timeout) {
+		host_waits++;
+		return forward_wait_for_fences(device, count, fences, wait_all, timeout);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL counting_queue_wait_idle(VkQueue queue) {
+		host_waits++;
+		return forward_queue_wait_idle(queue);
+	}
+
+	struct CountingRuntime {
+		std::optional<Runtime> runtime;
+		std::optional<DeviceSuperFrameResource> superframe_resource;
+
+		CountingRuntime(uint32_t frames_in_flight) {
+			FunctionPointers fps = *test_context.runtime;
+			forward_wait_semaphores = std::exchange(fps.vkWaitSemaphores, &counting_wait_semaphores);
+			forward_wait_for_fences = std::exchange(fps.vkWaitForFences, &counting_wait_for_fences);
+			forward_queue_wait_idle = std::exchange(fps.vkQueueWaitIdle, &counting_queue_wait_idle);
+			host_waits = 0;
+
+			auto family = test_context.vkbdevice.get_queue_index(vkb::QueueType::graphics).value();
+			std::vector<std::unique_ptr<Executor>> executors;
+			executors.push_back(
+			    create_vkqueue_executor(fps, test_context.vkbdevice.device, test_context.graphics_queue, family, DomainFlagBits::eGraphicsQueue));
+			executors.push_back(std::make_unique<ThisThreadExecutor>());
+			runtime.emplace(RuntimeCreateParameters{
+			    test_context.vkbinstance.instance, test_context.vkbdevice.device, test_context.vkbdevice.physical_device, std::move(executors), fps });
+			superframe_resource.emplace(*runtime, frames_in_flight);
+		}
+
+		~CountingRuntime() {
+			(void)runtime->wait_idle().holds_value();
+			superframe_resource.reset();
+			runtime.reset();
+		}
+	};
+
+	auto fill = make_pass("fill", [](CommandBuffer& cbuf, VUK_BA(Access::eTransferWrite) dst) {
+		cbuf.fill_buffer(dst, 0);
+		return dst;
+	});
+	auto copy = make_pass("copy", [](CommandBuffer& cbuf, VUK_BA(Access::eTransferRead) src, VUK_BA(Access::eTransferWrite) dst) {
+		cbuf.copy_buffer(src, dst);
+		return dst;
+	});
+} // namespace
+
+TEST_CASE("submitting frames in flight never waits on the host") {
+	VUK_REQUIRE_DEVICE();
+	constexpr uint32_t frames_in_flight = 3;
+	CountingRuntime counting(frames_in_flight);
+	auto validation_errors = test_context.validation_errors.load();
+
+	Compiler compiler;
+	for (uint32_t i = 0; i < 4 * frames_in_flight; i++) {
+		// waits for the frame submitted frames_in_flight frames ago, so its resources can be reused
+		auto& frame = counting.superframe_resource->get_next_frame();
+		Allocator frame_allocator(frame);
+
+		auto src = fill(declare_buf("src", Buffer{ .size = 1 << 20, .memory_usage = MemoryUsage::eGPUonly }));
+		auto dst = declare_buf("dst", Buffer{ .size = 1 << 20, .memory_usage = MemoryUsage::eGPUonly });
+		auto res = copy(std::move(src), std::move(dst));
+
+		auto waits_before_submit = host_waits;
+		VUK_REQUIRE_OK(res.submit(frame_allocator, compiler));
+		CHECK(host_waits == waits_before_submit);
+	}
+
+	VUK_REQUIRE_OK(counting.runtime->wait_idle());
+	CHECK(test_context.validation_errors == validation_errors);
+}
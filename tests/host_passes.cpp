@@ -0,0 +1,170 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+#include "vuk/runtime/ThreadPoolExecutor.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <doctest/doctest.h>
+#include <mutex>
+#include <thread>
+
+using namespace vuk;
+
+namespace {
+	// a second runtime on the test device, running its host passes on a thread pool
+	struct PooledRuntime {
+		std::optional<Runtime> runtime;
+		std::optional<DeviceSuperFrameResource> superframe_resource;
+		std::optional<Allocator> allocator;
+
+		PooledRuntime(size_t thread_count) {
+			FunctionPointers fps = *test_context.runtime;
+			auto graphics_queue_family_index = test_context.vkbdevice.get_queue_index(vkb::QueueType::graphics).value();
+			std::vector<std::unique_ptr<Executor>> executors;
+			executors.push_back(
+			    create_vkqueue_executor(fps, test_context.vkbdevice.device, test_context.graphics_queue, graphics_queue_family_index, DomainFlagBits::eGraphicsQueue));
+			executors.push_back(std::make_unique<ThreadPoolExecutor>(thread_count));
+			runtime.emplace(RuntimeCreateParameters{
+			    test_context.vkbinstance.instance, test_context.vkbdevice.device, test_context.vkbdevice.physical_device, std::move(executors), fps });
+			superframe_resource.emplace(*runtime, 2);
+			allocator.emplace(*superframe_resource);
+		}
+
+		~PooledRuntime() {
+			(void)runtime->wait_idle().holds_value();
+			allocator.reset();
+			superframe_resource.reset();
+			runtime.reset();
+		}
+	};
+
+	Value<Buffer> host_buf(Name name) {
+		return declare_buf(name, Buffer{ .size = 64, .memory_usage = MemoryUsage::eCPUonly });
+	}
+
+	// the passes in the order they ran
+	struct RunLog {
+		std::mutex lock;
+		std::vector<size_t> passes;
+
+		void record(size_t pass) {
+			std::lock_guard _(lock);
+			passes.push_back(pass);
+		}
+
+		size_t position(size_t pass) {
+			return std::find(passes.begin(), passes.end(), pass) - passes.begin();
+		}
+	};
+} // namespace
+
+TEST_CASE("independent host passes run concurrently on a thread pool") {
+	VUK_REQUIRE_DEVICE();
+	PooledRuntime pooled(3);
+
+	// each pass waits for the other one to start - they only both get through if they run at the same time
+	std::atomic<size_t> arrived = 0;
+	std::atomic<size_t> met = 0;
+	auto meet = [&] {
+		arrived++;
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (arrived < 2 && std::chrono::steady_clock::now() < deadline) {
+			std::this_thread::yield();
+		}
+		if (arrived >= 2) {
+			met++;
+		}
+	};
+	auto pass = make_pass(
+	    "meet",
+	    [&](CommandBuffer&, VUK_BA(Access::eHostWrite) dst) {
+		    meet();
+		    return dst;
+	    },
+	    SchedulingInfo(DomainFlagBits::eHost));
+
+	UntypedValue values[] = { pass(host_buf("a")), pass(host_buf("b")) };
+	Compiler compiler;
+	VUK_REQUIRE_OK(wait_for_values_explicit(*pooled.allocator, compiler, values, {}));
+	CHECK(met == 2);
+}
+
+TEST_CASE("host passes on a thread pool keep their order on shared resources") {
+	VUK_REQUIRE_DEVICE();
+	PooledRuntime pooled(3);
+	constexpr size_t chain_count = 8;
+	constexpr size_t chain_length = 6;
+
+	// every chain writes, reads twice and writes its own buffer again - the passes of different chains are independent
+	RunLog log;
+	std::vector<UntypedValue> values;
+	for (size_t c = 0; c < chain_count; c++) {
+		auto buf = host_buf("buf");
+		for (size_t i = 0; i < chain_length; i++) {
+			size_t id = c * chain_length + i;
+			if (i % 3 == 0) {
+				auto write = make_pass(
+				    "write",
+				    [id, &log](CommandBuffer&, VUK_BA(Access::eHostWrite) dst) {
+					    log.record(id);
+					    return dst;
+				    },
+				    SchedulingInfo(DomainFlagBits::eHost));
+				buf = write(std::move(buf));
+			} else {
+				auto read = make_pass(
+				    "read",
+				    [id, &log](CommandBuffer&, VUK_BA(Access::eHostRead) src) {
+					    log.record(id);
+					    return src;
+				    },
+				    SchedulingInfo(DomainFlagBits::eHost));
+				buf = read(std::move(buf));
+			}
+		}
+		values.push_back(std::move(buf));
+	}
+
+	Compiler compiler;
+	VUK_REQUIRE_OK(wait_for_values_explicit(*pooled.allocator, compiler, values, {}));
+	REQUIRE(log.passes.size() == chain_count * chain_length);
+	for (size_t c = 0; c < chain_count; c++) {
+		auto first = c * chain_length;
+		// the reads follow the write before them, and the next write follows both reads
+		CHECK(log.position(first) < log.position(first + 1));
+		CHECK(log.position(first) < log.position(first + 2));
+		CHECK(log.position(first + 1) < log.position(first + 3));
+		CHECK(log.position(first + 2) < log.position(first + 3));
+		CHECK(log.position(first + 3) < log.position(first + 4));
+		CHECK(log.position(first + 3) < log.position(first + 5));
+	}
+}
+
+TEST_CASE("host passes depending on device work run after it completes") {
+	VUK_REQUIRE_DEVICE();
+	PooledRuntime pooled(2);
+
+	auto fill = make_pass(
+	    "fill",
+	    [](CommandBuffer& cbuf, VUK_BA(Access::eTransferWrite) dst) {
+		    cbuf.fill_buffer(dst, 7);
+		    return dst;
+	    },
+	    SchedulingInfo(DomainFlagBits::eGraphicsQueue));
+	// host passes are deferred, so the fill has been submitted and waited on by the time this runs
+	uint32_t seen = 0;
+	auto check = make_pass(
+	    "check",
+	    [&seen](CommandBuffer&, VUK_BA(Access::eHostRead) src) {
+		    seen = *reinterpret_cast<uint32_t*>(src->mapped_ptr);
+		    return src;
+	    },
+	    SchedulingInfo(DomainFlagBits::eHost));
+
+	auto buf = declare_buf("buf", Buffer{ .size = 64, .memory_usage = MemoryUsage::eGPUtoCPU });
+	UntypedValue values[] = { check(fill(std::move(buf))) };
+	Compiler compiler;
+	VUK_REQUIRE_OK(wait_for_values_explicit(*pooled.allocator, compiler, values, {}));
+	CHECK(seen == 7);
+}
@@ -0,0 +1,78 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+
+#include <doctest/doctest.h>
+
+using namespace vuk;
+
+namespace {
+	auto transfer_write = make_pass("transfer write", [](CommandBuffer&, VUK_IA(Access::eTransferWrite) dst) { return dst; });
+	auto transfer_read = make_pass("transfer read", [](CommandBuffer&, VUK_IA(Access::eTransferRead) src) { return src; });
+	auto clear = make_pass("clear", [](CommandBuffer&, VUK_IA(Access::eClear) dst) { return dst; });
+	auto color_write = make_pass("color write", [](CommandBuffer&, VUK_IA(Access::eColorWrite) dst) { return dst; });
+	auto depth_rw = make_pass("depth rw", [](CommandBuffer&, VUK_IA(Access::eDepthStencilRW) dst) { return dst; });
+	auto compute_rw = make_pass("compute rw", [](CommandBuffer&, VUK_IA(Access::eComputeRW) dst) { return dst; });
+	auto fragment_sample = make_pass("fragment sample", [](CommandBuffer&, VUK_IA(Access::eFragmentSampled) src) { return src; });
+	auto compute_sample = make_pass("compute sample", [](CommandBuffer&, VUK_IA(Access::eComputeSampled) src) { return src; });
+
+	ImageAttachment mipped_ia() {
+		return { .extent = { 256, 256, 1 },
+			       .format = Format::eR8G8B8A8Unorm,
+			       .sample_count = Samples::e1,
+			       .base_level = 0,
+			       .level_count = 4,
+			       .base_layer = 0,
+			       .layer_count = 1 };
+	}
+
+	// declares an image, applies the passes of `use` to it and returns the usage computed for its use chain
+	template<class F>
+	ImageUsageFlags compiled_usage(F&& use) {
+		auto img = declare_ia("img", mipped_ia());
+		auto construct = get_def(img.get_head());
+		REQUIRE(construct.holds_value());
+		auto construct_node = construct->ref.node;
+		auto res = use(std::move(img));
+
+		Compiler compiler;
+		std::shared_ptr<ExtNode> heads[] = { res.node };
+		VUK_REQUIRE_OK(compiler.compile(heads, {}));
+		for (auto head : compiler.get_use_chains()) {
+			if (head->def.node == construct_node) {
+				return compiler.compute_usage(head);
+			}
+		}
+		FAIL("no use chain for the declared image");
+		return {};
+	}
+} // namespace
+
+TEST_CASE("image usage of a corpus of graphs") {
+	SUBCASE("upload and sample") {
+		auto usage = compiled_usage([](auto img) { return fragment_sample(transfer_write(std::move(img))); });
+		CHECK(usage == (ImageUsageFlagBits::eTransferDst | ImageUsageFlagBits::eSampled));
+	}
+	SUBCASE("render and read back") {
+		auto usage = compiled_usage([](auto img) { return transfer_read(color_write(std::move(img))); });
+		CHECK(usage == (ImageUsageFlagBits::eColorAttachment | ImageUsageFlagBits::eTransferSrc));
+	}
+	SUBCASE("clear, store and sample in compute") {
+		auto usage = compiled_usage([](auto img) { return compute_sample(compute_rw(clear(std::move(img)))); });
+		CHECK(usage == (ImageUsageFlagBits::eTransferDst | ImageUsageFlagBits::eStorage | ImageUsageFlagBits::eSampled));
+	}
+	SUBCASE("depth attachment") {
+		auto usage = compiled_usage([](auto img) { return depth_rw(std::move(img)); });
+		CHECK(usage == ImageUsageFlags(ImageUsageFlagBits::eDepthStencilAttachment));
+	}
+	SUBCASE("a single use") {
+		auto usage = compiled_usage([](auto img) { return transfer_write(std::move(img)); });
+		CHECK(usage == ImageUsageFlags(ImageUsageFlagBits::eTransferDst));
+	}
+	SUBCASE("uses of a slice count for the sliced image") {
+		auto usage = compiled_usage([](auto img) {
+			auto written = transfer_write(std::move(img));
+			return fragment_sample(written.mip(1));
+		});
+		CHECK(usage == (ImageUsageFlagBits::eTransferDst | ImageUsageFlagBits::eSampled));
+	}
+}
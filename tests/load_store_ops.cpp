@@ -0,0 +1,37 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+
+#include <doctest/doctest.h>
+
+using namespace vuk;
+
+namespace {
+	auto color_write = make_pass("color write", [](CommandBuffer&, VUK_IA(Access::eColorWrite) dst) { return dst; });
+	auto color_write_two = make_pass("color write two", [](CommandBuffer&, VUK_IA(Access::eColorWrite) a, VUK_IA(Access::eColorWrite) b) { return a; });
+
+	ImageAttachment layered_ia() {
+		return { .image_type = ImageType::e2D,
+			       .extent = { 64, 64, 1 },
+			       .format = Format::eR8G8B8A8Unorm,
+			       .sample_count = Samples::e1,
+			       .base_level = 0,
+			       .level_count = 1,
+			       .base_layer = 0,
+			       .layer_count = 2 };
+	}
+} // namespace
+
+TEST_CASE("loads are only avoided for undefined contents of the attachment subrange") {
+	VUK_REQUIRE_DEVICE();
+
+	auto img = declare_ia("img", layered_ia());
+	// layer 0 comes out of UNDEFINED: nothing to load
+	auto layer0 = color_write(img.layer(0));
+	// layer 0 now has contents, layer 1 comes out of UNDEFINED
+	// both are views of the same image, only the load of layer 1 can be dropped
+	auto res = color_write_two(std::move(layer0), img.layer(1));
+
+	Compiler compiler;
+	VUK_REQUIRE_OK(res.wait(*test_context.allocator, compiler));
+	CHECK(compiler.get_execute_stats().avoided_loads == 2);
+}
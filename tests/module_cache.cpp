@@ -0,0 +1,83 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+
+#include <doctest/doctest.h>
+
+using namespace vuk;
+
+namespace {
+	auto read_buf = make_pass("read", [](CommandBuffer&, VUK_BA(Access::eTransferRead) src) { return src; });
+
+	// buffers declared in modules of their own, that never change after declaration
+	struct StaticModules {
+		std::vector<std::shared_ptr<IRModule>> modules;
+		std::vector<Value<Buffer>> buffers;
+		std::vector<Value<Buffer>> padding; // held values that grow the static modules
+
+		StaticModules(size_t count, size_t padding_per_module) {
+			auto changing = current_module;
+			for (size_t i = 0; i < count; i++) {
+				current_module = modules.emplace_back(std::make_shared<IRModule>());
+				buffers.push_back(declare_buf("static", Buffer{ .size = 1024, .memory_usage = MemoryUsage::eGPUonly }));
+				for (size_t j = 0; j < padding_per_module; j++) {
+					padding.push_back(declare_buf("padding", Buffer{ .size = 1024, .memory_usage = MemoryUsage::eGPUonly }));
+				}
+			}
+			current_module = changing;
+		}
+	};
+
+	// compiles reads of every static buffer, recorded in the changing module
+	CompileStats compile_reads(Compiler& compiler, StaticModules& statics) {
+		std::vector<std::shared_ptr<ExtNode>> heads;
+		for (auto& buf : statics.buffers) {
+			heads.push_back(read_buf(buf).node);
+		}
+		VUK_REQUIRE_OK(compiler.compile(heads, {}));
+		return compiler.get_compile_stats();
+	}
+} // namespace
+
+TEST_CASE("unchanged modules are cached across compiles") {
+	constexpr size_t count = 16;
+	StaticModules statics(count, 0);
+
+	Compiler compiler;
+	auto first = compile_reads(compiler, statics);
+	CHECK(first.cached_modules == 0);
+	// only the changing module is collected and linked again
+	auto second = compile_reads(compiler, statics);
+	CHECK(second.cached_modules == count);
+}
+
+TEST_CASE("cached modules cost nothing to compile") {
+	constexpr size_t count = 16;
+	StaticModules small(count, 0);
+	StaticModules large(count, 64);
+
+	Compiler compiler;
+	(void)compile_reads(compiler, small);
+	auto small_stats = compile_reads(compiler, small);
+	(void)compile_reads(compiler, large);
+	auto large_stats = compile_reads(compiler, large);
+
+	CHECK(small_stats.cached_modules == count);
+	CHECK(large_stats.cached_modules == count);
+	// the size of the static modules does not show up in the work done on the changing module
+	CHECK(small_stats.garbage_collection.count == large_stats.garbage_collection.count);
+	CHECK(small_stats.implicit_linking.count == large_stats.implicit_linking.count);
+}
+
+TEST_CASE("cached modules are collected eventually") {
+	StaticModules statics(1, 0);
+
+	Compiler compiler;
+	size_t collected = 0;
+	for (size_t i = 0; i < IRModule::max_cached_compiles + 2; i++) {
+		auto stats = compile_reads(compiler, statics);
+		if (i > 0 && stats.cached_modules == 0) {
+			collected++;
+		}
+	}
+	CHECK(collected == 1);
+}
@@ -0,0 +1,164 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+#include "vuk/runtime/ThreadPoolExecutor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <doctest/doctest.h>
+#include <mutex>
+#include <thread>
+
+using namespace vuk;
+
+namespace {
+	// the passes in the order they were recorded, with the command buffer they were recorded into
+	struct RecordingLog {
+		struct Entry {
+			size_t pass;
+			VkCommandBuffer command_buffer;
+		};
+
+		std::mutex lock;
+		std::vector<Entry> entries;
+
+		void record(size_t pass, VkCommandBuffer command_buffer) {
+			std::lock_guard _(lock);
+			entries.push_back({ pass, command_buffer });
+		}
+	};
+
+	ImageAttachment color_ia() {
+		return { .image_type = ImageType::e2D,
+			       .extent = { 64, 64, 1 },
+			       .format = Format::eR8G8B8A8Unorm,
+			       .sample_count = Samples::e1,
+			       .base_level = 0,
+			       .level_count = 1,
+			       .base_layer = 0,
+			       .layer_count = 1 };
+	}
+
+	// stands in for the host work of recording a heavy pass
+	void spin(size_t iterations) {
+		volatile size_t sink = 0;
+		for (size_t i = 0; i < iterations; i++) {
+			sink = sink + i;
+		}
+	}
+
+	// a draw, a transfer and a run of reads per group of passes - the reads of a run need no barriers between them and share a segment
+	Result<void> execute_passes(Compiler& compiler, RecordingLog& log, size_t pass_count, size_t work, RecordingTaskRunner* task_runner) {
+		constexpr size_t image_count = 4;
+		std::vector<Value<ImageAttachment>> images;
+		for (size_t i = 0; i < image_count; i++) {
+			images.push_back(declare_ia("img", color_ia()));
+		}
+		auto buf = declare_buf("buf", Buffer{ .size = 1024, .memory_usage = MemoryUsage::eGPUonly });
+		for (size_t i = 0; i < pass_count; i++) {
+			if (i % 8 == 0) {
+				auto draw = make_pass("draw", [i, work, &log](CommandBuffer& cbuf, VUK_IA(Access::eColorWrite) dst) {
+					spin(work);
+					log.record(i, cbuf.get_underlying());
+					return dst;
+				});
+				auto& img = images[(i / 8) % image_count];
+				img = draw(std::move(img));
+			} else if (i % 8 == 1) {
+				auto transfer = make_pass("transfer", [i, work, &log](CommandBuffer& cbuf, VUK_BA(Access::eTransferWrite) dst) {
+					spin(work);
+					log.record(i, cbuf.get_underlying());
+					return dst;
+				});
+				buf = transfer(std::move(buf));
+			} else {
+				auto read = make_pass("read", [i, work, &log](CommandBuffer& cbuf, VUK_BA(Access::eTransferRead) src) {
+					spin(work);
+					log.record(i, cbuf.get_underlying());
+					return src;
+				});
+				buf = read(std::move(buf));
+			}
+		}
+
+		std::vector<UntypedValue> heads(images.begin(), images.end());
+		heads.push_back(std::move(buf));
+		RenderGraphCompileOptions options;
+		options.recording_task_runner = task_runner;
+		return wait_for_values_explicit(*test_context.allocator, compiler, heads, options);
+	}
+} // namespace
+
+TEST_CASE("recording through a task runner matches recording on the executing thread") {
+	VUK_REQUIRE_DEVICE();
+	constexpr size_t pass_count = 200;
+
+	Compiler compiler;
+	RecordingLog serial;
+	VUK_REQUIRE_OK(execute_passes(compiler, serial, pass_count, 0, nullptr));
+	auto serial_stats = compiler.get_execute_stats();
+
+	ThreadPoolExecutor runner(3);
+	RecordingLog parallel;
+	VUK_REQUIRE_OK(execute_passes(compiler, parallel, pass_count, 0, &runner));
+	auto parallel_stats = compiler.get_execute_stats();
+
+	// the same synchronization is recorded around the passes
+	CHECK(parallel_stats.barrier_flushes == serial_stats.barrier_flushes);
+	CHECK(parallel_stats.image_barriers == serial_stats.image_barriers);
+	CHECK(parallel_stats.buffer_barriers == serial_stats.buffer_barriers);
+	CHECK(parallel_stats.memory_barriers == serial_stats.memory_barriers);
+	CHECK(parallel_stats.layout_transitions.size() == serial_stats.layout_transitions.size());
+	CHECK(parallel_stats.avoided_loads == serial_stats.avoided_loads);
+	CHECK(parallel_stats.avoided_stores == serial_stats.avoided_stores);
+
+	// every pass is recorded once, and the passes of a command buffer follow each other as they do on the executing thread
+	REQUIRE(serial.entries.size() == pass_count);
+	REQUIRE(parallel.entries.size() == pass_count);
+	std::vector<size_t> position(pass_count);
+	for (size_t i = 0; i < pass_count; i++) {
+		position[serial.entries[i].pass] = i;
+	}
+	std::vector<bool> seen(pass_count);
+	size_t segments = 0;
+	for (size_t i = 0; i < pass_count; i++) {
+		auto& entry = parallel.entries[i];
+		CHECK(!seen[entry.pass]);
+		seen[entry.pass] = true;
+		auto previous = std::find_if(parallel.entries.rbegin() + (pass_count - i), parallel.entries.rend(), [&](auto& e) {
+			return e.command_buffer == entry.command_buffer;
+		});
+		if (previous == parallel.entries.rend()) {
+			segments++;
+		} else {
+			CHECK(position[entry.pass] == position[previous->pass] + 1);
+		}
+	}
+	// the reads of a run share a segment
+	CHECK(segments < pass_count);
+}
+
+// 2,000 passes with some host work each, recorded on the executing thread and through a task runner
+TEST_CASE("bench parallel recording of 2000 passes" * doctest::skip()) {
+	VUK_REQUIRE_DEVICE();
+	constexpr size_t pass_count = 2000;
+	constexpr size_t work = 20000;
+
+	Compiler compiler;
+	RecordingLog serial;
+	auto serial_start = std::chrono::steady_clock::now();
+	VUK_REQUIRE_OK(execute_passes(compiler, serial, pass_count, work, nullptr));
+	auto serial_end = std::chrono::steady_clock::now();
+
+	ThreadPoolExecutor runner(std::max(2u, std::thread::hardware_concurrency()) - 1);
+	RecordingLog parallel;
+	auto parallel_start = std::chrono::steady_clock::now();
+	VUK_REQUIRE_OK(execute_passes(compiler, parallel, pass_count, work, &runner));
+	auto parallel_end = std::chrono::steady_clock::now();
+
+	CHECK(parallel.entries.size() == serial.entries.size());
+	auto us = [](auto d) {
+		return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+	};
+	MESSAGE("recording on the executing thread: " << us(serial_end - serial_start) << " us");
+	MESSAGE("recording through " << runner.worker_count() << " workers: " << us(parallel_end - parallel_start) << " us");
+}
@@ -0,0 +1,49 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+
+#include <algorithm>
+#include <doctest/doctest.h>
+
+using namespace vuk;
+
+namespace {
+	auto write_buf = make_pass("write", [](CommandBuffer&, VUK_BA(Access::eTransferWrite) dst) { return dst; });
+	auto read_buf = make_pass("read", [](CommandBuffer&, VUK_BA(Access::eTransferRead) src) { return src; });
+	auto draw = make_pass("draw", [](CommandBuffer&, VUK_IA(Access::eColorWrite) dst) { return dst; });
+} // namespace
+
+TEST_CASE("every profiled pass gets a non-negative duration") {
+	VUK_REQUIRE_DEVICE();
+	auto& runtime = *test_context.runtime;
+	(void)runtime.retrieve_pass_timings();
+
+	auto buf = read_buf(write_buf(declare_buf("buf", Buffer{ .size = 1024, .memory_usage = MemoryUsage::eGPUonly })));
+	auto img = draw(declare_ia("img",
+	                           ImageAttachment{ .image_type = ImageType::e2D,
+	                                            .extent = { 64, 64, 1 },
+	                                            .format = Format::eR8G8B8A8Unorm,
+	                                            .sample_count = Samples::e1,
+	                                            .base_level = 0,
+	                                            .level_count = 1,
+	                                            .base_layer = 0,
+	                                            .layer_count = 1 }));
+
+	Compiler compiler;
+	runtime.set_pass_profiling(true);
+	UntypedValue values[] = { buf, img };
+	auto result = wait_for_values_explicit(*test_context.allocator, compiler, values);
+	runtime.set_pass_profiling(false);
+	VUK_REQUIRE_OK(result);
+
+	// the work has completed, so every timestamp is available without advancing frames
+	auto timings = runtime.retrieve_pass_timings();
+	for (auto name : { "write", "read", "draw" }) {
+		auto count = std::count_if(timings.begin(), timings.end(), [&](const PassTiming& t) { return t.pass_name.to_sv() == name; });
+		CHECK_MESSAGE(count == 1, name);
+	}
+	for (auto& timing : timings) {
+		CHECK(timing.duration >= 0.0);
+	}
+	// each duration is returned once
+	CHECK(runtime.retrieve_pass_timings().empty());
+}
@@ -0,0 +1,78 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+#include "vuk/vsl/Core.hpp"
+
+#include <chrono>
+#include <doctest/doctest.h>
+
+using namespace vuk;
+
+namespace {
+	constexpr uint32_t mip_count = 7;
+
+	auto sample = make_pass("sample", [](CommandBuffer&, VUK_IA(Access::eFragmentSampled) src) { return src; });
+
+	// every mip is synchronized on its own while the chain is generated, then the whole image is sampled
+	std::vector<std::shared_ptr<ExtNode>> mip_chains(size_t image_count) {
+		std::vector<std::shared_ptr<ExtNode>> heads;
+		for (size_t i = 0; i < image_count; i++) {
+			auto img = declare_ia("img",
+			                      { .image_type = ImageType::e2D,
+			                        .extent = { 64, 64, 1 },
+			                        .format = Format::eR8G8B8A8Unorm,
+			                        .sample_count = Samples::e1,
+			                        .base_level = 0,
+			                        .level_count = mip_count,
+			                        .base_layer = 0,
+			                        .layer_count = 1 });
+			img = clear_image(std::move(img), ClearColor(0.f, 0.f, 0.f, 1.f));
+			auto res = sample(generate_mips(std::move(img), 0, mip_count - 1));
+			res.release();
+			heads.push_back(res.node);
+		}
+		return heads;
+	}
+} // namespace
+
+TEST_CASE("per-mip access over many images executes without validation errors") {
+	VUK_REQUIRE_DEVICE();
+	auto validation_errors = test_context.validation_errors.load();
+
+	auto heads = mip_chains(16);
+	Compiler compiler;
+	auto erg = compiler.link(heads, {});
+	REQUIRE(erg.holds_value());
+	VUK_REQUIRE_OK(erg->execute(*test_context.allocator));
+	VUK_REQUIRE_OK(test_context.runtime->wait_idle());
+
+	auto& stats = compiler.get_execute_stats();
+	// each blit moves its source mip to TRANSFER_SRC, and the sample moves the whole image to READ_ONLY
+	CHECK(stats.image_barriers >= 16 * mip_count);
+	CHECK(test_context.validation_errors == validation_errors);
+}
+
+// 1,000 images with a mip chain each - the recorder tracks and merges the state of every mip, with execution timed apart from compilation
+TEST_CASE("bench execution of per-mip access over 1,000 images" * doctest::skip()) {
+	VUK_REQUIRE_DEVICE();
+
+	auto heads = mip_chains(1000);
+	Compiler compiler;
+	auto link_start = std::chrono::steady_clock::now();
+	auto erg = compiler.link(heads, {});
+	auto link_end = std::chrono::steady_clock::now();
+	REQUIRE(erg.holds_value());
+
+	auto execute_start = std::chrono::steady_clock::now();
+	VUK_REQUIRE_OK(erg->execute(*test_context.allocator));
+	auto execute_end = std::chrono::steady_clock::now();
+	VUK_REQUIRE_OK(test_context.runtime->wait_idle());
+
+	auto us = [](auto d) {
+		return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+	};
+	auto& stats = compiler.get_execute_stats();
+	MESSAGE("compile and link: " << us(link_end - link_start) << " us");
+	MESSAGE("execute: " << us(execute_end - execute_start) << " us");
+	MESSAGE("synchronized ranges: " << stats.synchronized_ranges);
+	MESSAGE("image barriers: " << stats.image_barriers << " (" << stats.merged_barriers << " merged, " << stats.redundant_barriers << " redundant)");
+}
@@ -0,0 +1,99 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+
+#include <doctest/doctest.h>
+
+using namespace vuk;
+
+namespace {
+	auto write_img = make_pass("write", [](CommandBuffer&, VUK_IA(Access::eTransferWrite) dst) { return dst; });
+	auto sample_img = make_pass("sample", [](CommandBuffer&, VUK_IA(Access::eFragmentSampled) src) { return src; });
+	auto copy_img = make_pass("copy", [](CommandBuffer&, VUK_IA(Access::eTransferRead) src) { return src; });
+
+	ImageAttachment color_ia() {
+		return { .extent = { 256, 256, 1 },
+			       .format = Format::eR8G8B8A8Unorm,
+			       .sample_count = Samples::e1,
+			       .base_level = 0,
+			       .level_count = 1,
+			       .base_layer = 0,
+			       .layer_count = 1 };
+	}
+
+	struct ReadLayoutResult {
+		size_t split_reads = 0;
+		size_t general_layout_fallbacks = 0;
+		size_t split_links = 0;
+	};
+
+	// one image written once, then read by `sampled` fragment shader passes and `copied` transfer passes
+	ReadLayoutResult compile_mixed_reads(ReadLayoutPolicy policy, size_t sampled, size_t copied) {
+		auto img = write_img(declare_ia("img", color_ia()));
+		std::vector<std::shared_ptr<ExtNode>> heads;
+		for (size_t i = 0; i < sampled; i++) {
+			heads.push_back(sample_img(img).node);
+		}
+		for (size_t i = 0; i < copied; i++) {
+			heads.push_back(copy_img(img).node);
+		}
+
+		Compiler compiler;
+		VUK_REQUIRE_OK(compiler.compile(heads, RenderGraphCompileOptions{ .read_layout_policy = policy }));
+
+		ReadLayoutResult result;
+		auto& stats = compiler.get_compile_stats();
+		result.split_reads = stats.split_reads;
+		result.general_layout_fallbacks = stats.general_layout_fallbacks;
+		for (auto head : compiler.get_use_chains()) {
+			for (auto link = head; link != nullptr; link = link->next) {
+				if (link->late_read_sync) {
+					CHECK(link->read_sync->layout == ImageLayout::eReadOnlyOptimalKHR);
+					CHECK(link->late_read_sync->layout == ImageLayout::eTransferSrcOptimal);
+					CHECK(link->read_split > 0);
+					result.split_links++;
+				} else if (link->read_sync) {
+					CHECK(link->read_split == 0);
+				}
+			}
+		}
+		return result;
+	}
+} // namespace
+
+TEST_CASE("merge policy reads mixed accesses in eGeneral") {
+	auto result = compile_mixed_reads(ReadLayoutPolicy::eMerge, 2, 2);
+	CHECK(result.general_layout_fallbacks == 1);
+	CHECK(result.split_reads == 0);
+	CHECK(result.split_links == 0);
+}
+
+TEST_CASE("split policy splits mixed reads into layout groups") {
+	auto result = compile_mixed_reads(ReadLayoutPolicy::eSplit, 1, 1);
+	CHECK(result.general_layout_fallbacks == 0);
+	CHECK(result.split_reads == 1);
+	CHECK(result.split_links == 1);
+}
+
+TEST_CASE("reads agreeing on a layout are never split") {
+	for (auto policy : { ReadLayoutPolicy::eMerge, ReadLayoutPolicy::eSplit, ReadLayoutPolicy::eCostModel }) {
+		auto result = compile_mixed_reads(policy, 3, 0);
+		CHECK(result.general_layout_fallbacks == 0);
+		CHECK(result.split_reads == 0);
+	}
+}
+
+TEST_CASE("cost model merges when the extra transition is not paid back") {
+	// merge: 1 transition + 2 reads in eGeneral = 2, split: 2 transitions = 2
+	auto result = compile_mixed_reads(ReadLayoutPolicy::eCostModel, 1, 1);
+	CHECK(result.general_layout_fallbacks == 1);
+	CHECK(result.split_reads == 0);
+	CHECK(result.split_links == 0);
+}
+
+TEST_CASE("cost model splits when enough reads lose compression") {
+	// merge: 1 transition + 4 reads in eGeneral = 3, split: 2 transitions = 2
+	auto result = compile_mixed_reads(ReadLayoutPolicy::eCostModel, 2, 2);
+	CHECK(result.general_layout_fallbacks == 0);
+	CHECK(result.split_reads == 1);
+	CHECK(result.split_links == 1);
+}
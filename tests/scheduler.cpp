@@ -0,0 +1,114 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <doctest/doctest.h>
+#include <iterator>
+
+using namespace vuk;
+
+namespace {
+	Value<Buffer> gpu_buf(Name name) {
+		return declare_buf(name, Buffer{ .size = 1024, .memory_usage = MemoryUsage::eGPUonly });
+	}
+
+	auto write = make_pass("write", [](CommandBuffer&, VUK_BA(Access::eTransferWrite) dst) { return dst; });
+	auto read = make_pass("read", [](CommandBuffer&, VUK_BA(Access::eTransferRead) src) { return src; });
+} // namespace
+
+TEST_CASE("the schedule runs every pass once, after the passes it depends on") {
+	VUK_REQUIRE_DEVICE();
+	constexpr size_t buffer_count = 8;
+	constexpr size_t pass_count = 240;
+
+	std::vector<size_t> ran;
+	std::vector<Value<Buffer>> bufs;
+	for (size_t b = 0; b < buffer_count; b++) {
+		bufs.push_back(gpu_buf("buf"));
+	}
+	// chains over the buffers, joined every third pass by a pass reading one buffer and writing another
+	std::vector<size_t> last_pass(buffer_count, SIZE_MAX);
+	std::vector<std::vector<size_t>> depends_on(pass_count);
+	for (size_t i = 0; i < pass_count; i++) {
+		size_t to = (i * 7) % buffer_count;
+		if (i % 3 == 0) {
+			size_t from = (to + 1 + i % (buffer_count - 1)) % buffer_count;
+			auto join = make_pass("join", [i, &ran](CommandBuffer&, VUK_BA(Access::eTransferRead) src, VUK_BA(Access::eTransferWrite) dst) {
+				ran.push_back(i);
+				return std::make_tuple(src, dst);
+			});
+			auto [src_out, dst_out] = join(std::move(bufs[from]), std::move(bufs[to]));
+			bufs[from] = std::move(src_out);
+			bufs[to] = std::move(dst_out);
+			for (auto b : { from, to }) {
+				if (last_pass[b] != SIZE_MAX) {
+					depends_on[i].push_back(last_pass[b]);
+				}
+				last_pass[b] = i;
+			}
+		} else {
+			auto step = make_pass("step", [i, &ran](CommandBuffer&, VUK_BA(Access::eTransferWrite) dst) {
+				ran.push_back(i);
+				return dst;
+			});
+			bufs[to] = step(std::move(bufs[to]));
+			if (last_pass[to] != SIZE_MAX) {
+				depends_on[i].push_back(last_pass[to]);
+			}
+			last_pass[to] = i;
+		}
+	}
+
+	std::vector<UntypedValue> values(std::make_move_iterator(bufs.begin()), std::make_move_iterator(bufs.end()));
+	Compiler compiler;
+	VUK_REQUIRE_OK(wait_for_values_explicit(*test_context.allocator, compiler, values, {}));
+
+	REQUIRE(ran.size() == pass_count);
+	std::vector<size_t> position(pass_count, SIZE_MAX);
+	for (size_t p = 0; p < ran.size(); p++) {
+		REQUIRE(position[ran[p]] == SIZE_MAX);
+		position[ran[p]] = p;
+	}
+	for (size_t i = 0; i < pass_count; i++) {
+		for (auto dep : depends_on[i]) {
+			CHECK(position[dep] < position[i]);
+		}
+	}
+}
+
+// 1,000 buffers with a chain of 48 passes each - around 50,000 nodes, with compilation timed apart from execution
+TEST_CASE("bench execution of a 50k node graph" * doctest::skip()) {
+	VUK_REQUIRE_DEVICE();
+	constexpr size_t buffer_count = 1000;
+	constexpr size_t chain_length = 48;
+
+	std::vector<std::shared_ptr<ExtNode>> heads;
+	for (size_t b = 0; b < buffer_count; b++) {
+		auto buf = gpu_buf("buf");
+		for (size_t i = 0; i < chain_length; i++) {
+			buf = i % 4 == 0 ? write(std::move(buf)) : read(std::move(buf));
+		}
+		buf.release();
+		heads.push_back(buf.node);
+	}
+
+	Compiler compiler;
+	auto link_start = std::chrono::steady_clock::now();
+	auto erg = compiler.link(heads, {});
+	auto link_end = std::chrono::steady_clock::now();
+	REQUIRE(erg.holds_value());
+	auto node_count = compiler.get_compile_stats().validation.count;
+
+	auto execute_start = std::chrono::steady_clock::now();
+	VUK_REQUIRE_OK(erg->execute(*test_context.allocator));
+	auto execute_end = std::chrono::steady_clock::now();
+	VUK_REQUIRE_OK(test_context.runtime->wait_idle());
+
+	auto us = [](auto d) {
+		return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+	};
+	MESSAGE("nodes: " << node_count);
+	MESSAGE("compile and link: " << us(link_end - link_start) << " us");
+	MESSAGE("execute: " << us(execute_end - execute_start) << " us");
+}
@@ -0,0 +1,124 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+#include "vuk/runtime/vk/VkQueueExecutor.hpp"
+
+#include <doctest/doctest.h>
+
+using namespace vuk;
+
+namespace {
+	// the semaphore waits of every submission made by the queue executors of a RecordingRuntime
+	PFN_vkQueueSubmit2KHR forward_submit = nullptr;
+	std::vector<VkSemaphoreSubmitInfoKHR> recorded_waits;
+
+	VKAPI_ATTR VkResult VKAPI_CALL recording_submit(VkQueue queue, uint32_t count, const VkSubmitInfo2KHR* submits, VkFence fence) {
+		for (uint32_t i = 0; i < count; i++) {
+			recorded_waits.insert(recorded_waits.end(), submits[i].pWaitSemaphoreInfos, submits[i].pWaitSemaphoreInfos + submits[i].waitSemaphoreInfoCount);
+		}
+		return forward_submit(queue, count, submits, fence);
+	}
+
+	// a runtime with graphics, compute and transfer domains, all submitting to the graphics queue of the test device
+	// the domains are separate timelines, so work crossing them is ordered by semaphore waits, without ownership transfers
+	struct RecordingRuntime {
+		std::optional<Runtime> runtime;
+		std::optional<DeviceSuperFrameResource> superframe_resource;
+		std::optional<Allocator> allocator;
+
+		RecordingRuntime() {
+			FunctionPointers fps = *test_context.runtime;
+			forward_submit = fps.vkQueueSubmit2KHR;
+			fps.vkQueueSubmit2KHR = &recording_submit;
+			recorded_waits.clear();
+
+			auto family = test_context.vkbdevice.get_queue_index(vkb::QueueType::graphics).value();
+			auto device = test_context.vkbdevice.device;
+			auto queue = test_context.graphics_queue;
+			std::vector<std::unique_ptr<Executor>> executors;
+			executors.push_back(create_vkqueue_executor(fps, device, queue, family, DomainFlagBits::eGraphicsQueue));
+			executors.push_back(create_vkqueue_executor(fps, device, queue, family, DomainFlagBits::eComputeQueue));
+			executors.push_back(create_vkqueue_executor(fps, device, queue, family, DomainFlagBits::eTransferQueue));
+			executors.push_back(std::make_unique<ThisThreadExecutor>());
+			runtime.emplace(
+			    RuntimeCreateParameters{ test_context.vkbinstance.instance, device, test_context.vkbdevice.physical_device, std::move(executors), fps });
+			superframe_resource.emplace(*runtime, 2);
+			allocator.emplace(*superframe_resource);
+		}
+
+		~RecordingRuntime() {
+			(void)runtime->wait_idle().holds_value();
+			allocator.reset();
+			superframe_resource.reset();
+			runtime.reset();
+		}
+
+		// the stage masks of the recorded waits on the timeline of a domain
+		std::vector<VkPipelineStageFlags2KHR> waits_on(DomainFlagBits domain) {
+			auto semaphore = static_cast<QueueExecutor*>(runtime->get_executor(domain))->get_semaphore();
+			std::vector<VkPipelineStageFlags2KHR> stages;
+			for (auto& wait : recorded_waits) {
+				if (wait.semaphore == semaphore) {
+					stages.push_back(wait.stageMask);
+				}
+			}
+			return stages;
+		}
+	};
+
+	Value<Buffer> gpu_buf(Name name) {
+		return declare_buf(name, Buffer{ .size = 1024, .memory_usage = MemoryUsage::eGPUonly });
+	}
+
+	constexpr VkPipelineStageFlags2KHR all_commands = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR;
+} // namespace
+
+TEST_CASE("async compute results are waited on at the stages of the graphics consumer") {
+	VUK_REQUIRE_DEVICE();
+	RecordingRuntime recording;
+
+	auto simulate = make_pass(
+	    "simulate", [](CommandBuffer&, VUK_BA(Access::eComputeWrite) dst) { return dst; }, SchedulingInfo(DomainFlagBits::eComputeQueue));
+	auto shade = make_pass(
+	    "shade", [](CommandBuffer&, VUK_BA(Access::eFragmentRead) src) { return src; }, SchedulingInfo(DomainFlagBits::eGraphicsQueue));
+
+	auto res = shade(simulate(gpu_buf("particles")));
+	Compiler compiler;
+	VUK_REQUIRE_OK(res.wait(*recording.allocator, compiler));
+
+	auto waits = recording.waits_on(DomainFlagBits::eComputeQueue);
+	REQUIRE(waits.size() == 1);
+	CHECK((waits[0] & VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR) != 0);
+	CHECK((waits[0] & all_commands) == 0);
+	// the barrier on the graphics queue orders after the compute shader, so the wait covers that stage as well
+	CHECK((waits[0] & ~(VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR)) == 0);
+}
+
+TEST_CASE("streamed uploads submitted earlier are waited on at the stages of their first consumer") {
+	VUK_REQUIRE_DEVICE();
+	RecordingRuntime recording;
+
+	auto upload = make_pass(
+	    "upload",
+	    [](CommandBuffer& cbuf, VUK_BA(Access::eTransferWrite) dst) {
+		    cbuf.fill_buffer(dst, 0);
+		    return dst;
+	    },
+	    SchedulingInfo(DomainFlagBits::eTransferQueue));
+	auto draw = make_pass(
+	    "draw", [](CommandBuffer&, VUK_BA(Access::eAttributeRead) vertices) { return vertices; }, SchedulingInfo(DomainFlagBits::eGraphicsQueue));
+
+	// the upload goes out on its own, before its use is known
+	auto uploaded = upload(gpu_buf("vertices"));
+	Compiler compiler;
+	VUK_REQUIRE_OK(uploaded.submit(*recording.allocator, compiler));
+	CHECK(recording.waits_on(DomainFlagBits::eTransferQueue).empty());
+
+	auto res = draw(std::move(uploaded));
+	VUK_REQUIRE_OK(res.wait(*recording.allocator, compiler));
+
+	auto waits = recording.waits_on(DomainFlagBits::eTransferQueue);
+	REQUIRE(waits.size() == 1);
+	CHECK((waits[0] & VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT_KHR) != 0);
+	CHECK((waits[0] & all_commands) == 0);
+	CHECK((waits[0] & ~(VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT_KHR | VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR)) == 0);
+}
@@ -0,0 +1,155 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+
+#include <algorithm>
+#include <doctest/doctest.h>
+
+using namespace vuk;
+
+namespace {
+	// a runtime with a graphics and a compute domain, both submitting to the graphics queue of the test device
+	struct TwoDomainRuntime {
+		std::optional<Runtime> runtime;
+		std::optional<DeviceSuperFrameResource> superframe_resource;
+		std::optional<Allocator> allocator;
+
+		TwoDomainRuntime() {
+			FunctionPointers fps = *test_context.runtime;
+			auto family = test_context.vkbdevice.get_queue_index(vkb::QueueType::graphics).value();
+			auto device = test_context.vkbdevice.device;
+			std::vector<std::unique_ptr<Executor>> executors;
+			executors.push_back(create_vkqueue_executor(fps, device, test_context.graphics_queue, family, DomainFlagBits::eGraphicsQueue));
+			executors.push_back(create_vkqueue_executor(fps, device, test_context.graphics_queue, family, DomainFlagBits::eComputeQueue));
+			executors.push_back(std::make_unique<ThisThreadExecutor>());
+			runtime.emplace(
+			    RuntimeCreateParameters{ test_context.vkbinstance.instance, device, test_context.vkbdevice.physical_device, std::move(executors), fps });
+			superframe_resource.emplace(*runtime, 2);
+			allocator.emplace(*superframe_resource);
+		}
+
+		~TwoDomainRuntime() {
+			(void)runtime->wait_idle().holds_value();
+			allocator.reset();
+			superframe_resource.reset();
+			runtime.reset();
+		}
+	};
+
+	ImageAttachment color_ia() {
+		return { .image_type = ImageType::e2D,
+			       .extent = { 64, 64, 1 },
+			       .format = Format::eR8G8B8A8Unorm,
+			       .sample_count = Samples::e1,
+			       .base_level = 0,
+			       .level_count = 1,
+			       .base_layer = 0,
+			       .layer_count = 1 };
+	}
+
+	size_t transitions(const ExecuteStats& stats, ImageLayout old_layout, ImageLayout new_layout) {
+		auto it = std::find_if(stats.layout_transitions.begin(), stats.layout_transitions.end(), [&](auto& lt) {
+			return lt.old_layout == old_layout && lt.new_layout == new_layout;
+		});
+		return it != stats.layout_transitions.end() ? it->count : 0;
+	}
+
+	const ExecuteStats::Queue* queue_stats(const ExecuteStats& stats, DomainFlagBits domain) {
+		auto it = std::find_if(stats.queues.begin(), stats.queues.end(), [&](auto& q) { return q.domain == domain; });
+		return it != stats.queues.end() ? &*it : nullptr;
+	}
+} // namespace
+
+TEST_CASE("sync stats of an image written and then sampled on one queue") {
+	VUK_REQUIRE_DEVICE();
+
+	auto write = make_pass(
+	    "write", [](CommandBuffer&, VUK_IA(Access::eTransferWrite) dst) { return dst; }, SchedulingInfo(DomainFlagBits::eGraphicsQueue));
+	auto sample = make_pass(
+	    "sample", [](CommandBuffer&, VUK_IA(Access::eFragmentSampled) src) { return src; }, SchedulingInfo(DomainFlagBits::eGraphicsQueue));
+
+	auto res = sample(write(declare_ia("img", color_ia())));
+	Compiler compiler;
+	VUK_REQUIRE_OK(res.wait(*test_context.allocator, compiler));
+	auto& stats = compiler.get_execute_stats();
+
+	// one transition before each pass, the release stays on the queue and needs none
+	CHECK(stats.barrier_flushes == 2);
+	CHECK(stats.image_barriers == 2);
+	CHECK(stats.buffer_barriers == 0);
+	CHECK(stats.memory_barriers == 0);
+	CHECK(stats.queue_ownership_transfers == 0);
+	CHECK(stats.synchronized_ranges == 2);
+	// the image is created on the host stream
+	CHECK(stats.stream_dependencies == 1);
+	CHECK(stats.layout_transitions.size() == 2);
+	CHECK(transitions(stats, ImageLayout::eUndefined, ImageLayout::eTransferDstOptimal) == 1);
+	CHECK(transitions(stats, ImageLayout::eTransferDstOptimal, ImageLayout::eReadOnlyOptimalKHR) == 1);
+
+	REQUIRE(stats.queues.size() == 1);
+	auto& graphics = stats.queues[0];
+	CHECK(graphics.domain == DomainFlagBits::eGraphicsQueue);
+	CHECK(graphics.submits == 1);
+	CHECK(graphics.command_buffers == 1);
+	CHECK(graphics.semaphore_waits == 0);
+	CHECK(graphics.semaphore_signals == 1);
+	CHECK(graphics.presentation_waits == 0);
+}
+
+TEST_CASE("sync stats of a buffer written by async compute and read on the graphics queue") {
+	VUK_REQUIRE_DEVICE();
+	TwoDomainRuntime two_domains;
+
+	auto simulate = make_pass(
+	    "simulate", [](CommandBuffer&, VUK_BA(Access::eComputeWrite) dst) { return dst; }, SchedulingInfo(DomainFlagBits::eComputeQueue));
+	auto shade = make_pass(
+	    "shade", [](CommandBuffer&, VUK_BA(Access::eFragmentRead) src) { return src; }, SchedulingInfo(DomainFlagBits::eGraphicsQueue));
+
+	auto res = shade(simulate(declare_buf("particles", Buffer{ .size = 1024, .memory_usage = MemoryUsage::eGPUonly })));
+	Compiler compiler;
+	VUK_REQUIRE_OK(res.wait(*two_domains.allocator, compiler));
+	auto& stats = compiler.get_execute_stats();
+
+	// one buffer barrier on each queue, the domains share a queue family so nothing changes ownership
+	CHECK(stats.barrier_flushes == 2);
+	CHECK(stats.buffer_barriers == 2);
+	CHECK(stats.image_barriers == 0);
+	CHECK(stats.memory_barriers == 0);
+	CHECK(stats.queue_ownership_transfers == 0);
+	CHECK(stats.layout_transitions.empty());
+	CHECK(stats.synchronized_ranges == 2);
+	// host to compute, and compute to graphics
+	CHECK(stats.stream_dependencies == 2);
+
+	// compute is submitted first, when graphics waits on it
+	REQUIRE(stats.queues.size() == 2);
+	CHECK(stats.queues[0].domain == DomainFlagBits::eComputeQueue);
+	auto compute = queue_stats(stats, DomainFlagBits::eComputeQueue);
+	auto graphics = queue_stats(stats, DomainFlagBits::eGraphicsQueue);
+	REQUIRE(compute);
+	REQUIRE(graphics);
+	CHECK(compute->submits == 1);
+	CHECK(compute->command_buffers == 1);
+	CHECK(compute->semaphore_waits == 0);
+	CHECK(compute->semaphore_signals == 1);
+	CHECK(graphics->submits == 1);
+	CHECK(graphics->command_buffers == 1);
+	CHECK(graphics->semaphore_waits == 1);
+	CHECK(graphics->semaphore_signals == 1);
+}
+
+TEST_CASE("sync stats are reset between executions") {
+	VUK_REQUIRE_DEVICE();
+
+	auto write = make_pass(
+	    "write", [](CommandBuffer&, VUK_BA(Access::eTransferWrite) dst) { return dst; }, SchedulingInfo(DomainFlagBits::eGraphicsQueue));
+	Compiler compiler;
+	for (size_t i = 0; i < 2; i++) {
+		auto res = write(declare_buf("buf", Buffer{ .size = 1024, .memory_usage = MemoryUsage::eGPUonly }));
+		VUK_REQUIRE_OK(res.wait(*test_context.allocator, compiler));
+		auto& stats = compiler.get_execute_stats();
+		CHECK(stats.barrier_flushes == 1);
+		CHECK(stats.buffer_barriers == 1);
+		REQUIRE(stats.queues.size() == 1);
+		CHECK(stats.queues[0].submits == 1);
+	}
+}
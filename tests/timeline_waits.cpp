@@ -0,0 +1,162 @@
+#include "TestContext.hpp"
+#include "vuk/SyncPoint.hpp"
+#include "vuk/runtime/vk/VkQueueExecutor.hpp"
+
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <utility>
+#include <vector>
+
+using namespace vuk;
+
+// queue executors over a stub FunctionPointers table - their timelines are plain counters, and every Vulkan call on them is counted
+namespace {
+	struct Timeline {
+		VkSemaphore semaphore;
+		uint64_t value;
+	};
+
+	std::vector<Timeline> timelines;
+	size_t counter_queries = 0;
+	size_t waits = 0;
+	std::vector<Timeline> waited; // semaphores and values of the last wait
+
+	Timeline& timeline_of(VkSemaphore semaphore) {
+		for (auto& tl : timelines) {
+			if (tl.semaphore == semaphore) {
+				return tl;
+			}
+		}
+		FAIL("not a stub semaphore");
+		return timelines.front();
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL stub_create_semaphore(VkDevice, const VkSemaphoreCreateInfo*, const VkAllocationCallbacks*, VkSemaphore* semaphore) {
+		*semaphore = (VkSemaphore)(uintptr_t)(timelines.size() + 1);
+		timelines.push_back({ *semaphore, 0 });
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL stub_destroy_semaphore(VkDevice, VkSemaphore, const VkAllocationCallbacks*) {}
+
+	VKAPI_ATTR VkResult VKAPI_CALL stub_get_semaphore_counter_value(VkDevice, VkSemaphore semaphore, uint64_t* value) {
+		counter_queries++;
+		*value = timeline_of(semaphore).value;
+		return VK_SUCCESS;
+	}
+
+	// completes the wait at once by advancing the timelines
+	VKAPI_ATTR VkResult VKAPI_CALL stub_wait_semaphores(VkDevice, const VkSemaphoreWaitInfo* info, uint64_t) {
+		waits++;
+		waited.clear();
+		for (uint32_t i = 0; i < info->semaphoreCount; i++) {
+			waited.push_back({ info->pSemaphores[i], info->pValues[i] });
+			auto& tl = timeline_of(info->pSemaphores[i]);
+			tl.value = std::max(tl.value, info->pValues[i]);
+		}
+		return VK_SUCCESS;
+	}
+
+	FunctionPointers stub_pointers() {
+		FunctionPointers fps;
+		fps.vkCreateSemaphore = &stub_create_semaphore;
+		fps.vkDestroySemaphore = &stub_destroy_semaphore;
+		fps.vkGetSemaphoreCounterValue = &stub_get_semaphore_counter_value;
+		return fps;
+	}
+
+	// routes the waits of the runtime to the stub while alive
+	struct StubWaits {
+		Runtime& runtime;
+		PFN_vkWaitSemaphores previous;
+
+		StubWaits(Runtime& runtime) : runtime(runtime), previous(std::exchange(runtime.vkWaitSemaphores, &stub_wait_semaphores)) {
+			timelines.clear();
+			counter_queries = 0;
+			waits = 0;
+			waited.clear();
+		}
+
+		~StubWaits() {
+			runtime.vkWaitSemaphores = previous;
+		}
+	};
+} // namespace
+
+TEST_CASE("sync points are waited on with one wait for the highest value of each timeline") {
+	VUK_REQUIRE_DEVICE();
+	auto& runtime = *test_context.runtime;
+	StubWaits stub(runtime);
+	auto fps = stub_pointers();
+	auto graphics = create_vkqueue_executor(fps, VK_NULL_HANDLE, VK_NULL_HANDLE, 0, DomainFlagBits::eGraphicsQueue);
+	auto transfer = create_vkqueue_executor(fps, VK_NULL_HANDLE, VK_NULL_HANDLE, 1, DomainFlagBits::eTransferQueue);
+	REQUIRE(timelines.size() == 2);
+
+	std::vector<SyncPoint> sync_points = { { graphics.get(), 3 }, { graphics.get(), 7 }, { transfer.get(), 2 }, { graphics.get(), 5 } };
+	VUK_REQUIRE_OK(runtime.wait_for_domains(sync_points));
+	CHECK(waits == 1);
+	REQUIRE(waited.size() == 2);
+	CHECK(waited[0].semaphore == timelines[0].semaphore);
+	CHECK(waited[0].value == 7);
+	CHECK(waited[1].semaphore == timelines[1].semaphore);
+	CHECK(waited[1].value == 2);
+
+	// everything waited for is known to be reached
+	VUK_REQUIRE_OK(runtime.wait_for_domains(sync_points));
+	CHECK(waits == 1);
+	auto ready = Runtime::sync_point_ready({ graphics.get(), 6 });
+	REQUIRE(ready.holds_value());
+	CHECK(*ready);
+	CHECK(counter_queries == 0);
+
+	// only the timeline that has not been observed far enough is waited on
+	sync_points.push_back({ transfer.get(), 4 });
+	VUK_REQUIRE_OK(runtime.wait_for_domains(sync_points));
+	CHECK(waits == 2);
+	REQUIRE(waited.size() == 1);
+	CHECK(waited[0].semaphore == timelines[1].semaphore);
+	CHECK(waited[0].value == 4);
+}
+
+TEST_CASE("polling a sync point queries the timeline until the value is observed") {
+	VUK_REQUIRE_DEVICE();
+	StubWaits stub(*test_context.runtime);
+	auto fps = stub_pointers();
+	auto graphics = create_vkqueue_executor(fps, VK_NULL_HANDLE, VK_NULL_HANDLE, 0, DomainFlagBits::eGraphicsQueue);
+	REQUIRE(timelines.size() == 1);
+
+	SyncPoint sync_point{ graphics.get(), 4 };
+	timelines[0].value = 1;
+	auto ready = Runtime::sync_point_ready(sync_point);
+	REQUIRE(ready.holds_value());
+	CHECK(!*ready);
+	CHECK(counter_queries == 1);
+
+	timelines[0].value = 4;
+	ready = Runtime::sync_point_ready(sync_point);
+	REQUIRE(ready.holds_value());
+	CHECK(*ready);
+	CHECK(counter_queries == 2);
+
+	// the observed value answers without a query
+	ready = Runtime::sync_point_ready(sync_point);
+	REQUIRE(ready.holds_value());
+	CHECK(*ready);
+	ready = Runtime::sync_point_ready({ graphics.get(), 2 });
+	REQUIRE(ready.holds_value());
+	CHECK(*ready);
+	CHECK(counter_queries == 2);
+}
+
+TEST_CASE("waiting on a sync point of a host executor is an error") {
+	VUK_REQUIRE_DEVICE();
+	auto& runtime = *test_context.runtime;
+	StubWaits stub(runtime);
+	auto host = runtime.get_executor(DomainFlagBits::eHost);
+	REQUIRE(host);
+
+	SyncPoint sync_point{ host, 1 };
+	auto res = runtime.wait_for_domains(std::span{ &sync_point, 1 });
+	CHECK(!res.holds_value());
+	CHECK(waits == 0);
+}
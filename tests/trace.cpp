@@ -0,0 +1,364 @@
+#include "TestContext.hpp"
+#include "vuk/RenderGraph.hpp"
+#include "vuk/Trace.hpp"
+
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <string_view>
+
+using namespace vuk;
+
+namespace {
+	// just enough JSON to check the exported trace: the whole input must be a single well-formed value
+	struct Json {
+		enum class Kind { eNull, eBool, eNumber, eString, eArray, eObject } kind = Kind::eNull;
+		bool boolean = false;
+		double number = 0;
+		std::string string;
+		std::vector<Json> array;
+		std::vector<std::pair<std::string, Json>> object;
+
+		const Json* find(std::string_view key) const {
+			for (auto& [k, v] : object) {
+				if (k == key) {
+					return &v;
+				}
+			}
+			return nullptr;
+		}
+	};
+
+	struct JsonParser {
+		std::string_view in;
+		size_t pos = 0;
+
+		bool parse(Json& out) {
+			return value(out) && (skip_ws(), pos == in.size());
+		}
+
+		void skip_ws() {
+			while (pos < in.size() && (in[pos] == ' ' || in[pos] == '\n' || in[pos] == '\r' || in[pos] == '\t')) {
+				pos++;
+			}
+		}
+
+		bool eat(char c) {
+			skip_ws();
+			if (pos < in.size() && in[pos] == c) {
+				pos++;
+				return true;
+			}
+			return false;
+		}
+
+		bool literal(std::string_view lit) {
+			if (in.substr(pos, lit.size()) != lit) {
+				return false;
+			}
+			pos += lit.size();
+			return true;
+		}
+
+		bool value(Json& out) {
+			skip_ws();
+			if (pos >= in.size()) {
+				return false;
+			}
+			switch (in[pos]) {
+			case '{':
+				return object(out);
+			case '[':
+				return array(out);
+			case '"':
+				out.kind = Json::Kind::eString;
+				return string(out.string);
+			case 't':
+				out.kind = Json::Kind::eBool;
+				out.boolean = true;
+				return literal("true");
+			case 'f':
+				out.kind = Json::Kind::eBool;
+				return literal("false");
+			case 'n':
+				return literal("null");
+			default:
+				out.kind = Json::Kind::eNumber;
+				return number(out.number);
+			}
+		}
+
+		bool object(Json& out) {
+			out.kind = Json::Kind::eObject;
+			pos++;
+			if (eat('}')) {
+				return true;
+			}
+			do {
+				std::string key;
+				Json v;
+				skip_ws();
+				if (!string(key) || !eat(':') || !value(v)) {
+					return false;
+				}
+				out.object.emplace_back(std::move(key), std::move(v));
+			} while (eat(','));
+			return eat('}');
+		}
+
+		bool array(Json& out) {
+			out.kind = Json::Kind::eArray;
+			pos++;
+			if (eat(']')) {
+				return true;
+			}
+			do {
+				if (!value(out.array.emplace_back())) {
+					return false;
+				}
+			} while (eat(','));
+			return eat(']');
+		}
+
+		bool string(std::string& out) {
+			if (pos >= in.size() || in[pos] != '"') {
+				return false;
+			}
+			pos++;
+			while (pos < in.size() && in[pos] != '"') {
+				char c = in[pos++];
+				if ((unsigned char)c < 0x20) {
+					return false;
+				}
+				if (c != '\\') {
+					out += c;
+					continue;
+				}
+				if (pos >= in.size()) {
+					return false;
+				}
+				switch (char e = in[pos++]) {
+				case '"':
+				case '\\':
+				case '/':
+					out += e;
+					break;
+				case 'n':
+					out += '\n';
+					break;
+				case 't':
+					out += '\t';
+					break;
+				case 'r':
+					out += '\r';
+					break;
+				case 'b':
+					out += '\b';
+					break;
+				case 'f':
+					out += '\f';
+					break;
+				case 'u': {
+					if (pos + 4 > in.size()) {
+						return false;
+					}
+					unsigned code = 0;
+					for (size_t i = 0; i < 4; i++) {
+						char h = in[pos++];
+						code <<= 4;
+						if (h >= '0' && h <= '9') {
+							code |= h - '0';
+						} else if (h >= 'a' && h <= 'f') {
+							code |= h - 'a' + 10;
+						} else if (h >= 'A' && h <= 'F') {
+							code |= h - 'A' + 10;
+						} else {
+							return false;
+						}
+					}
+					out += code < 0x80 ? (char)code : '?';
+					break;
+				}
+				default:
+					return false;
+				}
+			}
+			return pos++ < in.size();
+		}
+
+		bool number(double& out) {
+			auto start = pos;
+			if (pos < in.size() && in[pos] == '-') {
+				pos++;
+			}
+			auto digits = [&] {
+				auto first = pos;
+				while (pos < in.size() && in[pos] >= '0' && in[pos] <= '9') {
+					pos++;
+				}
+				return pos > first;
+			};
+			if (!digits()) {
+				return false;
+			}
+			if (pos < in.size() && in[pos] == '.') {
+				pos++;
+				if (!digits()) {
+					return false;
+				}
+			}
+			if (pos < in.size() && (in[pos] == 'e' || in[pos] == 'E')) {
+				pos++;
+				if (pos < in.size() && (in[pos] == '+' || in[pos] == '-')) {
+					pos++;
+				}
+				if (!digits()) {
+					return false;
+				}
+			}
+			out = std::stod(std::string(in.substr(start, pos - start)));
+			return true;
+		}
+	};
+
+	struct ExportedEvent {
+		std::string name;
+		std::string cat;
+		std::string ph;
+		double ts;
+		double tid;
+	};
+
+	// parses the export, checking the fields of every event
+	std::vector<ExportedEvent> parse_trace(const std::string& json) {
+		Json doc;
+		JsonParser parser{ json };
+		REQUIRE(parser.parse(doc));
+		REQUIRE(doc.kind == Json::Kind::eObject);
+		auto trace_events = doc.find("traceEvents");
+		REQUIRE(trace_events);
+		REQUIRE(trace_events->kind == Json::Kind::eArray);
+
+		std::vector<ExportedEvent> events;
+		for (auto& ev : trace_events->array) {
+			REQUIRE(ev.kind == Json::Kind::eObject);
+			auto name = ev.find("name");
+			auto cat = ev.find("cat");
+			auto ph = ev.find("ph");
+			auto ts = ev.find("ts");
+			auto pid = ev.find("pid");
+			auto tid = ev.find("tid");
+			REQUIRE((name && name->kind == Json::Kind::eString));
+			REQUIRE((cat && cat->kind == Json::Kind::eString));
+			REQUIRE((ph && ph->kind == Json::Kind::eString));
+			REQUIRE((ts && ts->kind == Json::Kind::eNumber));
+			REQUIRE((pid && pid->kind == Json::Kind::eNumber));
+			REQUIRE((tid && tid->kind == Json::Kind::eNumber));
+			CHECK((ph->string == "B" || ph->string == "E" || ph->string == "i"));
+			events.push_back({ name->string, cat->string, ph->string, ts->number, tid->number });
+		}
+		return events;
+	}
+
+	// every end closes the innermost open begin of its thread, no scope is left open, and time does not go backwards on a thread
+	void check_nesting(const std::vector<ExportedEvent>& events) {
+		struct Thread {
+			double tid;
+			double last_ts;
+			std::vector<const ExportedEvent*> open;
+		};
+		std::vector<Thread> threads;
+		for (auto& ev : events) {
+			auto it = std::find_if(threads.begin(), threads.end(), [&](auto& t) { return t.tid == ev.tid; });
+			if (it == threads.end()) {
+				it = threads.insert(threads.end(), Thread{ ev.tid, ev.ts });
+			}
+			CHECK(it->last_ts <= ev.ts);
+			it->last_ts = ev.ts;
+			if (ev.ph == "B") {
+				it->open.push_back(&ev);
+			} else if (ev.ph == "E") {
+				REQUIRE(!it->open.empty());
+				CHECK(it->open.back()->name == ev.name);
+				CHECK(it->open.back()->cat == ev.cat);
+				it->open.pop_back();
+			}
+		}
+		for (auto& thread : threads) {
+			CHECK(thread.open.empty());
+		}
+	}
+
+	bool has_category(const std::vector<ExportedEvent>& events, std::string_view cat) {
+		return std::any_of(events.begin(), events.end(), [&](auto& ev) { return ev.cat == cat; });
+	}
+
+	// tracing is global, so it is turned off however the test case ends
+	struct Tracing {
+		Tracing(size_t capacity) {
+			trace::enable(capacity);
+		}
+		~Tracing() {
+			trace::disable();
+		}
+	};
+
+	auto fill = make_pass("fill", [](CommandBuffer& cbuf, VUK_BA(Access::eTransferWrite) dst) {
+		cbuf.fill_buffer(dst, 0);
+		return dst;
+	});
+	auto copy = make_pass("copy", [](CommandBuffer& cbuf, VUK_BA(Access::eTransferRead) src, VUK_BA(Access::eTransferWrite) dst) {
+		cbuf.copy_buffer(src, dst);
+		return dst;
+	});
+} // namespace
+
+TEST_CASE("the trace of a small graph exports to well-formed, properly nested Chrome JSON") {
+	VUK_REQUIRE_DEVICE();
+	Tracing tracing(1 << 16);
+
+	auto src = fill(declare_buf("src", Buffer{ .size = 1024, .memory_usage = MemoryUsage::eGPUonly }));
+	auto res = copy(std::move(src), declare_buf("dst", Buffer{ .size = 1024, .memory_usage = MemoryUsage::eGPUonly }));
+	Compiler compiler;
+	VUK_REQUIRE_OK(res.wait(*test_context.allocator, compiler));
+	trace::disable();
+
+	auto events = parse_trace(trace::export_chrome_json());
+	REQUIRE(!events.empty());
+	check_nesting(events);
+	CHECK(has_category(events, "compile"));
+	CHECK(has_category(events, "allocation"));
+	CHECK(has_category(events, "schedule"));
+	CHECK(has_category(events, "barrier"));
+	CHECK(has_category(events, "command_buffer"));
+	CHECK(has_category(events, "submit"));
+	CHECK(has_category(events, "wait"));
+}
+
+TEST_CASE("trace names are escaped in the exported JSON") {
+	Tracing tracing(16);
+	trace::record(TracePhase::eInstant, TraceCategory::eSchedule, "a \"quoted\"\\name\nwith\tcontrol characters");
+	trace::disable();
+
+	auto events = parse_trace(trace::export_chrome_json());
+	REQUIRE(events.size() == 1);
+	CHECK(events[0].name == "a \"quoted\"\\name\nwith\tcontrol characters");
+	CHECK(events[0].ph == "i");
+}
+
+TEST_CASE("scopes cut by the ring buffer wrapping still export properly nested") {
+	Tracing tracing(8);
+	// the begins of the outer scopes are overwritten, the inner scopes are left open
+	for (size_t i = 0; i < 6; i++) {
+		trace::record(TracePhase::eBegin, TraceCategory::eCompile, "outer");
+	}
+	for (size_t i = 0; i < 6; i++) {
+		trace::record(TracePhase::eEnd, TraceCategory::eCompile, "outer");
+	}
+	trace::record(TracePhase::eBegin, TraceCategory::eSubmit, "open");
+	trace::disable();
+
+	auto events = parse_trace(trace::export_chrome_json());
+	check_nesting(events);
+	CHECK(std::count_if(events.begin(), events.end(), [](auto& ev) { return ev.ph == "B"; }) ==
+	      std::count_if(events.begin(), events.end(), [](auto& ev) { return ev.ph == "E"; }));
+}
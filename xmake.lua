@@ -17,6 +17,16 @@ option("debug_allocations")
     add_defines("VUK_DEBUG_ALLOCATIONS=1")
 option_end()
 
+option("tests")
+    set_default(false)
+    set_description("Build the vuk-tests target")
+option_end()
+
+if has_config("tests") then
+    add_requires("doctest 2.4.11")
+    add_requires("vk-bootstrap v1.3.283")
+end
+
 target("vuk")
     set_kind("static")
     add_languages("cxx20")
@@ -58,3 +68,17 @@ target("vuk")
         end
     end)
 target_end()
+
+if has_config("tests") then
+    target("vuk-tests")
+        set_kind("binary")
+        set_default(false)
+        add_languages("cxx20")
+        add_files("tests/**.cpp")
+        add_includedirs("tests/")
+        add_deps("vuk")
+        add_packages("doctest", "vk-bootstrap")
+        -- benchmarks are skipped by default, run them with: xmake run vuk-tests -ns -tc="bench*"
+        add_tests("default")
+    target_end()
+end